@@ -1,175 +1,280 @@
 #ifdef EEZ_PLATFORM_STM32
 #include "main.h"
-//#include "rtc.h"
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
 #include <stdio.h>
-#include <time.h>
+#include <chrono>
 #endif
 
+#include <atomic>
+
 #include "date_time.h"
+#include "gui/data_versions.h"
 
 namespace date_time {
 
-// leap year calulator expects year argument as years offset from 1970
-#define LEAP_YEAR(Y)                                                                               \
-    (((1970 + Y) > 0) && !((1970 + Y) % 4) && (((1970 + Y) % 100) || !((1970 + Y) % 400)))
-
 #define SECONDS_PER_MINUTE 60UL
 #define SECONDS_PER_HOUR (SECONDS_PER_MINUTE * 60)
 #define SECONDS_PER_DAY (SECONDS_PER_HOUR * 24)
 
-// API starts months from 1, this array starts from 0
-static const uint8_t monthDays[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
-
 #if defined(EEZ_PLATFORM_SIMULATOR)
 static uint32_t g_offset;
+static uint32_t g_lastTime = 0xFFFFFFFF;
 #endif
 
 DateTime g_dateTime;
 
-uint32_t makeTime(int year, int month, int day, int hour, int minute, int second) {
-	// seconds from 1970 till 1 jan 00:00:00 of the given year
-	year -= 1970;
+// odd while the wakeup interrupt is writing g_dateTime
+static volatile uint32_t g_sequence;
 
-	uint32_t seconds = year * 365 * SECONDS_PER_DAY;
+// g_dateTime read once per tick() by the GUI thread
+static DateTime g_tickDateTime;
 
-	for (int i = 0; i < year; i++) {
-		if (LEAP_YEAR(i)) {
-			seconds += SECONDS_PER_DAY; // add extra days for leap years
-		}
-	}
+// Keeps the g_dateTime accesses between the g_sequence accesses. On STM32
+// the writer is an interrupt on the same core, so only the compiler must
+// not move them; simulator threads can run on different cores.
+static inline void sequenceBarrier() {
+#if defined(EEZ_PLATFORM_STM32)
+	std::atomic_signal_fence(std::memory_order_seq_cst);
+#else
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+}
 
-	// add days for this year, months start from 1
-	for (int i = 1; i < month; i++) {
-		if ((i == 2) && LEAP_YEAR(year)) {
-			seconds += SECONDS_PER_DAY * 29;
-		}
-		else {
-			seconds += SECONDS_PER_DAY * monthDays[i - 1]; // monthDay array starts from 0
-		}
-	}
-	seconds += (day - 1) * SECONDS_PER_DAY;
-	seconds += hour * SECONDS_PER_HOUR;
-	seconds += minute * SECONDS_PER_MINUTE;
-	seconds += second;
+// Algorithms from Howard Hinnant, "chrono-Compatible Low-Level Date
+// Algorithms": years are counted from March, so the leap day is the last
+// day of the year, and split into 400-year eras of 146097 days.
+int32_t daysFromCivil(int year, int month, int day) {
+	year -= month <= 2;
+	int era = (year >= 0 ? year : year - 399) / 400;
+	unsigned yearOfEra = (unsigned)(year - era * 400);                                  // [0, 399]
+	unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; // [0, 365]
+	unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;  // [0, 146096]
+	return era * 146097 + (int32_t)dayOfEra - 719468;
+}
+
+void civilFromDays(int32_t days, int &year, int &month, int &day) {
+	days += 719468;
+	int era = (days >= 0 ? days : days - 146096) / 146097;
+	unsigned dayOfEra = (unsigned)(days - era * 146097);
+	unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	unsigned monthFromMarch = (5 * dayOfYear + 2) / 153;
+	day = (int)(dayOfYear - (153 * monthFromMarch + 2) / 5 + 1);
+	month = (int)(monthFromMarch < 10 ? monthFromMarch + 3 : monthFromMarch - 9);
+	year = (int)yearOfEra + era * 400 + (month <= 2);
+}
 
-	return seconds;
+uint32_t makeTime(int year, int month, int day, int hour, int minute, int second) {
+	return (uint32_t)daysFromCivil(year, month, day) * SECONDS_PER_DAY +
+		hour * SECONDS_PER_HOUR + minute * SECONDS_PER_MINUTE + second;
 }
 
 void breakTime(uint32_t time, int &resultYear, int &resultMonth, int &resultDay, int &resultHour,
 	int &resultMinute, int &resultSecond) {
-	// break the given time_t into time components
-	uint8_t year;
-	uint8_t month, monthLength;
-	uint32_t days;
+	uint32_t days = time / SECONDS_PER_DAY;
+	uint32_t seconds = time % SECONDS_PER_DAY;
 
-	resultSecond = time % 60;
-	time /= 60; // now it is minutes
+	resultHour = seconds / SECONDS_PER_HOUR;
+	resultMinute = seconds / SECONDS_PER_MINUTE % 60;
+	resultSecond = seconds % 60;
 
-	resultMinute = time % 60;
-	time /= 60; // now it is hours
+	civilFromDays((int32_t)days, resultYear, resultMonth, resultDay);
+}
 
-	resultHour = time % 24;
-	time /= 24; // now it is days
+static void setDateTime(const DateTime &dateTime) {
+	using namespace eez::gui;
 
-	year = 0;
-	days = 0;
-	while ((unsigned)(days += (LEAP_YEAR(year) ? 366 : 365)) <= time) {
-		year++;
+	// versions change only when the value does, see gui/data_versions.h
+	if (dateTime.year != g_dateTime.year || dateTime.month != g_dateTime.month || dateTime.day != g_dateTime.day) {
+		g_dateTime.year = dateTime.year;
+		g_dateTime.month = dateTime.month;
+		g_dateTime.day = dateTime.day;
+		data_versions::bumpVersion(data_versions::VERSION_DATE);
 	}
-	resultYear = year + 1970; // year is offset from 1970
-
-	days -= LEAP_YEAR(year) ? 366 : 365;
-	time -= days; // now it is days in this year, starting at 0
-
-	days = 0;
-	month = 0;
-	monthLength = 0;
-	for (month = 0; month < 12; ++month) {
-		if (month == 1) { // february
-			if (LEAP_YEAR(year)) {
-				monthLength = 29;
-			}
-			else {
-				monthLength = 28;
-			}
-		}
-		else {
-			monthLength = monthDays[month];
+
+	if (dateTime.hour != g_dateTime.hour || dateTime.minute != g_dateTime.minute || dateTime.second != g_dateTime.second) {
+		g_dateTime.hour = dateTime.hour;
+		g_dateTime.minute = dateTime.minute;
+		g_dateTime.second = dateTime.second;
+		data_versions::bumpVersion(data_versions::VERSION_TIME);
+	}
+}
+
+void getDateTime(DateTime &dateTime) {
+	uint32_t sequence;
+	do {
+		sequence = g_sequence;
+		sequenceBarrier();
+		dateTime = g_dateTime;
+		sequenceBarrier();
+	} while ((sequence & 1) || sequence != g_sequence);
+}
+
+const DateTime &getTickDateTime() {
+	return g_tickDateTime;
+}
+
+#if defined(EEZ_PLATFORM_STM32)
+
+// RTC runs from LSE with the reset prescalers, PREDIV_A = 127 and
+// PREDIV_S = 255, so the sub second counter counts down 256 steps.
+static const uint32_t PREDIV_S = 255;
+
+static const uint32_t LSE_TIMEOUT_MS = 5000;
+
+// as RTC_TIMEOUT_VALUE of the HAL
+static const uint32_t WUTWF_TIMEOUT_MS = 1000;
+
+static uint8_t fromBcd(uint32_t bcd) {
+	return (uint8_t)((bcd >> 4) * 10 + (bcd & 0xF));
+}
+
+static void readCalendar(DateTime &dateTime) {
+	// reading TR locks the shadow DR until DR is read
+	uint32_t tr = RTC->TR;
+	uint32_t dr = RTC->DR;
+
+	dateTime.hour = fromBcd((tr & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos);
+	dateTime.minute = fromBcd((tr & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos);
+	dateTime.second = fromBcd((tr & (RTC_TR_ST | RTC_TR_SU)) >> RTC_TR_SU_Pos);
+
+	dateTime.year = fromBcd((dr & (RTC_DR_YT | RTC_DR_YU)) >> RTC_DR_YU_Pos);
+	dateTime.month = fromBcd((dr & (RTC_DR_MT | RTC_DR_MU)) >> RTC_DR_MU_Pos);
+	dateTime.day = fromBcd((dr & (RTC_DR_DT | RTC_DR_DU)) >> RTC_DR_DU_Pos);
+}
+
+void init() {
+	// backup domain access, RTC registers are there
+	RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+	PWR->CR |= PWR_CR_DBP;
+
+	uint32_t rtcSel = RCC->BDCR & RCC_BDCR_RTCSEL;
+	if (!(RCC->BDCR & RCC_BDCR_RTCEN) || rtcSel != RCC_BDCR_RTCSEL_0) {
+		// RTCSEL can only be written once after backup domain reset, reset it
+		// when another clock is selected, as HAL_RCCEx_PeriphCLKConfig()
+		// does, calendar is lost then
+		if (rtcSel != 0 && rtcSel != RCC_BDCR_RTCSEL_0) {
+			uint32_t bdcr = RCC->BDCR & ~(RCC_BDCR_RTCSEL | RCC_BDCR_RTCEN);
+			RCC->BDCR |= RCC_BDCR_BDRST;
+			RCC->BDCR &= ~RCC_BDCR_BDRST;
+			RCC->BDCR = bdcr;
 		}
 
-		if (time >= monthLength) {
-			time -= monthLength;
+		RCC->BDCR |= RCC_BDCR_LSEON;
+		uint32_t start = HAL_GetTick();
+		while (!(RCC->BDCR & RCC_BDCR_LSERDY)) {
+			if (HAL_GetTick() - start > LSE_TIMEOUT_MS) {
+				return;
+			}
 		}
-		else {
-			break;
+		RCC->BDCR = (RCC->BDCR & ~RCC_BDCR_RTCSEL) | RCC_BDCR_RTCSEL_0 | RCC_BDCR_RTCEN;
+	}
+
+	// 1 Hz wakeup from ck_spre: WUCKSEL = 10x, WUT = 0
+	RTC->WPR = 0xCA;
+	RTC->WPR = 0x53;
+	RTC->CR &= ~RTC_CR_WUTE;
+	uint32_t start = HAL_GetTick();
+	while (!(RTC->ISR & RTC_ISR_WUTWF)) {
+		if (HAL_GetTick() - start > WUTWF_TIMEOUT_MS) {
+			RTC->WPR = 0xFF;
+			return;
 		}
 	}
+	RTC->WUTR = 0;
+	RTC->CR = (RTC->CR & ~RTC_CR_WUCKSEL) | RTC_CR_WUCKSEL_2 | RTC_CR_WUTIE | RTC_CR_WUTE;
+	RTC->WPR = 0xFF;
 
-	resultMonth = month + 1; // jan is month 1
-	resultDay = time + 1;    // day of month
-}
+	// wakeup is EXTI line 22, rising edge
+	EXTI->IMR |= EXTI_IMR_MR22;
+	EXTI->RTSR |= EXTI_RTSR_TR22;
 
-#if defined(EEZ_PLATFORM_SIMULATOR)
-uint32_t nowUtc() {
-	time_t now_time_t = time(0);
-	struct tm *now_tm = gmtime(&now_time_t);
-	return makeTime(1900 + now_tm->tm_year, now_tm->tm_mon + 1, now_tm->tm_mday,
-		now_tm->tm_hour, now_tm->tm_min, now_tm->tm_sec);
+	DateTime dateTime;
+	readCalendar(dateTime);
+	setDateTime(dateTime);
+
+	// doesn't call FreeRTOS, any priority will do
+	NVIC_SetPriority(RTC_WKUP_IRQn, 14);
+	NVIC_EnableIRQ(RTC_WKUP_IRQn);
 }
-#endif
 
-bool readTime(uint8_t &hour, uint8_t &minute, uint8_t &second, uint8_t &subSeconds) {
-#if defined(EEZ_PLATFORM_STM32)
-//	RTC_TimeTypeDef time;
-//	HAL_RTC_GetTime(&hrtc, &time, FORMAT_BIN);
-//
-//	second = time.Seconds;
-//	minute = time.Minutes;
-//	hour = time.Hours;
-//	subSeconds = time.SubSeconds;
-#endif
+extern "C" void RTC_WKUP_IRQHandler() {
+	// ISR flags are rc_w0, write the mask so other pending flags are not
+	// cleared, as __HAL_RTC_WAKEUPTIMER_CLEAR_FLAG
+	RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_INIT) | (RTC->ISR & RTC_ISR_INIT);
+	EXTI->PR = EXTI_PR_PR22;
 
-#if defined(EEZ_PLATFORM_SIMULATOR)
-	int year_, month_, day_, hour_, minute_, second_;
-	breakTime(g_offset + nowUtc(), year_, month_, day_, hour_, minute_, second_);
+	DateTime dateTime = g_dateTime;
+	readCalendar(dateTime);
 
-	hour = uint8_t(hour_);
-	minute = uint8_t(minute_);
-	second = uint8_t(second_);
-	subSeconds = 0;
-#endif
+	g_sequence = g_sequence + 1;
+	sequenceBarrier();
+	setDateTime(dateTime);
+	sequenceBarrier();
+	g_sequence = g_sequence + 1;
+}
 
-	return true;
+void tick() {
+	// Reading SSR locks the shadow TR and DR until DR is read. Read them in
+	// the documented order, SSR, TR, DR, with the wakeup interrupt held off,
+	// so it never reads the calendar while the shadow registers are locked.
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint32_t ssr = RTC->SSR;
+	(void)RTC->TR;
+	(void)RTC->DR;
+	__set_PRIMASK(primask);
+
+	uint8_t subSecond = (uint8_t)((PREDIV_S - (ssr & RTC_SSR_SS)) * 256 / (PREDIV_S + 1));
+	eez::gui::data_versions::set(eez::gui::data_versions::VERSION_SUB_SECOND, g_dateTime.subSecond, subSecond);
+
+	getDateTime(g_tickDateTime);
 }
 
-bool readDate(uint8_t &year, uint8_t &month, uint8_t &day) {
-#if defined(EEZ_PLATFORM_STM32)
-//	RTC_DateTypeDef date;
-//	HAL_RTC_GetDate(&hrtc, &date, FORMAT_BIN);
-//
-//	day = date.Date;
-//	month = date.Month;
-//	year = date.Year;
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-	int year_, month_, day_, hour_, minute_, second_;
-	breakTime(g_offset + nowUtc(), year_, month_, day_, hour_, minute_, second_);
 
-	year = uint8_t(year_ - 2000);
-	month = uint8_t(month_);
-	day = uint8_t(day_);
-#endif
-
-	return true;
+void init() {
+	tick();
 }
 
 void tick() {
-	readTime(g_dateTime.hour, g_dateTime.minute, g_dateTime.second, g_dateTime.subSecond);
-	readDate(g_dateTime.year, g_dateTime.month, g_dateTime.day);
+	using namespace std::chrono;
+	auto now = system_clock::now().time_since_epoch();
+	uint32_t milliseconds = (uint32_t)(duration_cast<std::chrono::milliseconds>(now).count() % 1000);
+	uint32_t time = g_offset + (uint32_t)duration_cast<seconds>(now).count();
+
+	// date and time once per second, as the wakeup interrupt on STM32
+	if (time != g_lastTime) {
+		g_lastTime = time;
+
+		int year, month, day, hour, minute, second;
+		breakTime(time, year, month, day, hour, minute, second);
+
+		DateTime dateTime = g_dateTime;
+		dateTime.year = uint8_t(year - 2000);
+		dateTime.month = uint8_t(month);
+		dateTime.day = uint8_t(day);
+		dateTime.hour = uint8_t(hour);
+		dateTime.minute = uint8_t(minute);
+		dateTime.second = uint8_t(second);
+
+		g_sequence = g_sequence + 1;
+		sequenceBarrier();
+		setDateTime(dateTime);
+		sequenceBarrier();
+		g_sequence = g_sequence + 1;
+	}
+
+	uint8_t subSecond = (uint8_t)(milliseconds * 256 / 1000);
+	eez::gui::data_versions::set(eez::gui::data_versions::VERSION_SUB_SECOND, g_dateTime.subSecond, subSecond);
+
+	getDateTime(g_tickDateTime);
 }
 
+#endif
+
 } // date_time
@@ -5,18 +5,42 @@
 namespace date_time {
 
 struct DateTime {
-    uint8_t year;
+    uint8_t year; // from 2000
     uint8_t month;
     uint8_t day;
 
     uint8_t hour;
     uint8_t minute;
     uint8_t second;
-    uint8_t subSecond;
+    uint8_t subSecond; // 1/256 s
 };
 
+// Snapshot of the RTC. Date and time are updated once per second, on STM32
+// from the RTC wakeup interrupt, sub second by tick().
 extern DateTime g_dateTime;
 
+// Starts the RTC from LSE if it isn't running already (calendar survives
+// reset in the backup domain) and enables the 1 Hz wakeup interrupt.
+void init();
+
 void tick();
 
+// Consistent copy of g_dateTime, fields are not torn by the wakeup
+// interrupt in the middle of the read.
+void getDateTime(DateTime &dateTime);
+
+// Copy of g_dateTime taken by the last tick(), so all widgets and flow
+// expressions of one frame see the same date and time. Only for the GUI
+// thread, which calls tick().
+const DateTime &getTickDateTime();
+
+// Days since 1970-01-01, proleptic Gregorian calendar, constant time.
+int32_t daysFromCivil(int year, int month, int day);
+void civilFromDays(int32_t days, int &year, int &month, int &day);
+
+// Seconds since 1970-01-01 00:00:00, for 1970 to 2106-02-07 06:28:15.
+uint32_t makeTime(int year, int month, int day, int hour, int minute, int second);
+void breakTime(uint32_t time, int &resultYear, int &resultMonth, int &resultDay, int &resultHour,
+    int &resultMinute, int &resultSecond);
+
 }
\ No newline at end of file
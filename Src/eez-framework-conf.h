@@ -13,8 +13,8 @@ static const uint32_t DISPLAY_WIDTH = 1000;
 static const uint32_t DISPLAY_HEIGHT = 680;
 static const uint32_t DISPLAY_BPP = 32;  // RGBA8888
 
-static const char *TITLE = "STM32F469I-DISCO Template";
-static const char *ICON = "icon.png";
+static const char *const TITLE = "STM32F469I-DISCO Template";
+static const char *const ICON = "icon.png";
 #endif
 
 
@@ -39,4 +39,103 @@ static const uint32_t GUI_STATE_BUFFER_SIZE = 64 * 1024;
 static const uint32_t GUI_STATE_BUFFER_SIZE = 128 * 1024;
 #endif
 
-#define OPTION_KEYPAD 1
\ No newline at end of file
+#define OPTION_KEYPAD 1
+
+// Reference uncompressed assets in place from memory-mapped QSPI flash
+// instead of decompressing assets[] to RAM, see gui/assets_xip.h
+#define OPTION_ASSETS_XIP 0
+
+// Decompress block compressed assets on first use instead of at boot, see
+// gui/lazy_assets.h. Simulator only, on the target all blocks would be
+// decompressed at boot. Resident size must hold the blocks used by one
+// frame, otherwise they are decompressed again on every frame.
+#define OPTION_LAZY_ASSETS 0
+#if defined(EEZ_PLATFORM_SIMULATOR)
+static const uint32_t LAZY_ASSETS_MAX_RESIDENT_SIZE = 4 * 1024 * 1024;
+#endif
+
+// Use assets from gui/document_bitmaps.cpp (tools/assets_bitmap_gen) with
+// bitmaps in the frame buffer format, see gui/bitmap_format.h. RGB565_A8
+// and RLE bitmaps are drawn only through the display list.
+#define OPTION_NATIVE_BITMAPS 0
+
+// Prefer assets file from the SD card over the built-in assets, see
+// gui/sd_assets.h. Block buffer must hold the largest compressed block.
+#define OPTION_SD_ASSETS 0
+#if defined(EEZ_PLATFORM_STM32)
+static const uint32_t SD_ASSETS_CACHE_SECTORS = 8;
+static const uint32_t SD_ASSETS_MAX_BLOCKS = 64;
+static const uint32_t SD_ASSETS_BLOCK_BUFFER_SIZE = 9 * 1024;
+#endif
+#if defined(EEZ_PLATFORM_SIMULATOR)
+static const uint32_t SD_ASSETS_CACHE_SECTORS = 32;
+static const uint32_t SD_ASSETS_MAX_BLOCKS = 4096;
+static const uint32_t SD_ASSETS_BLOCK_BUFFER_SIZE = 64 * 1024;
+#endif
+
+// display list (gui/display_list.cpp), DISPLAY_LIST_MAX_WIDGETS must be power of 2
+#if defined(EEZ_PLATFORM_STM32)
+static const uint32_t DISPLAY_LIST_MAX_COMMANDS = 512;
+static const uint32_t DISPLAY_LIST_MAX_WIDGETS = 128;
+static const uint32_t DISPLAY_LIST_TEXT_POOL_SIZE = 2 * 1024;
+#endif
+#if defined(EEZ_PLATFORM_SIMULATOR)
+static const uint32_t DISPLAY_LIST_MAX_COMMANDS = 4096;
+static const uint32_t DISPLAY_LIST_MAX_WIDGETS = 1024;
+static const uint32_t DISPLAY_LIST_TEXT_POOL_SIZE = 16 * 1024;
+#endif
+// more damaged areas in a frame are merged, frame buffer is drawn into again
+// after DISPLAY_LIST_BUFFER_AGE frames (2 for double buffering)
+static const uint32_t DISPLAY_LIST_MAX_DAMAGE_RECTS = 8;
+static const uint32_t DISPLAY_LIST_BUFFER_AGE = 2;
+
+// anti-aliased corner masks for the display list (gui/shape_mask_cache.cpp),
+// must not be in CCM RAM
+#if defined(EEZ_PLATFORM_STM32)
+static const uint32_t SHAPE_MASK_CACHE_SIZE = 16 * 1024;
+#endif
+#if defined(EEZ_PLATFORM_SIMULATOR)
+static const uint32_t SHAPE_MASK_CACHE_SIZE = 64 * 1024;
+#endif
+
+// text layout cache (gui/text_layout_cache.cpp)
+static const uint32_t TEXT_LAYOUT_CACHE_SIZE = 8 * 1024;
+static const uint32_t TEXT_LAYOUT_CACHE_MAX_ENTRIES = 32;
+
+// Evaluate data of this tree (temperature) in one pass per frame, see
+// gui/data_batch.h. Slot index is uint8_t, DATA_BATCH_MAX_VALUES < 255.
+#define OPTION_DATA_BATCH 0
+static const uint32_t DATA_BATCH_MAX_VALUES = 64;
+static const uint32_t DATA_BATCH_MAX_DATA_ID = 256;
+
+// Link styles from gui/document_styles.cpp (tools/style_table_gen) with
+// colors resolved for every theme, see gui/style_table.h. The widgets of
+// eez-framework don't look styles up in it.
+#define OPTION_STYLE_TABLE 0
+
+// Per component timing of the flow runtime, see flow/profiler.h. Simulator
+// profiles when EEZ_FLOW_PROFILE names the dump file, STM32 dumps over serial.
+#define OPTION_FLOW_PROFILER 0
+static const uint32_t FLOW_PROFILER_MAX_NODES = 256; // power of 2
+static const uint32_t FLOW_PROFILER_MAX_DEPTH = 16;
+static const uint32_t FLOW_PROFILER_MAX_QUEUED = 128; // power of 2
+static const uint32_t FLOW_PROFILER_DUMP_INTERVAL_MS = 10000;
+
+// Flow expressions compiled to C++ by tools/flow_expr_gen, see
+// flow/compiled_expressions.h. Only for tools/flow_expr_bench, eez-framework
+// has no hook to evaluate a property with compiled code, so the firmware
+// still interprets every expression.
+#define OPTION_COMPILED_EXPRESSIONS 0
+
+// Delay and Animate deadlines in a hierarchical timing wheel, see
+// flow/timer_wheel.h.
+#define OPTION_FLOW_TIMER_WHEEL 0
+
+// Leaves the flow queue for the next frame once the components of a frame
+// took the time budget, and reports frames and components which take
+// longer, see flow/tick_budget.h.
+#define OPTION_FLOW_TICK_BUDGET 0
+static const uint32_t FLOW_TICK_BUDGET_US = 4000;
+static const uint32_t FLOW_TICK_BUDGET_MAX_COMPONENTS = 32;
+static const uint32_t FLOW_TICK_BUDGET_MAX_DEFERRED = 64;
+static const uint32_t FLOW_TICK_BUDGET_REPORT_INTERVAL_MS = 10000;
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef EEZ_PLATFORM_STM32
@@ -28,17 +29,86 @@
 #include "date_time.h"
 #include "firmware.h"
 #include "tasks.h"
+#include "gui/assets_xip.h"
+#include "gui/data_batch.h"
+#include "gui/lazy_assets.h"
+#include "gui/sd_assets.h"
 #include "gui/hooks.h"
 #include "flow/hooks.h"
+#include "flow/profiler.h"
+#include "flow/tick_budget.h"
+#include "flow/timer_wheel.h"
 
 TouchScreenCalibrationParams g_touchScreenCalibrationParams;
 
+#if OPTION_COMPILED_EXPRESSIONS
+#error "OPTION_COMPILED_EXPRESSIONS is only for tools/flow_expr_bench, see flow/compiled_expressions.h"
+#endif
+
+#if OPTION_LAZY_ASSETS
+#if !defined(EEZ_PLATFORM_SIMULATOR)
+#error "OPTION_LAZY_ASSETS is only for the simulator, see gui/lazy_assets.h"
+#endif
+namespace eez {
+namespace gui {
+// generated by Src/tools/assets_lazy_gen
+extern const uint8_t block_assets[];
+extern const uint32_t block_assets_size;
+} // namespace gui
+} // namespace eez
+#endif
+
+#if OPTION_NATIVE_BITMAPS
+namespace eez {
+namespace gui {
+// generated by Src/tools/assets_bitmap_gen
+extern const uint8_t native_bitmap_assets[];
+extern const uint32_t native_bitmap_assets_size;
+} // namespace gui
+} // namespace eez
+#endif
+
 void LCD_init();
 
 float g_temperature = 24.0f;
 
 using namespace eez;
 
+static bool loadAssets() {
+#if OPTION_SD_ASSETS
+    eez::gui::g_mainAssets = (eez::gui::Assets *)eez::gui::sd_assets::load(
+        eez::gui::sd_assets::getDefaultFilePath(),
+        eez::DECOMPRESSED_ASSETS_START_ADDRESS, eez::MAX_DECOMPRESSED_ASSETS_SIZE);
+    if (eez::gui::g_mainAssets) {
+        eez::gui::g_isMainAssetsLoaded = true;
+        DebugTrace("Assets loaded from SD card.\n");
+        return true;
+    }
+    DebugTrace("No valid assets on SD card, using built-in assets.\n");
+#endif
+
+#if OPTION_ASSETS_XIP
+    if (!eez::gui::assets_xip::loadMainAssets()) {
+        DebugTrace("Program XIP assets to QSPI flash.\n");
+        return false;
+    }
+#elif OPTION_LAZY_ASSETS
+    eez::gui::g_mainAssets = (eez::gui::Assets *)eez::gui::lazy_assets::load(
+        eez::gui::block_assets, eez::gui::block_assets_size,
+        eez::DECOMPRESSED_ASSETS_START_ADDRESS, eez::MAX_DECOMPRESSED_ASSETS_SIZE);
+    if (!eez::gui::g_mainAssets) {
+        DebugTrace("Block compressed assets are not valid.\n");
+        return false;
+    }
+    eez::gui::g_isMainAssetsLoaded = true;
+#elif OPTION_NATIVE_BITMAPS
+    eez::gui::loadMainAssets(eez::gui::native_bitmap_assets, eez::gui::native_bitmap_assets_size);
+#else
+    eez::gui::loadMainAssets(eez::gui::assets, sizeof(eez::gui::assets));
+#endif
+    return true;
+}
+
 #if defined(__EMSCRIPTEN__)
 EM_PORT_API(void) init() {
 #else
@@ -47,7 +117,15 @@ extern "C" void init() {
     LCD_init();
 
     eez::initAssetsMemory();
-    eez::gui::loadMainAssets(eez::gui::assets, sizeof(eez::gui::assets));
+    if (!loadAssets()) {
+        // without assets there is nothing to show, don't leave a black screen
+        DebugTrace("Assets not loaded, firmware halted.\n");
+#if defined(EEZ_PLATFORM_STM32)
+        Error_Handler();
+#else
+        exit(EXIT_FAILURE);
+#endif
+    }
     eez::initOtherMemory();
     eez::initAllocHeap(eez::ALLOC_BUFFER, eez::ALLOC_BUFFER_SIZE);
 
@@ -57,8 +135,22 @@ extern "C" void init() {
     eez::initLowPriorityMessageQueue();
     eez::startLowPriorityThread();
 
+	date_time::init();
+
 	flow::initHooks();
 
+#if OPTION_FLOW_PROFILER
+	flow::profiler::init();
+#endif
+
+#if OPTION_FLOW_TICK_BUDGET
+	flow::tick_budget::init();
+#endif
+
+#if OPTION_FLOW_TIMER_WHEEL
+	flow::timer_wheel::init(millis());
+#endif
+
 	//gui::display::g_calcFpsEnabled = true;
 	//gui::display::g_drawFpsGraphEnabled = true;
 
@@ -68,6 +160,12 @@ extern "C" void init() {
 
 	gui::display::turnOn();
 	gui::initHooks();
+
+#if OPTION_DATA_BATCH
+	// native variable read by flow expressions on the main page
+	gui::data_batch::addDataId(DATA_ID_TEMPERATURE);
+#endif
+
 	gui::startThread();
 
     DebugTrace("Firmware init. is done.\n");
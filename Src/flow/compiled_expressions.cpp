@@ -0,0 +1,40 @@
+#include "eez-framework-conf.h"
+
+#if OPTION_COMPILED_EXPRESSIONS
+
+#include "compiled_expressions.h"
+
+namespace eez {
+namespace flow {
+namespace compiled_expressions {
+
+Stats g_stats;
+
+bool evaluate(int flowIndex, int componentIndex, int propertyIndex, const Context &context, Value &result) {
+    uint32_t key = makeKey(flowIndex, componentIndex, propertyIndex);
+
+    uint32_t low = 0;
+    uint32_t high = g_numExpressions;
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        if (g_expressions[middle].key < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    if (low < g_numExpressions && g_expressions[low].key == key && g_expressions[low].func(context, result)) {
+        g_stats.compiled++;
+        return true;
+    }
+
+    g_stats.interpreted++;
+    return false;
+}
+
+} // namespace compiled_expressions
+} // namespace flow
+} // namespace eez
+
+#endif // OPTION_COMPILED_EXPRESSIONS
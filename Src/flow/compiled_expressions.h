@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+
+// tools/flow_value_model.h models eez::Value to run this code on host
+#if !defined(FLOW_VALUE_MODEL)
+#include <eez/core/value.h>
+#endif
+
+namespace eez {
+namespace flow {
+namespace compiled_expressions {
+
+// Flow expressions translated to C++ by tools/flow_expr_gen, enabled with
+// OPTION_COMPILED_EXPRESSIONS.
+//
+// Not part of the firmware, which gains nothing from it: eez-framework
+// evaluates component properties with its interpreter and has no hook to
+// call evaluate() first, so only tools/flow_expr_bench builds the
+// generated code, to measure it against an interpreter. In the demo project 3 of the 20 expressions with
+// operations compile, the others use strings, Flow.* or Date.* operations.
+//
+// Each function is specialized for the types the variables it reads are
+// declared with (int, float, double or boolean). It checks these types
+// first and returns false if one doesn't match, or on division by zero, so
+// the interpreter evaluates the expression and reports errors as before.
+// Expressions with operations that have no native translation (strings,
+// arrays, Flow.* and Date.* functions, ...) aren't compiled at all.
+
+struct Context {
+    const Value *localVariables;  // of the flow state
+    const Value *globalVariables; // flow global variables, not native ones
+    const void *flowDefinition;   // for getConstant()
+};
+
+typedef bool (*ExpressionFunc)(const Context &context, Value &result);
+
+struct Expression {
+    uint32_t key; // makeKey()
+    ExpressionFunc func;
+};
+
+inline uint32_t makeKey(int flowIndex, int componentIndex, int propertyIndex) {
+    return ((uint32_t)flowIndex << 24) | ((uint32_t)componentIndex << 8) | (uint32_t)propertyIndex;
+}
+
+// generated, sorted by key
+extern const uint32_t g_numExpressions;
+extern const Expression g_expressions[];
+
+// False if the interpreter has to evaluate the property.
+bool evaluate(int flowIndex, int componentIndex, int propertyIndex, const Context &context, Value &result);
+
+// Constant of the flow definition, used for constants which aren't
+// numbers. Defined by the tool.
+const Value &getConstant(const Context &context, uint16_t constantIndex);
+
+// Defined by the tool.
+void getNativeVariable(int16_t dataId, Value &value);
+
+struct Stats {
+    uint32_t compiled;    // evaluated by the generated code
+    uint32_t interpreted; // not compiled or type check failed
+};
+
+extern Stats g_stats;
+
+} // namespace compiled_expressions
+} // namespace flow
+} // namespace eez
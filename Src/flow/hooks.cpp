@@ -1,12 +1,20 @@
 #include <assert.h>
+#include <math.h>
 
 #include <eez/conf-internal.h>
 
+#include <eez/flow/components.h>
 #include <eez/flow/flow.h>
 #include <eez/flow/hooks.h>
+#include <eez/flow/private.h>
+
+#include "eez-framework-conf.h"
 
 #include "../gui/app_context.h"
 #include "../gui/keypad.h"
+#include "profiler.h"
+#include "tick_budget.h"
+#include "timer_wheel.h"
 
 namespace eez {
 namespace flow {
@@ -25,9 +33,367 @@ void showKeypad(Value label, Value initialValue, Value min, Value max, Unit unit
 	eez::gui::startNumericKeypad(&g_deviceAppContext, label.getString(), initialValue, options, onOk, nullptr, onCancel);
 }
 
+#if OPTION_FLOW_TIMER_WHEEL
+
+struct DelayExecutionState : public ComponenentExecutionState {
+	timer_wheel::Timer timer {};
+	FlowState *flowState;
+	unsigned componentIndex;
+	bool isExpired = false;
+
+	// also when the flow state is freed before the delay ends
+	~DelayExecutionState() {
+		timer_wheel::stop(timer);
+	}
+};
+
+static void onDelayExpired(void *param) {
+	auto delayExecutionState = (DelayExecutionState *)param;
+	delayExecutionState->isExpired = true;
+	if (!addToQueue(delayExecutionState->flowState, delayExecutionState->componentIndex, -1, -1, -1, false)) {
+		throwError(delayExecutionState->flowState, delayExecutionState->componentIndex, "Execution queue is full\n");
+	}
+}
+
+// Executed once to start the timer and once more when it has expired,
+// instead of on every tick until then.
+static void executeDelayComponentWithTimer(FlowState *flowState, unsigned componentIndex) {
+	auto delayExecutionState = (DelayExecutionState *)flowState->componenentExecutionStates[componentIndex];
+	if (delayExecutionState) {
+		// the Delay of eez-framework also ignores input while it waits
+		if (delayExecutionState->isExpired) {
+			deallocateComponentExecutionState(flowState, componentIndex);
+			propagateValueThroughSeqout(flowState, componentIndex);
+		}
+		return;
+	}
+
+	Value value;
+	if (!evalProperty(flowState, componentIndex, DELAY_ACTION_COMPONENT_PROPERTY_MILLISECONDS, value, "Failed to evaluate Milliseconds in Delay")) {
+		return;
+	}
+
+	double milliseconds = value.toDouble();
+	if (isnan(milliseconds)) {
+		throwError(flowState, componentIndex, "Invalid Milliseconds value in Delay\n");
+		return;
+	}
+
+	delayExecutionState = allocateComponentExecutionState<DelayExecutionState>(flowState, componentIndex);
+	delayExecutionState->flowState = flowState;
+	delayExecutionState->componentIndex = componentIndex;
+	timer_wheel::start(delayExecutionState->timer, millis() + (milliseconds > 0 ? (uint32_t)floor(milliseconds) : 0),
+		onDelayExpired, delayExecutionState);
+}
+
+struct AnimateExecutionState : public ComponenentExecutionState {
+	timer_wheel::Timer timer {};
+	FlowState *flowState;
+	unsigned componentIndex;
+	float from;
+	float to;
+	float speed;
+	uint32_t startTime;
+	bool isFrame = false;
+
+	~AnimateExecutionState() {
+		timer_wheel::stop(timer);
+	}
+};
+
+static void onAnimateFrame(void *param) {
+	auto animateExecutionState = (AnimateExecutionState *)param;
+	animateExecutionState->isFrame = true;
+	if (!addToQueue(animateExecutionState->flowState, animateExecutionState->componentIndex, -1, -1, -1, false)) {
+		throwError(animateExecutionState->flowState, animateExecutionState->componentIndex, "Execution queue is full\n");
+	}
+}
+
+// Moves the timeline once per advance() of the wheel, i.e. once per frame,
+// instead of staying in the flow queue and executing on every tick.
+static void executeAnimateComponentWithTimer(FlowState *flowState, unsigned componentIndex) {
+	auto animateExecutionState = (AnimateExecutionState *)flowState->componenentExecutionStates[componentIndex];
+	if (animateExecutionState) {
+		// input while the timeline moves is ignored, as in Delay
+		if (!animateExecutionState->isFrame) {
+			return;
+		}
+		animateExecutionState->isFrame = false;
+
+		float distance = animateExecutionState->speed * (millis() - animateExecutionState->startTime) / 1000.0f;
+		float position;
+		if (animateExecutionState->from < animateExecutionState->to) {
+			position = animateExecutionState->from + distance;
+			if (position >= animateExecutionState->to) {
+				position = animateExecutionState->to;
+			}
+		} else {
+			position = animateExecutionState->from - distance;
+			if (position <= animateExecutionState->to) {
+				position = animateExecutionState->to;
+			}
+		}
+
+		flowState->timelinePosition = position;
+		onFlowStateTimelineChanged(flowState);
+
+		if (position == animateExecutionState->to) {
+			deallocateComponentExecutionState(flowState, componentIndex);
+			propagateValueThroughSeqout(flowState, componentIndex);
+		} else {
+			timer_wheel::start(animateExecutionState->timer, millis() + 1, onAnimateFrame, animateExecutionState);
+		}
+		return;
+	}
+
+	Value fromValue;
+	if (!evalProperty(flowState, componentIndex, ANIMATE_ACTION_COMPONENT_PROPERTY_FROM, fromValue, "Failed to evaluate From in Animate")) {
+		return;
+	}
+
+	Value toValue;
+	if (!evalProperty(flowState, componentIndex, ANIMATE_ACTION_COMPONENT_PROPERTY_TO, toValue, "Failed to evaluate To in Animate")) {
+		return;
+	}
+
+	Value speedValue;
+	if (!evalProperty(flowState, componentIndex, ANIMATE_ACTION_COMPONENT_PROPERTY_SPEED, speedValue, "Failed to evaluate Speed in Animate")) {
+		return;
+	}
+
+	float from = fromValue.toFloat();
+	float to = toValue.toFloat();
+	float speed = speedValue.toFloat();
+
+	if (speed == 0 || from == to) {
+		flowState->timelinePosition = to;
+		onFlowStateTimelineChanged(flowState);
+		propagateValueThroughSeqout(flowState, componentIndex);
+		return;
+	}
+
+	animateExecutionState = allocateComponentExecutionState<AnimateExecutionState>(flowState, componentIndex);
+	animateExecutionState->flowState = flowState;
+	animateExecutionState->componentIndex = componentIndex;
+	animateExecutionState->from = from;
+	animateExecutionState->to = to;
+	animateExecutionState->speed = fabsf(speed);
+	animateExecutionState->startTime = millis();
+
+	flowState->timelinePosition = from;
+	onFlowStateTimelineChanged(flowState);
+
+	timer_wheel::start(animateExecutionState->timer, millis() + 1, onAnimateFrame, animateExecutionState);
+}
+
+#endif
+
+#if OPTION_FLOW_TICK_BUDGET
+
+struct DeferredExecutionState;
+
+// in the order of deferral
+static DeferredExecutionState *g_firstDeferred;
+static DeferredExecutionState *g_lastDeferred;
+static uint32_t g_numDeferred;
+
+struct DeferredExecutionState : public ComponenentExecutionState {
+	DeferredExecutionState *prev = nullptr;
+	DeferredExecutionState *next = nullptr;
+	FlowState *flowState;
+	unsigned componentIndex;
+	uint32_t numExecutions = 1;
+
+	// also when the flow state is freed before the next frame
+	~DeferredExecutionState() {
+		(prev ? prev->next : g_firstDeferred) = next;
+		(next ? next->prev : g_lastDeferred) = prev;
+		g_numDeferred--;
+	}
+};
+
+static DeferredExecutionState *findDeferred(ComponenentExecutionState *executionState) {
+	for (DeferredExecutionState *deferred = g_firstDeferred; deferred; deferred = deferred->next) {
+		if (deferred == executionState) {
+			return deferred;
+		}
+	}
+	return nullptr;
+}
+
+// True if the component is left for the next frame instead of executed
+// now, see flow/tick_budget.h. A component taken from the queue again
+// while it is deferred is executed once more in the next frame.
+static bool deferComponent(FlowState *flowState, unsigned componentIndex, uint16_t componentType) {
+	auto executionState = flowState->componenentExecutionStates[componentIndex];
+	if (executionState) {
+		auto deferred = findDeferred(executionState);
+		if (!deferred) {
+			// in the middle of its work
+			return false;
+		}
+		deferred->numExecutions++;
+		tick_budget::componentDeferred();
+		return true;
+	}
+
+	if (componentType == COMPONENT_TYPE_WATCH_VARIABLE_ACTION || !tick_budget::isSpent()) {
+		return false;
+	}
+
+	if (g_numDeferred == FLOW_TICK_BUDGET_MAX_DEFERRED) {
+		tick_budget::componentNotDeferred();
+		return false;
+	}
+
+	auto deferred = allocateComponentExecutionState<DeferredExecutionState>(flowState, componentIndex);
+	deferred->flowState = flowState;
+	deferred->componentIndex = componentIndex;
+	deferred->prev = g_lastDeferred;
+	(g_lastDeferred ? g_lastDeferred->next : g_firstDeferred) = deferred;
+	g_lastDeferred = deferred;
+	g_numDeferred++;
+
+	tick_budget::componentDeferred();
+	return true;
+}
+
+void resumeDeferredComponents() {
+	while (g_firstDeferred) {
+		FlowState *flowState = g_firstDeferred->flowState;
+		unsigned componentIndex = g_firstDeferred->componentIndex;
+		uint32_t numExecutions = g_firstDeferred->numExecutions;
+
+		// unlinks it
+		deallocateComponentExecutionState(flowState, componentIndex);
+
+		for (uint32_t i = 0; i < numExecutions; i++) {
+			if (!addToQueue(flowState, componentIndex, -1, -1, -1, false)) {
+				throwError(flowState, componentIndex, "Execution queue is full\n");
+				break;
+			}
+		}
+	}
+}
+
+#endif
+
+#if OPTION_FLOW_PROFILER || OPTION_FLOW_TICK_BUDGET
+
+// action components of eez-framework, registered again wrapped below
+void executeStartComponent(FlowState *flowState, unsigned componentIndex);
+void executeEndComponent(FlowState *flowState, unsigned componentIndex);
+void executeInputComponent(FlowState *flowState, unsigned componentIndex);
+void executeOutputComponent(FlowState *flowState, unsigned componentIndex);
+void executeWatchVariableComponent(FlowState *flowState, unsigned componentIndex);
+void executeEvalExprComponent(FlowState *flowState, unsigned componentIndex);
+void executeSetVariableComponent(FlowState *flowState, unsigned componentIndex);
+void executeSwitchComponent(FlowState *flowState, unsigned componentIndex);
+void executeCompareComponent(FlowState *flowState, unsigned componentIndex);
+void executeIsTrueComponent(FlowState *flowState, unsigned componentIndex);
+void executeConstantComponent(FlowState *flowState, unsigned componentIndex);
+void executeLogComponent(FlowState *flowState, unsigned componentIndex);
+void executeCallActionComponent(FlowState *flowState, unsigned componentIndex);
+void executeDelayComponent(FlowState *flowState, unsigned componentIndex);
+void executeErrorComponent(FlowState *flowState, unsigned componentIndex);
+void executeCatchErrorComponent(FlowState *flowState, unsigned componentIndex);
+void executeCounterComponent(FlowState *flowState, unsigned componentIndex);
+void executeLoopComponent(FlowState *flowState, unsigned componentIndex);
+void executeShowPageComponent(FlowState *flowState, unsigned componentIndex);
+void executeAnimateComponent(FlowState *flowState, unsigned componentIndex);
+
+template <void (*executeComponentFunction)(FlowState *flowState, unsigned componentIndex)>
+static void executeTimedComponent(FlowState *flowState, unsigned componentIndex) {
+	Component *component = flowState->flow->components[componentIndex];
+#if OPTION_FLOW_TICK_BUDGET
+	if (deferComponent(flowState, componentIndex, component->type)) {
+		return;
+	}
+#endif
+#if OPTION_FLOW_PROFILER
+	profiler::componentStarted(flowState->flowIndex, componentIndex, component->type);
+#endif
+#if OPTION_FLOW_TICK_BUDGET
+	tick_budget::componentStarted(flowState->flowIndex, componentIndex, component->type);
+#endif
+	executeComponentFunction(flowState, componentIndex);
+#if OPTION_FLOW_TICK_BUDGET
+	tick_budget::componentFinished();
+#endif
+#if OPTION_FLOW_PROFILER
+	profiler::componentFinished();
+#endif
+}
+
+static void registerTimedComponents() {
+	registerComponent(COMPONENT_TYPE_START_ACTION, executeTimedComponent<executeStartComponent>);
+	registerComponent(COMPONENT_TYPE_END_ACTION, executeTimedComponent<executeEndComponent>);
+	registerComponent(COMPONENT_TYPE_INPUT_ACTION, executeTimedComponent<executeInputComponent>);
+	registerComponent(COMPONENT_TYPE_OUTPUT_ACTION, executeTimedComponent<executeOutputComponent>);
+	registerComponent(COMPONENT_TYPE_WATCH_VARIABLE_ACTION, executeTimedComponent<executeWatchVariableComponent>);
+	registerComponent(COMPONENT_TYPE_EVAL_EXPR_ACTION, executeTimedComponent<executeEvalExprComponent>);
+	registerComponent(COMPONENT_TYPE_SET_VARIABLE_ACTION, executeTimedComponent<executeSetVariableComponent>);
+	registerComponent(COMPONENT_TYPE_SWITCH_ACTION, executeTimedComponent<executeSwitchComponent>);
+	registerComponent(COMPONENT_TYPE_COMPARE_ACTION, executeTimedComponent<executeCompareComponent>);
+	registerComponent(COMPONENT_TYPE_IS_TRUE_ACTION, executeTimedComponent<executeIsTrueComponent>);
+	registerComponent(COMPONENT_TYPE_CONSTANT_ACTION, executeTimedComponent<executeConstantComponent>);
+	registerComponent(COMPONENT_TYPE_LOG_ACTION, executeTimedComponent<executeLogComponent>);
+	registerComponent(COMPONENT_TYPE_CALL_ACTION_ACTION, executeTimedComponent<executeCallActionComponent>);
+#if OPTION_FLOW_TIMER_WHEEL
+	registerComponent(COMPONENT_TYPE_DELAY_ACTION, executeTimedComponent<executeDelayComponentWithTimer>);
+#else
+	registerComponent(COMPONENT_TYPE_DELAY_ACTION, executeTimedComponent<executeDelayComponent>);
+#endif
+	registerComponent(COMPONENT_TYPE_ERROR_ACTION, executeTimedComponent<executeErrorComponent>);
+	registerComponent(COMPONENT_TYPE_CATCH_ERROR_ACTION, executeTimedComponent<executeCatchErrorComponent>);
+	registerComponent(COMPONENT_TYPE_COUNTER_ACTION, executeTimedComponent<executeCounterComponent>);
+	registerComponent(COMPONENT_TYPE_LOOP_ACTION, executeTimedComponent<executeLoopComponent>);
+	registerComponent(COMPONENT_TYPE_SHOW_PAGE_ACTION, executeTimedComponent<executeShowPageComponent>);
+#if OPTION_FLOW_TIMER_WHEEL
+	registerComponent(COMPONENT_TYPE_ANIMATE_ACTION, executeTimedComponent<executeAnimateComponentWithTimer>);
+#else
+	registerComponent(COMPONENT_TYPE_ANIMATE_ACTION, executeTimedComponent<executeAnimateComponent>);
+#endif
+}
+
+#endif
+
 void initHooks() {
 	showKeyboardHook = showKeyboard;
 	showKeypadHook = showKeypad;
+
+#if OPTION_FLOW_PROFILER || OPTION_FLOW_TICK_BUDGET
+	registerTimedComponents();
+#elif OPTION_FLOW_TIMER_WHEEL
+	registerComponent(COMPONENT_TYPE_DELAY_ACTION, executeDelayComponentWithTimer);
+	registerComponent(COMPONENT_TYPE_ANIMATE_ACTION, executeAnimateComponentWithTimer);
+#endif
+}
+
+const char *getComponentTypeName(uint16_t componentType) {
+	switch (componentType) {
+	case COMPONENT_TYPE_START_ACTION: return "StartActionComponent";
+	case COMPONENT_TYPE_END_ACTION: return "EndActionComponent";
+	case COMPONENT_TYPE_INPUT_ACTION: return "InputActionComponent";
+	case COMPONENT_TYPE_OUTPUT_ACTION: return "OutputActionComponent";
+	case COMPONENT_TYPE_WATCH_VARIABLE_ACTION: return "WatchVariableActionComponent";
+	case COMPONENT_TYPE_EVAL_EXPR_ACTION: return "EvalExprActionComponent";
+	case COMPONENT_TYPE_SET_VARIABLE_ACTION: return "SetVariableActionComponent";
+	case COMPONENT_TYPE_SWITCH_ACTION: return "SwitchActionComponent";
+	case COMPONENT_TYPE_COMPARE_ACTION: return "CompareActionComponent";
+	case COMPONENT_TYPE_IS_TRUE_ACTION: return "IsTrueActionComponent";
+	case COMPONENT_TYPE_CONSTANT_ACTION: return "ConstantActionComponent";
+	case COMPONENT_TYPE_LOG_ACTION: return "LogActionComponent";
+	case COMPONENT_TYPE_CALL_ACTION_ACTION: return "CallActionActionComponent";
+	case COMPONENT_TYPE_DELAY_ACTION: return "DelayActionComponent";
+	case COMPONENT_TYPE_ERROR_ACTION: return "ErrorActionComponent";
+	case COMPONENT_TYPE_CATCH_ERROR_ACTION: return "CatchErrorActionComponent";
+	case COMPONENT_TYPE_COUNTER_ACTION: return "CounterActionComponent";
+	case COMPONENT_TYPE_LOOP_ACTION: return "LoopActionComponent";
+	case COMPONENT_TYPE_SHOW_PAGE_ACTION: return "ShowPageActionComponent";
+	case COMPONENT_TYPE_ANIMATE_ACTION: return "AnimateActionComponent";
+	default: return nullptr;
+	}
 }
 
 } // namespace flow
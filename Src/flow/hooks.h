@@ -1,9 +1,18 @@
 #pragma once
 
+#include <stdint.h>
+
 namespace eez {
 namespace flow {
 
 void initHooks();
 
+// Adds the components deferred in the previous frame to the queue again,
+// see flow/tick_budget.h.
+void resumeDeferredComponents();
+
+// "LoopActionComponent", ..., nullptr for types it doesn't know
+const char *getComponentTypeName(uint16_t componentType);
+
 } // namespace flow
 } // namespace eez
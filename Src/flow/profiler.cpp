@@ -0,0 +1,375 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(EEZ_PLATFORM_STM32)
+#include "main.h"
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+#include <chrono>
+#endif
+
+#include "eez-framework-conf.h"
+
+#if OPTION_FLOW_PROFILER
+
+#include <eez/core/os.h>
+#include <eez/flow/queue.h>
+
+#include "../firmware.h"
+#include "hooks.h"
+#include "profiler.h"
+
+namespace eez {
+namespace flow {
+namespace profiler {
+
+static const uint16_t NO_NODE = 0xFFFF;
+
+// nodes hash table, power of 2 and more than twice the number of nodes
+static const uint32_t HASH_TABLE_SIZE = 2 * FLOW_PROFILER_MAX_NODES;
+
+struct Node {
+    uint16_t parent;
+    int16_t flowIndex;
+    uint16_t componentIndex;
+    uint16_t componentType;
+    uint32_t calls;
+    uint32_t maxInclusive;
+    uint64_t inclusive;
+    uint64_t exclusive;
+    uint32_t queuedCalls; // started from the flow queue, not nested
+    uint32_t maxQueueWait;
+    uint64_t queueWait;
+};
+
+struct Frame {
+    uint16_t node; // NO_NODE if dropped
+    uint32_t start;
+    uint32_t children; // inclusive time of nested components
+};
+
+static bool g_enabled;
+
+static Node g_nodes[FLOW_PROFILER_MAX_NODES];
+static uint16_t g_hashTable[HASH_TABLE_SIZE];
+
+static Frame g_stack[FLOW_PROFILER_MAX_DEPTH];
+static uint32_t g_depth;
+static uint32_t g_overflowDepth; // nested components not on the stack
+
+// Times at which the tasks in the flow queue of eez-framework were seen
+// first, oldest first. The queue only tells its size, so a task added by a
+// component gets the time that component finished, and a task added outside
+// of a component (input event, timer) the time of the next component start
+// or tick(), whichever comes first.
+static const uint32_t QUEUED_MASK = FLOW_PROFILER_MAX_QUEUED - 1;
+static uint32_t g_queued[FLOW_PROFILER_MAX_QUEUED];
+static uint32_t g_queuedHead;
+static uint32_t g_numQueued;
+
+Stats g_stats;
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(EEZ_PLATFORM_STM32)
+
+// CPU cycles, wraps after 23 s at 180 MHz which is more than any component
+static inline uint32_t getTicks() {
+    return DWT->CYCCNT;
+}
+
+static uint32_t ticksToMicroseconds(uint64_t ticks) {
+    return (uint32_t)(ticks / (SystemCoreClock / 1000000));
+}
+
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+static inline uint32_t getTicks() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t ticksToMicroseconds(uint64_t ticks) {
+    return (uint32_t)(ticks / 1000);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint16_t findNode(uint16_t parent, int flowIndex, unsigned componentIndex, uint16_t componentType) {
+    uint32_t hash = (parent * 2654435761u) ^ (flowIndex * 40503u) ^ componentIndex;
+    for (uint32_t i = 0; i < HASH_TABLE_SIZE; i++) {
+        uint16_t &slot = g_hashTable[(hash + i) & (HASH_TABLE_SIZE - 1)];
+
+        if (slot == NO_NODE) {
+            if (g_stats.numNodes == FLOW_PROFILER_MAX_NODES) {
+                return NO_NODE;
+            }
+
+            slot = (uint16_t)g_stats.numNodes++;
+            auto &node = g_nodes[slot];
+            memset(&node, 0, sizeof(Node));
+            node.parent = parent;
+            node.flowIndex = (int16_t)flowIndex;
+            node.componentIndex = (uint16_t)componentIndex;
+            node.componentType = componentType;
+            return slot;
+        }
+
+        auto &node = g_nodes[slot];
+        if (node.parent == parent && node.flowIndex == flowIndex && node.componentIndex == componentIndex) {
+            return slot;
+        }
+    }
+
+    return NO_NODE;
+}
+
+// Tasks removed without passing through componentStarted() (widget
+// components, stopped flows) are taken to be the oldest ones.
+static void syncQueue(uint32_t queueSize, uint32_t now) {
+    if (queueSize > FLOW_PROFILER_MAX_QUEUED) {
+        queueSize = FLOW_PROFILER_MAX_QUEUED;
+    }
+    while (g_numQueued > queueSize) {
+        g_queuedHead = (g_queuedHead + 1) & QUEUED_MASK;
+        g_numQueued--;
+    }
+    while (g_numQueued < queueSize) {
+        g_queued[(g_queuedHead + g_numQueued) & QUEUED_MASK] = now;
+        g_numQueued++;
+    }
+}
+
+void componentStarted(int flowIndex, unsigned componentIndex, uint16_t componentType) {
+    if (!g_enabled) {
+        return;
+    }
+
+    // a component which isn't nested was just taken from the front of the
+    // queue, the size doesn't count it anymore
+    bool isQueued = g_depth == 0 && g_overflowDepth == 0;
+    uint32_t queueWait = 0;
+    if (isQueued) {
+        uint32_t now = getTicks();
+        syncQueue((uint32_t)getQueueSize() + 1, now);
+        queueWait = now - g_queued[g_queuedHead];
+        g_queuedHead = (g_queuedHead + 1) & QUEUED_MASK;
+        g_numQueued--;
+    }
+
+    if (g_depth == FLOW_PROFILER_MAX_DEPTH) {
+        g_overflowDepth++;
+        g_stats.droppedCalls++;
+        return;
+    }
+
+    auto &frame = g_stack[g_depth++];
+    if (g_depth == 1) {
+        frame.node = findNode(NO_NODE, flowIndex, componentIndex, componentType);
+    } else {
+        // nothing is recorded below a dropped parent
+        uint16_t parent = g_stack[g_depth - 2].node;
+        frame.node = parent != NO_NODE ? findNode(parent, flowIndex, componentIndex, componentType) : NO_NODE;
+    }
+    frame.children = 0;
+
+    if (frame.node == NO_NODE) {
+        g_stats.droppedCalls++;
+    } else if (isQueued) {
+        auto &node = g_nodes[frame.node];
+        node.queuedCalls++;
+        node.queueWait += queueWait;
+        if (queueWait > node.maxQueueWait) {
+            node.maxQueueWait = queueWait;
+        }
+    }
+
+    if (g_depth > g_stats.maxDepth) {
+        g_stats.maxDepth = g_depth;
+    }
+
+    // last, so the bookkeeping above isn't counted
+    frame.start = getTicks();
+}
+
+void componentFinished() {
+    if (!g_enabled) {
+        return;
+    }
+
+    uint32_t now = getTicks();
+
+    // tasks added by the component
+    syncQueue((uint32_t)getQueueSize(), now);
+
+    // started beyond FLOW_PROFILER_MAX_DEPTH
+    if (g_overflowDepth > 0) {
+        g_overflowDepth--;
+        return;
+    }
+
+    if (g_depth == 0) {
+        return;
+    }
+
+    auto &frame = g_stack[--g_depth];
+    uint32_t inclusive = now - frame.start;
+
+    if (frame.node != NO_NODE) {
+        auto &node = g_nodes[frame.node];
+        node.calls++;
+        node.inclusive += inclusive;
+        node.exclusive += inclusive > frame.children ? inclusive - frame.children : 0;
+        if (inclusive > node.maxInclusive) {
+            node.maxInclusive = inclusive;
+        }
+    }
+
+    if (g_depth > 0) {
+        g_stack[g_depth - 1].children += inclusive;
+    }
+}
+
+void reset() {
+    g_stats.numNodes = 0;
+    g_stats.maxDepth = 0;
+    g_stats.droppedCalls = 0;
+    memset(g_hashTable, 0xFF, sizeof(g_hashTable));
+
+    // components running now finish into dropped frames
+    for (uint32_t i = 0; i < g_depth; i++) {
+        g_stack[i].node = NO_NODE;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void dump(WriteFunc write) {
+    char line[160];
+    int length;
+
+    length = snprintf(line, sizeof(line), "# flow profile, times in us\n# node id parent flow component type calls inclusive exclusive max queued wait max_wait\n");
+    write(line, length);
+
+    for (uint32_t i = 0; i < g_stats.numNodes; i++) {
+        const auto &node = g_nodes[i];
+
+        char parent[8];
+        if (node.parent == NO_NODE) {
+            strcpy(parent, "-");
+        } else {
+            snprintf(parent, sizeof(parent), "%u", (unsigned)node.parent);
+        }
+
+        char type[24];
+        const char *typeName = getComponentTypeName(node.componentType);
+        if (!typeName) {
+            snprintf(type, sizeof(type), "Component%u", (unsigned)node.componentType);
+            typeName = type;
+        }
+
+        length = snprintf(line, sizeof(line), "node %u %s %d %u %s %u %u %u %u %u %u %u\n",
+            (unsigned)i, parent, (int)node.flowIndex, (unsigned)node.componentIndex, typeName,
+            (unsigned)node.calls, (unsigned)ticksToMicroseconds(node.inclusive),
+            (unsigned)ticksToMicroseconds(node.exclusive), (unsigned)ticksToMicroseconds(node.maxInclusive),
+            (unsigned)node.queuedCalls, (unsigned)ticksToMicroseconds(node.queueWait),
+            (unsigned)ticksToMicroseconds(node.maxQueueWait));
+        write(line, length);
+    }
+
+    length = snprintf(line, sizeof(line), "# max depth %u, dropped %u\n",
+        (unsigned)g_stats.maxDepth, (unsigned)g_stats.droppedCalls);
+    write(line, length);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(EEZ_PLATFORM_STM32)
+
+static uint32_t g_lastDumpTime;
+
+void init() {
+    // cycle counter
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    reset();
+    g_enabled = true;
+    g_lastDumpTime = millis();
+}
+
+static void serialWriteLine(const char *text, int textLength) {
+    serialWrite(text, textLength);
+    // CDC accepts the next packet only after the previous one is sent
+    osDelay(1);
+}
+
+void tick() {
+    if (g_enabled) {
+        // tasks added outside of components since the last one ran
+        syncQueue((uint32_t)getQueueSize(), getTicks());
+    }
+
+    uint32_t time = millis();
+    if (time - g_lastDumpTime >= FLOW_PROFILER_DUMP_INTERVAL_MS) {
+        g_lastDumpTime = time;
+        dump(serialWriteLine);
+    }
+}
+
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+static FILE *g_file;
+
+static void fileWrite(const char *text, int textLength) {
+    fwrite(text, 1, textLength, g_file);
+}
+
+static void dumpToFile() {
+    g_enabled = false;
+    dump(fileWrite);
+    fclose(g_file);
+    g_file = nullptr;
+}
+
+// EEZ_FLOW_PROFILE=<file> profiles the whole run and dumps at exit
+void init() {
+    auto path = getenv("EEZ_FLOW_PROFILE");
+    if (!path || !*path) {
+        return;
+    }
+
+    g_file = fopen(path, "w");
+    if (!g_file) {
+        printf("Can't open flow profile file %s\n", path);
+        return;
+    }
+
+    reset();
+    g_enabled = true;
+    atexit(dumpToFile);
+}
+
+void tick() {
+    if (g_enabled) {
+        // tasks added outside of components since the last one ran
+        syncQueue((uint32_t)getQueueSize(), getTicks());
+    }
+}
+
+#endif
+
+} // namespace profiler
+} // namespace flow
+} // namespace eez
+
+#endif // OPTION_FLOW_PROFILER
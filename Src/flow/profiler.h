@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+namespace flow {
+namespace profiler {
+
+// Per component instance timing of the flow runtime, enabled with
+// OPTION_FLOW_PROFILER. flow/hooks.cpp registers the action components of
+// eez-framework again with registerComponent(), each one wrapped in
+// componentStarted/componentFinished, so every action component executed
+// from the flow queue is timed. Widget components aren't registered that
+// way and aren't timed.
+//
+// Queue wait is the time from when a task was added to the flow queue to
+// when its component started. The queue is in eez-framework and tells only
+// its size, so the profiler keeps the times it first saw each task in the
+// queue, see profiler.cpp. Nested components don't come from the queue and
+// have no wait.
+//
+// Components executed while another one runs are nested, so timings are
+// kept per calling context: the same component reached through different
+// parents is a different node. Exclusive time is inclusive time minus
+// nested components.
+
+void init();
+
+void componentStarted(int flowIndex, unsigned componentIndex, uint16_t componentType);
+void componentFinished();
+
+// Clears the collected timings, e.g. before the interaction to profile.
+void reset();
+
+// Dumps the nodes as text lines, tools/flow_profile_fold turns them into
+// folded stacks for flamegraph.pl or speedscope:
+//
+//   node <id> <parent id or -> <flow> <component> <type name> <calls>
+//       <inclusive us> <exclusive us> <max inclusive us>
+//       <calls from the queue> <queue wait us> <max queue wait us>
+typedef void (*WriteFunc)(const char *text, int textLength);
+void dump(WriteFunc write);
+
+// On STM32 dumps over serial every FLOW_PROFILER_DUMP_INTERVAL_MS, call
+// once per frame from the GUI thread.
+void tick();
+
+struct Stats {
+    uint32_t numNodes;
+    uint32_t maxDepth;
+    uint32_t droppedCalls; // no free node or nested too deep
+};
+
+extern Stats g_stats;
+
+} // namespace profiler
+} // namespace flow
+} // namespace eez
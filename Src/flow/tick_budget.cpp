@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(EEZ_PLATFORM_STM32)
+#include "main.h"
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+#include <chrono>
+#endif
+
+#include "eez-framework-conf.h"
+
+#if OPTION_FLOW_TICK_BUDGET
+
+#if defined(EEZ_PLATFORM_STM32)
+#include <eez/core/os.h>
+#include "../firmware.h"
+#endif
+
+#include "hooks.h"
+#include "tick_budget.h"
+
+namespace eez {
+namespace flow {
+namespace tick_budget {
+
+struct Overrun {
+    int16_t flowIndex;
+    uint16_t componentIndex;
+    uint16_t componentType;
+    uint32_t numOverruns;
+    uint32_t maxTime; // us
+};
+
+static uint32_t g_budgetTicks;
+static uint32_t g_frameTime; // ticks
+
+static uint32_t g_depth;
+static uint32_t g_componentStart;
+static int16_t g_flowIndex;
+static uint16_t g_componentIndex;
+static uint16_t g_componentType;
+
+static Overrun g_overruns[FLOW_TICK_BUDGET_MAX_COMPONENTS];
+static uint32_t g_numOverruns;
+
+Stats g_stats;
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(EEZ_PLATFORM_STM32)
+
+// CPU cycles, see flow/profiler.cpp
+static inline uint32_t getTicks() {
+    return DWT->CYCCNT;
+}
+
+static uint32_t ticksToMicroseconds(uint32_t ticks) {
+    return ticks / (SystemCoreClock / 1000000);
+}
+
+static uint32_t microsecondsToTicks(uint32_t us) {
+    return us * (SystemCoreClock / 1000000);
+}
+
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+static inline uint32_t getTicks() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t ticksToMicroseconds(uint32_t ticks) {
+    return ticks / 1000;
+}
+
+static uint32_t microsecondsToTicks(uint32_t us) {
+    return us * 1000;
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+static Overrun *findOverrun(int flowIndex, unsigned componentIndex) {
+    for (uint32_t i = 0; i < g_numOverruns; i++) {
+        if (g_overruns[i].flowIndex == flowIndex && g_overruns[i].componentIndex == componentIndex) {
+            return &g_overruns[i];
+        }
+    }
+    if (g_numOverruns == FLOW_TICK_BUDGET_MAX_COMPONENTS) {
+        return nullptr;
+    }
+    Overrun *overrun = &g_overruns[g_numOverruns++];
+    overrun->flowIndex = (int16_t)flowIndex;
+    overrun->componentIndex = (uint16_t)componentIndex;
+    overrun->numOverruns = 0;
+    overrun->maxTime = 0;
+    return overrun;
+}
+
+static void addOverrun(uint32_t componentTime) {
+    g_stats.numOverruns++;
+
+    Overrun *overrun = findOverrun(g_flowIndex, g_componentIndex);
+    if (!overrun) {
+        g_stats.numDropped++;
+        return;
+    }
+    overrun->componentType = g_componentType;
+    overrun->numOverruns++;
+    if (componentTime > overrun->maxTime) {
+        overrun->maxTime = componentTime;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void componentStarted(int flowIndex, unsigned componentIndex, uint16_t componentType) {
+    if (g_depth++ == 0) {
+        g_flowIndex = (int16_t)flowIndex;
+        g_componentIndex = (uint16_t)componentIndex;
+        g_componentType = componentType;
+        g_componentStart = getTicks();
+    }
+}
+
+void componentFinished() {
+    if (g_depth == 0 || --g_depth > 0) {
+        return;
+    }
+
+    uint32_t componentTime = getTicks() - g_componentStart;
+    g_frameTime += componentTime;
+    if (componentTime > g_budgetTicks) {
+        addOverrun(ticksToMicroseconds(componentTime));
+    }
+}
+
+bool isSpent() {
+    return g_depth == 0 && g_frameTime >= g_budgetTicks;
+}
+
+void componentDeferred() {
+    g_stats.numDeferred++;
+}
+
+void componentNotDeferred() {
+    g_stats.numNotDeferred++;
+}
+
+// the framework runs the flow between two calls of tick()
+static void endFrame() {
+    uint32_t frameTime = ticksToMicroseconds(g_frameTime);
+    g_frameTime = 0;
+
+    g_stats.numFrames++;
+    if (frameTime > FLOW_TICK_BUDGET_US) {
+        g_stats.numOverBudget++;
+    }
+    if (frameTime > g_stats.maxFrameTime) {
+        g_stats.maxFrameTime = frameTime;
+    }
+}
+
+void dump(WriteFunc write) {
+    char line[160];
+    int length;
+
+    length = snprintf(line, sizeof(line), "# flow budget %u us, %u frames, %u over budget, max %u us, %u overruns\n",
+        (unsigned)FLOW_TICK_BUDGET_US, (unsigned)g_stats.numFrames, (unsigned)g_stats.numOverBudget, (unsigned)g_stats.maxFrameTime, (unsigned)g_stats.numOverruns);
+    write(line, length);
+
+    length = snprintf(line, sizeof(line), "# %u deferred to the next frame, %u not deferred\n# overrun flow component type overruns max_us\n",
+        (unsigned)g_stats.numDeferred, (unsigned)g_stats.numNotDeferred);
+    write(line, length);
+
+    // worst first, the table is small
+    bool isDumped[FLOW_TICK_BUDGET_MAX_COMPONENTS] = {};
+    for (uint32_t n = 0; n < g_numOverruns; n++) {
+        uint32_t worst = 0;
+        bool isFound = false;
+        for (uint32_t i = 0; i < g_numOverruns; i++) {
+            if (!isDumped[i] && (!isFound || g_overruns[i].maxTime > g_overruns[worst].maxTime)) {
+                worst = i;
+                isFound = true;
+            }
+        }
+        isDumped[worst] = true;
+
+        const auto &overrun = g_overruns[worst];
+        char type[24];
+        const char *typeName = getComponentTypeName(overrun.componentType);
+        if (!typeName) {
+            snprintf(type, sizeof(type), "Component%u", (unsigned)overrun.componentType);
+            typeName = type;
+        }
+        length = snprintf(line, sizeof(line), "overrun %d %u %s %u %u\n",
+            (int)overrun.flowIndex, (unsigned)overrun.componentIndex, typeName,
+            (unsigned)overrun.numOverruns, (unsigned)overrun.maxTime);
+        write(line, length);
+    }
+
+    if (g_stats.numDropped) {
+        length = snprintf(line, sizeof(line), "# %u overruns of other components\n", (unsigned)g_stats.numDropped);
+        write(line, length);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(EEZ_PLATFORM_STM32)
+
+static uint32_t g_lastReportTime;
+static uint32_t g_lastReportOverruns;
+static uint32_t g_lastReportOverBudget;
+static uint32_t g_lastReportDeferred;
+
+void init() {
+    // cycle counter
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    g_budgetTicks = microsecondsToTicks(FLOW_TICK_BUDGET_US);
+    g_lastReportTime = millis();
+}
+
+static void serialWriteLine(const char *text, int textLength) {
+    serialWrite(text, textLength);
+    // CDC accepts the next packet only after the previous one is sent
+    osDelay(1);
+}
+
+void tick() {
+    endFrame();
+
+    uint32_t time = millis();
+    if (time - g_lastReportTime >= FLOW_TICK_BUDGET_REPORT_INTERVAL_MS) {
+        g_lastReportTime = time;
+        if (g_stats.numOverruns != g_lastReportOverruns || g_stats.numOverBudget != g_lastReportOverBudget || g_stats.numDeferred != g_lastReportDeferred) {
+            g_lastReportOverruns = g_stats.numOverruns;
+            g_lastReportOverBudget = g_stats.numOverBudget;
+            g_lastReportDeferred = g_stats.numDeferred;
+            dump(serialWriteLine);
+        }
+    }
+}
+
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+static void stdoutWrite(const char *text, int textLength) {
+    fwrite(text, 1, textLength, stdout);
+}
+
+static void dumpAtExit() {
+    if (g_stats.numOverruns || g_stats.numOverBudget || g_stats.numDeferred) {
+        dump(stdoutWrite);
+    }
+}
+
+void init() {
+    g_budgetTicks = microsecondsToTicks(FLOW_TICK_BUDGET_US);
+    atexit(dumpAtExit);
+}
+
+void tick() {
+    endFrame();
+}
+
+#endif
+
+} // namespace tick_budget
+} // namespace flow
+} // namespace eez
+
+#endif // OPTION_FLOW_TICK_BUDGET
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+namespace flow {
+namespace tick_budget {
+
+// Time budget of the flow per frame, enabled with OPTION_FLOW_TICK_BUDGET.
+// flow/hooks.cpp registers the action components of eez-framework again
+// with registerComponent(), wrapped in componentStarted() and
+// componentFinished(), and DeviceAppContext::stateManagment() calls tick()
+// once per frame.
+//
+// The queue loop is flow::tick() of eez-framework, which runs the queue
+// empty on every tick. Once the budget isSpent(), the wrapper doesn't
+// execute a component taken from the queue but defers it, so the rest of
+// the queue is taken off one component at a time and nothing else is
+// executed. flow::resumeDeferredComponents() adds the deferred components
+// to the queue again, in the same order, right after tick() in the next
+// frame.
+//
+// Only components without an execution state are deferred, the deferred
+// entry is kept there, so the flow state isn't freed under it. Components
+// in the middle of their work (Loop between iterations, an expired Delay)
+// run anyway, as do WatchVariableActionComponent, which eez-framework
+// executes on every tick outside of the queue, and components executed
+// while another one runs. If FLOW_TICK_BUDGET_MAX_DEFERRED components are
+// already deferred, the next one runs too.
+//
+// A frame is over budget if the components executed since the previous
+// tick() took more than FLOW_TICK_BUDGET_US together, e.g. a long
+// LoopActionComponent, which goes through the queue on every iteration.
+// A component which takes more than the budget by itself is reported as
+// an overrun with the time it took, so components which are too slow by
+// themselves can be told apart from many cheap ones. Components executed
+// while another one runs are part of the outer one. With the deferral a
+// frame is over budget by the component which spent it and the ones above
+// which run anyway.
+
+void init();
+
+void componentStarted(int flowIndex, unsigned componentIndex, uint16_t componentType);
+void componentFinished();
+
+// The components executed since the previous tick() took the whole budget.
+// Always false while a component runs.
+bool isSpent();
+
+// Counts a component execution left for the next frame, or one executed
+// over budget because the deferred list is full.
+void componentDeferred();
+void componentNotDeferred();
+
+// Components which took longer than the budget, worst first:
+//
+//   overrun <flow> <component> <type name> <overruns> <max us>
+typedef void (*WriteFunc)(const char *text, int textLength);
+void dump(WriteFunc write);
+
+// Ends the frame. On STM32 dumps over serial every
+// FLOW_TICK_BUDGET_REPORT_INTERVAL_MS if there were new overruns, frames
+// over budget or deferred components. The simulator dumps at exit.
+void tick();
+
+struct Stats {
+    uint32_t numFrames;
+    uint32_t numOverBudget; // frames
+    uint32_t numOverruns;   // components longer than the budget
+    uint32_t maxFrameTime;  // of the components in a frame, us
+    uint32_t numDropped;    // overruns of components not in the table
+    uint32_t numDeferred;   // executions left for the next frame
+    uint32_t numNotDeferred; // executed over budget, the deferred list was full
+};
+
+extern Stats g_stats;
+
+} // namespace tick_budget
+} // namespace flow
+} // namespace eez
@@ -0,0 +1,188 @@
+#include "eez-framework-conf.h"
+
+#if OPTION_FLOW_TIMER_WHEEL
+
+#include "timer_wheel.h"
+
+namespace eez {
+namespace flow {
+namespace timer_wheel {
+
+static const int NUM_LEVELS = 4;
+static const int SLOT_BITS = 6;
+static const uint32_t NUM_SLOTS = 1 << SLOT_BITS;
+static const uint32_t SLOT_MASK = NUM_SLOTS - 1;
+
+// the last level holds delays up to 2^24 ms, longer ones are placed at its
+// end and moved again when reached
+static const uint32_t MAX_DELTA = (1u << (NUM_LEVELS * SLOT_BITS)) - 1;
+
+static Timer *g_slots[NUM_LEVELS][NUM_SLOTS];
+static uint64_t g_occupied[NUM_LEVELS]; // bit per non empty slot
+
+// all deadlines up to and including g_now have expired
+static uint32_t g_now;
+
+Stats g_stats;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static int findFirstSet(uint64_t bits) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int index = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+// Slots from the one after index on, 1 to 64 to the first occupied slot,
+// 0 if none is.
+static uint32_t getDistance(uint64_t occupied, uint32_t index) {
+    uint32_t shift = (index + 1) & SLOT_MASK;
+    uint64_t rotated = (occupied >> shift) | (occupied << ((NUM_SLOTS - shift) & SLOT_MASK));
+    return rotated ? findFirstSet(rotated) + 1 : 0;
+}
+
+static void link(Timer &timer, uint32_t level, uint32_t index) {
+    Timer *&head = g_slots[level][index];
+    timer.next = head;
+    if (head) {
+        head->pprev = &timer.next;
+    }
+    head = &timer;
+    timer.pprev = &head;
+    timer.slot = (uint16_t)(level * NUM_SLOTS + index);
+    g_occupied[level] |= 1ull << index;
+}
+
+static void unlink(Timer &timer) {
+    *timer.pprev = timer.next;
+    if (timer.next) {
+        timer.next->pprev = timer.pprev;
+    }
+    timer.next = nullptr;
+    timer.pprev = nullptr;
+
+    uint32_t level = timer.slot / NUM_SLOTS;
+    uint32_t index = timer.slot % NUM_SLOTS;
+    if (!g_slots[level][index]) {
+        g_occupied[level] &= ~(1ull << index);
+    }
+}
+
+// Level 0 slot of the deadline if it's less than 64 ms away, otherwise the
+// coarsest level whose slot is at least one slot after the current one.
+static void place(Timer &timer, uint32_t delta) {
+    if (delta > MAX_DELTA) {
+        delta = MAX_DELTA;
+    }
+    uint32_t level = 0;
+    while (level < NUM_LEVELS - 1 && delta >= (1u << ((level + 1) * SLOT_BITS))) {
+        level++;
+    }
+    link(timer, level, ((g_now + delta) >> (level * SLOT_BITS)) & SLOT_MASK);
+}
+
+// Moves the list out of the slot, so the callbacks can start and stop
+// timers while it is walked. Stopping a timer still in the list unlinks it
+// from there.
+static void detach(uint32_t level, uint32_t index, Timer *&list) {
+    list = g_slots[level][index];
+    g_slots[level][index] = nullptr;
+    g_occupied[level] &= ~(1ull << index);
+    if (list) {
+        list->pprev = &list;
+    }
+}
+
+static Timer *pop(Timer *&list) {
+    Timer *timer = list;
+    list = timer->next;
+    if (list) {
+        list->pprev = &list;
+    }
+    timer->next = nullptr;
+    timer->pprev = nullptr;
+    return timer;
+}
+
+static void cascade(uint32_t level) {
+    Timer *list;
+    detach(level, (g_now >> (level * SLOT_BITS)) & SLOT_MASK, list);
+    while (list) {
+        Timer *timer = pop(list);
+        int32_t delta = (int32_t)(timer->deadline - g_now);
+        place(*timer, delta > 0 ? (uint32_t)delta : 0);
+        g_stats.numCascaded++;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void init(uint32_t now) {
+    g_now = now;
+}
+
+void start(Timer &timer, uint32_t deadline, ExpireFunc func, void *param) {
+    if (timer.pprev) {
+        unlink(timer);
+    } else {
+        g_stats.numStarted++;
+    }
+    timer.deadline = deadline;
+    timer.func = func;
+    timer.param = param;
+
+    int32_t delta = (int32_t)(deadline - g_now);
+    place(timer, delta > 1 ? (uint32_t)delta : 1);
+}
+
+void stop(Timer &timer) {
+    if (timer.pprev) {
+        unlink(timer);
+        g_stats.numStarted--;
+    }
+}
+
+void advance(uint32_t now) {
+    while ((int32_t)(now - g_now) > 0) {
+        // to the next occupied level 0 slot, the next level 0 lap or now,
+        // nothing happens in between
+        uint32_t step = NUM_SLOTS - (g_now & SLOT_MASK);
+        uint32_t distance = getDistance(g_occupied[0], g_now & SLOT_MASK);
+        if (distance && distance < step) {
+            step = distance;
+        }
+        if (now - g_now < step) {
+            step = now - g_now;
+        }
+        g_now += step;
+
+        // coarser levels first, their timers may go down more than one level
+        for (int level = NUM_LEVELS - 1; level > 0; level--) {
+            if ((g_now & ((1u << (level * SLOT_BITS)) - 1)) == 0) {
+                cascade(level);
+            }
+        }
+
+        Timer *list;
+        detach(0, g_now & SLOT_MASK, list);
+        while (list) {
+            Timer *timer = pop(list);
+            g_stats.numStarted--;
+            g_stats.numExpired++;
+            timer->func(timer->param);
+        }
+    }
+}
+
+} // namespace timer_wheel
+} // namespace flow
+} // namespace eez
+
+#endif // OPTION_FLOW_TIMER_WHEEL
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+namespace flow {
+namespace timer_wheel {
+
+// Deadlines of Delay and Animate component instances in a hierarchical
+// timing wheel, enabled with OPTION_FLOW_TIMER_WHEEL. The Delay and Animate
+// of eez-framework stay in the flow queue and are executed on every tick,
+// to compare millis() with the end time or to move the timeline.
+// flow/hooks.cpp registers a Delay and an Animate which start a timer
+// instead and are added to the flow queue again from the timer callback.
+// Start, stop and expiry are O(1): 4 levels of 64 slots with 1 ms, 64 ms,
+// 4 s and 4.5 min resolution, a timer moves to a finer level when its slot
+// is reached. Longer delays wait in the last level and are moved on every
+// lap, up to 2^31 ms.
+//
+// Animate starts its timer for the next millisecond after every step, so
+// it moves the timeline once per frame, in the advance() called from
+// DeviceAppContext::stateManagment().
+//
+// The wheel doesn't shorten the wait of the GUI thread: its loop is in
+// eez-framework, paced by the display sync, with no hook for the wait.
+//
+// The timer is a member of the component execution state, so there is no
+// pool to run out of. All calls are from the GUI thread.
+
+typedef void (*ExpireFunc)(void *param);
+
+struct Timer {
+    Timer *next;
+    Timer **pprev; // nullptr if not started
+    uint32_t deadline; // millis()
+    ExpireFunc func;
+    void *param;
+    uint16_t slot; // level * 64 + slot index
+};
+
+// Time in millis() the wheel starts from.
+void init(uint32_t now);
+
+// Starts or restarts the timer, func(param) is called from advance() at
+// the deadline, or on the next advance() if it has already passed.
+void start(Timer &timer, uint32_t deadline, ExpireFunc func, void *param);
+
+void stop(Timer &timer);
+
+inline bool isStarted(const Timer &timer) {
+    return timer.pprev != nullptr;
+}
+
+// Calls the callbacks of the timers whose deadline is at or before now,
+// in deadline order. Called every frame from the GUI thread. A callback
+// may start and stop timers, a timer started for now or before expires on
+// the next call.
+void advance(uint32_t now);
+
+struct Stats {
+    uint32_t numStarted; // currently
+    uint32_t numExpired;
+    uint32_t numCascaded; // moved to a finer level
+};
+
+extern Stats g_stats;
+
+} // namespace timer_wheel
+} // namespace flow
+} // namespace eez
@@ -1,11 +1,20 @@
+#include <eez/core/os.h>
 #include <eez/core/sound.h>
 
 #include <eez/gui/gui.h>
 #include <eez/gui/touch_calibration.h>
 
+#include "../date_time.h"
+#include "../flow/hooks.h"
+#include "../flow/profiler.h"
+#include "../flow/tick_budget.h"
+#include "../flow/timer_wheel.h"
+
 #include "app_context.h"
+#include "data_batch.h"
 #include "document.h"
 #include "keypad.h"
+#include "lazy_assets.h"
 
 namespace eez {
 namespace gui {
@@ -15,9 +24,37 @@ DeviceAppContext g_deviceAppContext;
 void DeviceAppContext::stateManagment() {
     AppContext::stateManagment();
 
+	// sub second once per frame, date and time come from the RTC wakeup,
+	// one copy of them for the whole frame
+	date_time::tick();
+
 	if (getActivePageId() == PAGE_ID_NONE) {
 		showPage(getMainPageId());
 	}
+
+#if OPTION_LAZY_ASSETS || OPTION_SD_ASSETS
+	// region of assets switched during the previous frame
+	lazy_assets::releaseRetired();
+#endif
+
+#if OPTION_FLOW_PROFILER
+	flow::profiler::tick();
+#endif
+
+#if OPTION_FLOW_TICK_BUDGET
+	flow::tick_budget::tick();
+	// before anything else is added to the queue in this frame
+	flow::resumeDeferredComponents();
+#endif
+
+#if OPTION_FLOW_TIMER_WHEEL
+	// expired Delay and Animate components are added to the flow queue
+	flow::timer_wheel::advance(millis());
+#endif
+
+#if OPTION_DATA_BATCH
+	data_batch::evaluate(this);
+#endif
 }
 
 int DeviceAppContext::getMainPageId() {
@@ -0,0 +1,344 @@
+#include <string.h>
+
+#include "assets_codec.h"
+
+namespace eez {
+namespace gui {
+namespace assets_codec {
+
+int lz4Decompress(const uint8_t *src, int srcSize, uint8_t *dst, int dstCapacity) {
+    const uint8_t *ip = src;
+    const uint8_t *srcEnd = src + srcSize;
+    uint8_t *op = dst;
+    uint8_t *dstEnd = dst + dstCapacity;
+
+    while (ip < srcEnd) {
+        uint32_t token = *ip++;
+
+        uint32_t literalLength = token >> 4;
+        if (literalLength == 15) {
+            uint32_t x;
+            do {
+                if (ip >= srcEnd) {
+                    return -1;
+                }
+                x = *ip++;
+                literalLength += x;
+            } while (x == 255);
+        }
+
+        if (literalLength > (uint32_t)(srcEnd - ip) || literalLength > (uint32_t)(dstEnd - op)) {
+            return -1;
+        }
+        memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        if (ip >= srcEnd) {
+            // last sequence has only literals
+            break;
+        }
+
+        if (srcEnd - ip < 2) {
+            return -1;
+        }
+        uint32_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (uint32_t)(op - dst)) {
+            return -1;
+        }
+
+        uint32_t matchLength = token & 15;
+        if (matchLength == 15) {
+            uint32_t x;
+            do {
+                if (ip >= srcEnd) {
+                    return -1;
+                }
+                x = *ip++;
+                matchLength += x;
+            } while (x == 255);
+        }
+        matchLength += 4;
+
+        if (matchLength > (uint32_t)(dstEnd - op)) {
+            return -1;
+        }
+
+        // byte by byte, match can overlap the output
+        const uint8_t *match = op - offset;
+        for (uint32_t i = 0; i < matchLength; i++) {
+            *op++ = *match++;
+        }
+    }
+
+    return (int)(op - dst);
+}
+
+int lz4DecompressFast(const uint8_t *src, int srcSize, uint8_t *dst, int dstCapacity) {
+    const uint8_t *ip = src;
+    const uint8_t *srcEnd = src + srcSize;
+    uint8_t *op = dst;
+    uint8_t *dstEnd = dst + dstCapacity;
+
+    while (ip < srcEnd) {
+        uint32_t token = *ip++;
+
+        uint32_t literalLength = token >> 4;
+        if (literalLength == 15) {
+            uint32_t x;
+            do {
+                if (ip >= srcEnd) {
+                    return -1;
+                }
+                x = *ip++;
+                literalLength += x;
+            } while (x == 255);
+        }
+
+        if (literalLength > (uint32_t)(srcEnd - ip) || literalLength > (uint32_t)(dstEnd - op)) {
+            return -1;
+        }
+        if (literalLength <= 16 && srcEnd - ip >= 16 && dstEnd - op >= 16) {
+            // short literal run, one fixed size copy
+            memcpy(op, ip, 16);
+        } else {
+            memcpy(op, ip, literalLength);
+        }
+        ip += literalLength;
+        op += literalLength;
+
+        if (ip >= srcEnd) {
+            break;
+        }
+
+        if (srcEnd - ip < 2) {
+            return -1;
+        }
+        uint32_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (uint32_t)(op - dst)) {
+            return -1;
+        }
+
+        uint32_t matchLength = token & 15;
+        if (matchLength == 15) {
+            uint32_t x;
+            do {
+                if (ip >= srcEnd) {
+                    return -1;
+                }
+                x = *ip++;
+                matchLength += x;
+            } while (x == 255);
+        }
+        matchLength += 4;
+
+        if (matchLength > (uint32_t)(dstEnd - op)) {
+            return -1;
+        }
+
+        const uint8_t *match = op - offset;
+        if (offset >= 8 && (uint32_t)(dstEnd - op) >= matchLength + 8) {
+            // 8 byte chunks, each chunk reads only already written bytes,
+            // may write up to 7 bytes past the match (inside the output)
+            uint8_t *matchEnd = op + matchLength;
+            do {
+                memcpy(op, match, 8);
+                op += 8;
+                match += 8;
+            } while (op < matchEnd);
+            op = matchEnd;
+        } else {
+            for (uint32_t i = 0; i < matchLength; i++) {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return (int)(op - dst);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace lzr {
+
+void initModel(Model &model) {
+    auto probs = (uint16_t *)&model;
+    for (size_t i = 0; i < sizeof(Model) / sizeof(uint16_t); i++) {
+        probs[i] = PROB_INIT;
+    }
+}
+
+struct RangeDecoder {
+    const uint8_t *ip;
+    const uint8_t *srcEnd;
+    uint32_t range;
+    uint32_t code;
+    bool error;
+
+    void init(const uint8_t *src, int srcSize) {
+        ip = src;
+        srcEnd = src + srcSize;
+        range = 0xFFFFFFFF;
+        code = 0;
+        error = false;
+        for (int i = 0; i < 5; i++) {
+            code = (code << 8) | next();
+        }
+    }
+
+    inline uint8_t next() {
+        if (ip < srcEnd) {
+            return *ip++;
+        }
+        error = true;
+        return 0;
+    }
+
+    inline void normalize() {
+        if (range < TOP_VALUE) {
+            range <<= 8;
+            code = (code << 8) | next();
+        }
+    }
+
+    inline int decodeBit(uint16_t &prob) {
+        uint32_t bound = (range >> NUM_PROB_BITS) * prob;
+        int bit;
+        if (code < bound) {
+            range = bound;
+            prob += ((1 << NUM_PROB_BITS) - prob) >> NUM_MOVE_BITS;
+            bit = 0;
+        } else {
+            range -= bound;
+            code -= bound;
+            prob -= prob >> NUM_MOVE_BITS;
+            bit = 1;
+        }
+        normalize();
+        return bit;
+    }
+
+    inline uint32_t decodeDirect(int numBits) {
+        uint32_t result = 0;
+        for (int i = 0; i < numBits; i++) {
+            range >>= 1;
+            uint32_t bit = code >= range ? 1 : 0;
+            if (bit) {
+                code -= range;
+            }
+            result = (result << 1) | bit;
+            normalize();
+        }
+        return result;
+    }
+
+    inline uint32_t decodeTree(uint16_t *probs, int numBits) {
+        uint32_t m = 1;
+        for (int i = 0; i < numBits; i++) {
+            m = (m << 1) | decodeBit(probs[m]);
+        }
+        return m - (1 << numBits);
+    }
+};
+
+} // namespace lzr
+
+int lzrDecompress(const uint8_t *src, int srcSize, uint8_t *dst, int dstSize) {
+    using namespace lzr;
+
+    static Model model;
+    initModel(model);
+
+    RangeDecoder rc;
+    rc.init(src, srcSize);
+
+    int op = 0;
+    int prevMatch = 0;
+
+    while (op < dstSize) {
+        if (!rc.decodeBit(model.isMatch[prevMatch])) {
+            int context = op > 0 ? dst[op - 1] >> 5 : 0;
+            dst[op++] = (uint8_t)rc.decodeTree(model.literal[context], 8);
+            prevMatch = 0;
+        } else {
+            uint32_t length;
+            if (!rc.decodeBit(model.lengthChoice)) {
+                length = rc.decodeTree(model.lengthLow, 3);
+            } else if (!rc.decodeBit(model.lengthChoice2)) {
+                length = 8 + rc.decodeTree(model.lengthMid, 3);
+            } else {
+                length = 16 + rc.decodeTree(model.lengthHigh, 8);
+            }
+
+            int lengthContext = length < NUM_LENGTH_CONTEXTS ? length : NUM_LENGTH_CONTEXTS - 1;
+            uint32_t slot = rc.decodeTree(model.distanceSlot[lengthContext], NUM_DISTANCE_SLOT_BITS);
+            uint32_t dist;
+            if (slot < 4) {
+                dist = slot;
+            } else {
+                int footerBits = (slot >> 1) - 1;
+                dist = ((2 | (slot & 1)) << footerBits) + rc.decodeDirect(footerBits);
+            }
+
+            length += MIN_MATCH;
+            uint32_t distance = dist + 1;
+            if (distance > (uint32_t)op || length > (uint32_t)(dstSize - op)) {
+                return -1;
+            }
+
+            const uint8_t *match = dst + op - distance;
+            for (uint32_t i = 0; i < length; i++) {
+                dst[op + i] = match[i];
+            }
+            op += length;
+            prevMatch = 1;
+        }
+
+        if (rc.error) {
+            return -1;
+        }
+    }
+
+    return op;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char *getCodecName(int codec) {
+    if (codec == CODEC_STORED) {
+        return "stored";
+    }
+    if (codec == CODEC_LZ4) {
+        return "lz4";
+    }
+    if (codec == CODEC_LZR) {
+        return "lzr";
+    }
+    return "unknown";
+}
+
+bool decompress(int codec, const uint8_t *src, int srcSize, uint8_t *dst, int dstSize) {
+    if (codec == CODEC_STORED) {
+        if (srcSize != dstSize) {
+            return false;
+        }
+        memcpy(dst, src, dstSize);
+        return true;
+    }
+
+    if (codec == CODEC_LZ4) {
+        return lz4DecompressFast(src, srcSize, dst, dstSize) == dstSize;
+    }
+
+    if (codec == CODEC_LZR) {
+        return lzrDecompress(src, srcSize, dst, dstSize) == dstSize;
+    }
+
+    return false;
+}
+
+} // namespace assets_codec
+} // namespace gui
+} // namespace eez
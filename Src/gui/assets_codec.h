@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+namespace gui {
+namespace assets_codec {
+
+// Decoders for the compressed asset data. Used at runtime and by the host
+// asset tools, so there is no dependency on eez-framework.
+//
+// Codec is chosen per block of the block compressed assets (see
+// gui/lazy_assets.h) when assets are built, so blocks that are read at boot
+// can use the fast one and the rest the one with the better ratio:
+//
+//   CODEC_STORED  no compression
+//   CODEC_LZ4     LZ4 block format, same as the "~eez" assets from EEZ Studio
+//   CODEC_LZR     LZ77 with adaptive binary range coder (LZMA like),
+//                 better ratio, several times slower to decode
+
+enum Codec {
+    CODEC_STORED,
+    CODEC_LZ4,
+    CODEC_LZR,
+
+    NUM_CODECS
+};
+
+const char *getCodecName(int codec);
+
+// Decompress to exactly dstSize bytes, returns false on malformed input.
+bool decompress(int codec, const uint8_t *src, int srcSize, uint8_t *dst, int dstSize);
+
+// Reference LZ4 decoder (same as LZ4_decompress_safe, byte by byte match
+// copy), returns number of decompressed bytes or -1 on malformed input.
+int lz4Decompress(const uint8_t *src, int srcSize, uint8_t *dst, int dstCapacity);
+
+// LZ4 decoder with 8 byte copies, used for CODEC_LZ4. Never writes past
+// dstCapacity, falls back to exact copies near the end of the output.
+int lz4DecompressFast(const uint8_t *src, int srcSize, uint8_t *dst, int dstCapacity);
+
+// LZR decoder, dstSize must be the exact decompressed size. Not reentrant,
+// probability model is static (about 5 KB).
+int lzrDecompress(const uint8_t *src, int srcSize, uint8_t *dst, int dstSize);
+
+////////////////////////////////////////////////////////////////////////////////
+// LZR format, shared by the decoder and the encoder in Src/tools
+
+namespace lzr {
+
+static const int NUM_PROB_BITS = 11;
+static const uint16_t PROB_INIT = 1 << (NUM_PROB_BITS - 1);
+static const int NUM_MOVE_BITS = 5;
+static const uint32_t TOP_VALUE = 1 << 24;
+
+static const int MIN_MATCH = 3;
+static const int MAX_MATCH = MIN_MATCH + 16 + 255;
+static const uint32_t MAX_DISTANCE = 65536;
+
+static const int NUM_LITERAL_CONTEXTS = 8; // previous byte >> 5
+static const int NUM_LENGTH_CONTEXTS = 4;
+static const int NUM_DISTANCE_SLOT_BITS = 6;
+
+struct Model {
+    uint16_t isMatch[2]; // previous was literal/match
+    uint16_t literal[NUM_LITERAL_CONTEXTS][256];
+    uint16_t lengthChoice;
+    uint16_t lengthChoice2;
+    uint16_t lengthLow[8];
+    uint16_t lengthMid[8];
+    uint16_t lengthHigh[256];
+    uint16_t distanceSlot[NUM_LENGTH_CONTEXTS][1 << NUM_DISTANCE_SLOT_BITS];
+};
+
+void initModel(Model &model);
+
+// Distance - 1 is coded as slot (bit tree) and footer bits (direct):
+// slot 0..3 is distance - 1 itself, otherwise slot encodes position of the
+// highest bit and the bit below it.
+inline int getDistanceSlot(uint32_t dist) {
+    if (dist < 4) {
+        return (int)dist;
+    }
+    int n = 2;
+    while (dist >> (n + 1)) {
+        n++;
+    }
+    return 2 * n + ((dist >> (n - 1)) & 1);
+}
+
+} // namespace lzr
+
+} // namespace assets_codec
+} // namespace gui
+} // namespace eez
@@ -0,0 +1,78 @@
+#include "eez-framework-conf.h"
+
+#if OPTION_ASSETS_XIP
+
+#if defined(EEZ_PLATFORM_STM32)
+#include "main.h"
+#include "stm32469i_discovery_qspi.h"
+#endif
+
+#include <eez/core/debug.h>
+#include <eez/core/memory.h>
+#include <eez/gui/assets.h>
+
+#include "assets_xip.h"
+
+namespace eez {
+namespace gui {
+
+// generated by Src/tools/assets_xip_gen
+extern const uint8_t xip_assets[];
+
+namespace assets_xip {
+
+// initAssetsMemory() reserves the decompressed assets region as the first
+// allocBuffer() of the framework, so while nothing else is allocated after
+// it, the region is given back by moving the start of free memory back.
+static void releaseDecompressedAssetsMemory() {
+    uint32_t reserved = ALLOC_BUFFER - DECOMPRESSED_ASSETS_START_ADDRESS;
+    if (reserved < MAX_DECOMPRESSED_ASSETS_SIZE || reserved >= MAX_DECOMPRESSED_ASSETS_SIZE + 1024) {
+        DebugTrace("XIP assets: decompressed assets region not released\n");
+        return;
+    }
+
+    ALLOC_BUFFER = DECOMPRESSED_ASSETS_START_ADDRESS;
+    ALLOC_BUFFER_SIZE += reserved;
+}
+
+bool loadMainAssets() {
+#if defined(EEZ_PLATFORM_STM32)
+    if (BSP_QSPI_Init() != QSPI_OK) {
+        DebugTrace("QSPI init failed\n");
+        return false;
+    }
+
+    if (BSP_QSPI_EnableMemoryMappedMode() != QSPI_OK) {
+        DebugTrace("QSPI memory-mapped mode failed\n");
+        return false;
+    }
+#endif
+
+    auto header = (const Header *)xip_assets;
+    if (header->tag != HEADER_TAG || header->assetsSize <= ASSETS_PREFIX_SIZE) {
+        // QSPI is not programmed or it is programmed with some other data
+        DebugTrace("XIP assets not found\n");
+        return false;
+    }
+
+    auto assets = (Assets *)(xip_assets + sizeof(Header));
+    if (assets->projectMajorVersion != header->projectMajorVersion || assets->projectMinorVersion != header->projectMinorVersion) {
+        DebugTrace("XIP assets header mismatch\n");
+        return false;
+    }
+
+    // Assets use self-relative pointers, so they can be used from any
+    // address. They must not be modified, QSPI is read-only.
+    g_mainAssets = assets;
+    g_isMainAssetsLoaded = true;
+
+    releaseDecompressedAssetsMemory();
+
+    return true;
+}
+
+} // namespace assets_xip
+} // namespace gui
+} // namespace eez
+
+#endif // OPTION_ASSETS_XIP
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+namespace gui {
+namespace assets_xip {
+
+// Execute-in-place assets (OPTION_ASSETS_XIP). Assets are stored
+// uncompressed in the memory-mapped QSPI flash and g_mainAssets points
+// directly to them, so nothing is decompressed at boot and the compressed
+// assets[] array isn't linked into internal flash. The decompressed assets
+// region reserved in SDRAM by initAssetsMemory() of eez-framework is given
+// back to the buffers allocated after it and to the alloc heap.
+//
+// Image is generated from gui/document.cpp by Src/tools/assets_xip_gen
+// into gui/document_xip.cpp and placed in .qspi_assets section:
+//
+//   Header
+//   Assets (projectMajorVersion, projectMinorVersion, reserved, external,
+//           followed by decompressed data starting with settings)
+
+// "~xip"
+static const uint32_t HEADER_TAG = 0x7069787E;
+
+struct Header {
+    uint32_t tag;
+    uint16_t projectMajorVersion;
+    uint16_t projectMinorVersion;
+    uint32_t assetsSize;
+    uint32_t reserved;
+};
+
+// size of Assets fields before settings
+static const uint32_t ASSETS_PREFIX_SIZE = 8;
+
+// Enables QSPI memory-mapped mode (STM32), checks the image once and sets
+// g_mainAssets to it. Returns false if QSPI is not available or the image
+// is not valid. Must be called between initAssetsMemory() and
+// initOtherMemory(), the decompressed assets region is released here.
+//
+// eez::gui::loadMainAssets() always decompresses into the decompressed
+// assets region, it has no way to take assets in place, so g_mainAssets
+// and g_isMainAssetsLoaded are set here.
+bool loadMainAssets();
+
+} // namespace assets_xip
+} // namespace gui
+} // namespace eez
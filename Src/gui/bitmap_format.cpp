@@ -0,0 +1,64 @@
+#if defined(EEZ_PLATFORM_STM32)
+#include "main.h"
+#endif
+
+#include "bitmap_format.h"
+
+namespace eez {
+namespace gui {
+namespace bitmap_format {
+
+#if defined(EEZ_PLATFORM_STM32)
+
+static inline void waitDMA2D() {
+    while (DMA2D->CR & DMA2D_CR_START) {
+    }
+}
+
+void drawBitmapRgb565(uint16_t *buffer, int stride, const Rect &clip,
+    int bpp, int width, int height, int lineOffset, const uint8_t *pixels, int x, int y) {
+    Rect rect = { x, y, x + width - 1, y + height - 1 };
+    if (!intersect(rect, clip)) {
+        return;
+    }
+
+    waitDMA2D();
+
+    if (bpp != BPP_RGB565 && bpp != BPP_ARGB8888) {
+        drawBitmap<pixel_format::Rgb565>(buffer, stride, clip, bpp, width, height, lineOffset, pixels, x, y);
+        return;
+    }
+
+    auto dst = buffer + rect.y1 * stride + rect.x1;
+    int srcStride = width + lineOffset;
+    int srcOffset = (rect.y1 - y) * srcStride + (rect.x1 - x);
+    int drawWidth = rect.x2 - rect.x1 + 1;
+    int drawHeight = rect.y2 - rect.y1 + 1;
+
+    if (bpp == BPP_RGB565) {
+        DMA2D->CR = DMA2D_M2M;
+        DMA2D->FGMAR = (uint32_t)((const uint16_t *)pixels + srcOffset);
+        DMA2D->FGOR = srcStride - drawWidth;
+        DMA2D->FGPFCCR = DMA2D_INPUT_RGB565;
+    } else {
+        DMA2D->CR = DMA2D_M2M_BLEND;
+        DMA2D->FGMAR = (uint32_t)(pixels + 4 * srcOffset);
+        DMA2D->FGOR = srcStride - drawWidth;
+        DMA2D->FGPFCCR = DMA2D_INPUT_ARGB8888;
+        DMA2D->BGMAR = (uint32_t)dst;
+        DMA2D->BGOR = stride - drawWidth;
+        DMA2D->BGPFCCR = DMA2D_INPUT_RGB565;
+    }
+
+    DMA2D->OMAR = (uint32_t)dst;
+    DMA2D->OOR = stride - drawWidth;
+    DMA2D->OPFCCR = DMA2D_OUTPUT_RGB565;
+    DMA2D->NLR = (uint32_t)((drawWidth << DMA2D_NLR_PL_Pos) | drawHeight);
+    DMA2D->CR |= DMA2D_CR_START;
+}
+
+#endif
+
+} // namespace bitmap_format
+} // namespace gui
+} // namespace eez
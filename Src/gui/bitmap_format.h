@@ -0,0 +1,161 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "pixel_format.h"
+
+namespace eez {
+namespace gui {
+namespace bitmap_format {
+
+// Bitmap pixel formats, stored in the bpp field of the bitmap in assets.
+// 16 and 32 are the formats EEZ Studio writes and eez-framework draws. The
+// other two are written by tools/assets_bitmap_gen, already in the STM32
+// frame buffer format, and are drawn by display list backends (see
+// display_list_exec.cpp and the simulator tile rasterizer):
+//
+//   BPP_RGB565_A8   width * height RGB565 colors followed by width * height
+//                   A8 alpha values
+//   BPP_RLE_RGB565  (height + 1) uint32_t row offsets from the start of the
+//                   pixels, last one is the end of data, then rows of
+//                   uint16_t tokens: bit 15 set is run of (token & 0x7FFF) + 1
+//                   pixels followed by one color, otherwise that many
+//                   literal colors follow
+//
+// New formats don't support line offset (sub-images).
+static const int BPP_RGB565 = 16;
+static const int BPP_RGB565_A8 = 24;
+static const int BPP_ARGB8888 = 32;
+static const int BPP_RLE_RGB565 = 0x80 | 16;
+
+static const uint16_t RLE_RUN = 0x8000;
+static const int RLE_MAX_COUNT = 0x8000;
+
+inline bool isExtendedFormat(int bpp) {
+    return bpp == BPP_RGB565_A8 || bpp == BPP_RLE_RGB565;
+}
+
+// Size of the pixel data in bytes.
+inline uint32_t getPixelsSize(int bpp, int width, int height, const uint8_t *pixels) {
+    if (bpp == BPP_RLE_RGB565) {
+        uint32_t end;
+        memcpy(&end, pixels + 4 * height, 4);
+        return end;
+    }
+    return bpp == BPP_RGB565_A8 ? 3 * width * height : width * height * bpp / 8;
+}
+
+struct Rect {
+    int x1;
+    int y1;
+    int x2; // inclusive
+    int y2; // inclusive
+};
+
+inline bool intersect(Rect &rect, const Rect &clip) {
+    if (rect.x1 < clip.x1) rect.x1 = clip.x1;
+    if (rect.y1 < clip.y1) rect.y1 = clip.y1;
+    if (rect.x2 > clip.x2) rect.x2 = clip.x2;
+    if (rect.y2 > clip.y2) rect.y2 = clip.y2;
+    return rect.x1 <= rect.x2 && rect.y1 <= rect.y2;
+}
+
+template <typename Format>
+void drawRgb565A8(typename Format::Pixel *dst, int dstStride, const uint8_t *pixels, int width, int height,
+    int srcX, int srcY, int drawWidth, int drawHeight) {
+    auto colors = (const uint16_t *)pixels + srcY * width + srcX;
+    auto alphas = pixels + 2 * width * height + srcY * width + srcX;
+    for (int y = 0; y < drawHeight; y++, dst += dstStride, colors += width, alphas += width) {
+        for (int x = 0; x < drawWidth; x++) {
+            uint32_t alpha = alphas[x];
+            if (alpha == 255) {
+                dst[x] = Format::fromColor16(colors[x]);
+            } else if (alpha) {
+                dst[x] = Format::blend(dst[x], Format::fromColor16(colors[x]), alpha);
+            }
+        }
+    }
+}
+
+template <typename Format>
+void drawRleRgb565(typename Format::Pixel *dst, int dstStride, const uint8_t *pixels,
+    int srcX, int srcY, int drawWidth, int drawHeight) {
+    for (int y = 0; y < drawHeight; y++, dst += dstStride) {
+        uint32_t rowOffset;
+        memcpy(&rowOffset, pixels + 4 * (srcY + y), 4);
+        auto token = (const uint16_t *)(pixels + rowOffset);
+
+        // x is the column of the current token in the source row
+        int x = 0;
+        while (x < srcX + drawWidth) {
+            int count = (*token & 0x7FFF) + 1;
+            bool run = (*token & RLE_RUN) != 0;
+            token++;
+
+            int from = x > srcX ? x : srcX;
+            int to = x + count < srcX + drawWidth ? x + count : srcX + drawWidth;
+            if (from < to) {
+                if (run) {
+                    pixel_format::fillSpan<Format>(dst + from - srcX, to - from, Format::fromColor16(*token));
+                } else {
+                    for (int i = from; i < to; i++) {
+                        dst[i - srcX] = Format::fromColor16(token[i - x]);
+                    }
+                }
+            }
+
+            token += run ? 1 : count;
+            x += count;
+        }
+    }
+}
+
+// Software drawing of any of the formats above at (x, y), only the part
+// inside clip is drawn. Returns false for unknown format.
+template <typename Format>
+bool drawBitmap(typename Format::Pixel *buffer, int stride, const Rect &clip,
+    int bpp, int width, int height, int lineOffset, const uint8_t *pixels, int x, int y) {
+    Rect rect = { x, y, x + width - 1, y + height - 1 };
+    if (!intersect(rect, clip)) {
+        return true;
+    }
+
+    auto dst = buffer + rect.y1 * stride + rect.x1;
+    int srcX = rect.x1 - x;
+    int srcY = rect.y1 - y;
+    int drawWidth = rect.x2 - rect.x1 + 1;
+    int drawHeight = rect.y2 - rect.y1 + 1;
+    int srcStride = width + lineOffset;
+
+    switch (bpp) {
+    case BPP_RGB565:
+        pixel_format::blit<Format, pixel_format::Rgb565>(dst, stride,
+            (const uint16_t *)pixels + srcY * srcStride + srcX, srcStride, drawWidth, drawHeight);
+        return true;
+    case BPP_ARGB8888:
+        pixel_format::blitBlend<Format>(dst, stride, pixels + (srcY * srcStride + srcX) * 4, srcStride, drawWidth, drawHeight);
+        return true;
+    case BPP_RGB565_A8:
+        drawRgb565A8<Format>(dst, stride, pixels, width, height, srcX, srcY, drawWidth, drawHeight);
+        return true;
+    case BPP_RLE_RGB565:
+        drawRleRgb565<Format>(dst, stride, pixels, srcX, srcY, drawWidth, drawHeight);
+        return true;
+    }
+
+    return false;
+}
+
+#if defined(EEZ_PLATFORM_STM32)
+// RGB565 is copied by DMA2D M2M and ARGB8888 blended by DMA2D M2M_BLEND.
+// DMA2D can't take alpha from a separate plane or decode runs, so
+// RGB565_A8 and RLE are drawn by the CPU after DMA2D is idle, without any
+// format conversion.
+void drawBitmapRgb565(uint16_t *buffer, int stride, const Rect &clip,
+    int bpp, int width, int height, int lineOffset, const uint8_t *pixels, int x, int y);
+#endif
+
+} // namespace bitmap_format
+} // namespace gui
+} // namespace eez
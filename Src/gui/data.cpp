@@ -5,8 +5,12 @@
 #include <eez/gui/gui.h>
 #include <eez/gui/draw.h>
 
+#include "eez-framework-conf.h"
+
 #include "../date_time.h"
 #include "../firmware.h"
+#include "data_batch.h"
+#include "data_versions.h"
 
 namespace eez {
 namespace gui {
@@ -14,36 +18,53 @@ namespace gui {
 const EnumItem *g_enumDefinitions[] = { nullptr };
 
 void data_date_year(DataOperationEnum operation, const WidgetCursor &widgetCursor, Value &value) {
-    value = date_time::g_dateTime.year + 2000;
+    value = date_time::getTickDateTime().year + 2000;
 }
 
 void data_date_month(DataOperationEnum operation, const WidgetCursor &widgetCursor, Value &value) {
-    value = date_time::g_dateTime.month;
+    value = date_time::getTickDateTime().month;
 }
 
 void data_date_day(DataOperationEnum operation, const WidgetCursor &widgetCursor, Value &value) {
-    value = date_time::g_dateTime.day;
+    value = date_time::getTickDateTime().day;
 }
 
 void data_time_hour(DataOperationEnum operation, const WidgetCursor &widgetCursor, Value &value) {
-    value = date_time::g_dateTime.hour;
+    value = date_time::getTickDateTime().hour;
 }
 
 void data_time_minute(DataOperationEnum operation, const WidgetCursor &widgetCursor, Value &value) {
-    value = date_time::g_dateTime.minute;
+    value = date_time::getTickDateTime().minute;
 }
 
 void data_time_second(DataOperationEnum operation, const WidgetCursor &widgetCursor, Value &value) {
-    value = date_time::g_dateTime.second;
+    value = date_time::getTickDateTime().second;
 }
 
 void data_time_sub_second(DataOperationEnum operation, const WidgetCursor &widgetCursor, Value &value) {
-    value = date_time::g_dateTime.subSecond;
+    value = date_time::getTickDateTime().subSecond;
 }
 
 void data_temperature(DataOperationEnum operation, const WidgetCursor &widgetCursor, Value &value) {
+#if OPTION_DATA_BATCH
+    if (operation == DATA_OPERATION_GET && data_batch::get(DATA_ID_TEMPERATURE, value)) {
+        return;
+    }
+#endif
     value = Value(g_temperature, VALUE_TYPE_FLOAT);
 }
 
+namespace data_versions {
+
+bool getDataVersionId(int16_t dataId, VersionId &versionId) {
+    if (dataId == DATA_ID_TEMPERATURE) {
+        versionId = VERSION_TEMPERATURE;
+        return true;
+    }
+    return false;
+}
+
+} // namespace data_versions
+
 } // namespace gui
 } // namespace eez
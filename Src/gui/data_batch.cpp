@@ -0,0 +1,103 @@
+#include "eez-framework-conf.h"
+
+#if OPTION_DATA_BATCH
+
+#include <eez/gui/gui.h>
+
+#include "data_batch.h"
+#include "data_versions.h"
+
+namespace eez {
+namespace gui {
+
+extern DataOperationsFunction g_dataOperationsFunctions[];
+
+namespace data_batch {
+
+// struct of arrays, one slot per distinct data ID
+static int16_t g_dataIds[DATA_BATCH_MAX_VALUES];
+static Value g_values[DATA_BATCH_MAX_VALUES];
+static uint32_t g_seenVersions[DATA_BATCH_MAX_VALUES]; // version + 1, 0 is never evaluated
+static uint8_t g_versionIds[DATA_BATCH_MAX_VALUES];    // NUM_VERSIONS if not versioned
+static bool g_changed[DATA_BATCH_MAX_VALUES];
+static uint32_t g_numValues;
+
+static uint8_t g_slots[DATA_BATCH_MAX_DATA_ID]; // data ID -> slot + 1, 0 if not in the batch
+
+// top level cursor the data functions are called with
+static WidgetCursor g_widgetCursor;
+
+// data functions are called from evaluate() for their own value
+static bool g_isEvaluating;
+
+Stats g_stats;
+
+static bool isValidDataId(int16_t dataId) {
+    return dataId > 0 && dataId < (int16_t)DATA_BATCH_MAX_DATA_ID;
+}
+
+void addDataId(int16_t dataId) {
+    if (!isValidDataId(dataId) || g_slots[dataId] != 0 || g_numValues == DATA_BATCH_MAX_VALUES) {
+        return;
+    }
+
+    uint32_t slot = g_numValues++;
+    g_slots[dataId] = (uint8_t)(slot + 1);
+    g_dataIds[slot] = dataId;
+    g_seenVersions[slot] = 0;
+    g_changed[slot] = false;
+
+    data_versions::VersionId versionId;
+    g_versionIds[slot] = data_versions::getDataVersionId(dataId, versionId) ? (uint8_t)versionId : (uint8_t)data_versions::NUM_VERSIONS;
+
+    g_stats.numDataIds = g_numValues;
+}
+
+void evaluate(AppContext *appContext) {
+    g_widgetCursor.appContext = appContext;
+    g_isEvaluating = true;
+
+    for (uint32_t slot = 0; slot < g_numValues; slot++) {
+        if (g_versionIds[slot] != data_versions::NUM_VERSIONS) {
+            uint32_t version = data_versions::getVersion((data_versions::VersionId)g_versionIds[slot]) + 1;
+            if (version == g_seenVersions[slot]) {
+                g_changed[slot] = false;
+                g_stats.skipped++;
+                continue;
+            }
+            g_seenVersions[slot] = version;
+        }
+
+        Value value;
+        g_dataOperationsFunctions[g_dataIds[slot]](DATA_OPERATION_GET, g_widgetCursor, value);
+        g_stats.evaluations++;
+
+        g_changed[slot] = value != g_values[slot];
+        if (g_changed[slot]) {
+            g_values[slot] = value;
+        }
+    }
+
+    g_isEvaluating = false;
+}
+
+bool get(int16_t dataId, Value &value) {
+    if (g_isEvaluating || !isValidDataId(dataId) || g_slots[dataId] == 0) {
+        return false;
+    }
+    value = g_values[g_slots[dataId] - 1];
+    return true;
+}
+
+bool hasChanged(int16_t dataId) {
+    if (!isValidDataId(dataId) || g_slots[dataId] == 0) {
+        return true;
+    }
+    return g_changed[g_slots[dataId] - 1];
+}
+
+} // namespace data_batch
+} // namespace gui
+} // namespace eez
+
+#endif // OPTION_DATA_BATCH
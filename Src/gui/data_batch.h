@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <eez/gui/gui.h>
+
+namespace eez {
+namespace gui {
+namespace data_batch {
+
+// Data evaluated in one pass per frame (OPTION_DATA_BATCH). Data IDs added
+// with addDataId() are kept in a compact array; every frame evaluate()
+// calls g_dataOperationsFunctions[] once per data ID, with one top level
+// WidgetCursor built once, and stores the values side by side. Data
+// functions in gui/data.cpp return the value from get(), a table lookup,
+// when eez-framework calls them for a widget or a flow expression, so the
+// value is computed once per frame however many times it is read.
+//
+// Versioned data (gui/data_versions.h) is evaluated only when its version
+// changed. Only data functions of this tree can read from the batch, and
+// in this project that is DATA_ID_TEMPERATURE, the rest of the page data
+// (keypad, alert message) belongs to eez-framework and is evaluated by it,
+// so the page's data IDs are not collected.
+
+void addDataId(int16_t dataId);
+
+// Call once per frame before the page is drawn.
+void evaluate(AppContext *appContext);
+
+// False if the data ID is not in the batch or evaluate() is running, the
+// data function then computes the value itself.
+bool get(int16_t dataId, Value &value);
+
+// True if the value changed in the last evaluate().
+bool hasChanged(int16_t dataId);
+
+struct Stats {
+    uint32_t numDataIds;
+    uint32_t evaluations; // data function calls
+    uint32_t skipped;     // versioned data with unchanged version
+};
+
+extern Stats g_stats;
+
+} // namespace data_batch
+} // namespace gui
+} // namespace eez
@@ -0,0 +1,11 @@
+#include "data_versions.h"
+
+namespace eez {
+namespace gui {
+namespace data_versions {
+
+volatile uint32_t g_versions[NUM_VERSIONS];
+
+} // namespace data_versions
+} // namespace gui
+} // namespace eez
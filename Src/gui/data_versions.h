@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+namespace gui {
+namespace data_versions {
+
+// Version counters of the values behind the data functions in data.cpp.
+// Producers (date_time::tick, temperature reading in tasks.cpp) bump the
+// version only when the value really changed, so a reader can check in O(1)
+// whether the value changed, without calling the data function and
+// comparing the Value it builds. data_batch.cpp uses it to evaluate a batched
+// data function only after its version changed.
+//
+// Widgets are not notified: eez-framework evaluates the data of each widget
+// and compares the Value on every frame, and has no hook to tell a widget
+// its value changed.
+enum VersionId {
+    VERSION_DATE,       // data_date_year, data_date_month, data_date_day
+    VERSION_TIME,       // data_time_hour, data_time_minute, data_time_second
+    VERSION_SUB_SECOND, // data_time_sub_second
+    VERSION_TEMPERATURE,
+    NUM_VERSIONS
+};
+
+// Written by the producer thread, read by the GUI thread. 32-bit store is
+// atomic on Cortex-M4, a reader sees either the old or the new version.
+extern volatile uint32_t g_versions[NUM_VERSIONS];
+
+inline uint32_t getVersion(VersionId versionId) {
+    return g_versions[versionId];
+}
+
+inline void bumpVersion(VersionId versionId) {
+    g_versions[versionId] = g_versions[versionId] + 1;
+}
+
+// Stores the value and bumps the version if it is different.
+template <typename T>
+inline bool set(VersionId versionId, T &stored, const T &value) {
+    if (stored == value) {
+        return false;
+    }
+    stored = value;
+    bumpVersion(versionId);
+    return true;
+}
+
+// Version of the data ID from document.h, false if the data is not
+// versioned and has to be evaluated every frame. Defined in data.cpp next
+// to the data functions.
+bool getDataVersionId(int16_t dataId, VersionId &versionId);
+
+} // namespace data_versions
+} // namespace gui
+} // namespace eez
@@ -0,0 +1,539 @@
+#include <string.h>
+
+#include "eez-framework-conf.h"
+
+#include "display_list.h"
+
+namespace eez {
+namespace gui {
+namespace display_list {
+
+struct WidgetEntry {
+    uint32_t widgetKey;
+    uint32_t dependencyHash;
+    uint16_t firstCommand;
+    uint16_t numCommands;
+    bool valid;
+    bool recorded; // in this frame, not replayed
+    bool indexed;  // false for the second widget with the same key
+    ExecuteCommandFunc execute;
+    Rect bounds;   // of all commands
+};
+
+struct Damage {
+    Rect rects[DISPLAY_LIST_MAX_DAMAGE_RECTS];
+    uint32_t numRects;
+};
+
+static const uint32_t INDEX_SIZE = 2 * DISPLAY_LIST_MAX_WIDGETS;
+static const int16_t INDEX_EMPTY = -1;
+
+// Commands are built into one frame while the other one holds the previous
+// frame, so replaying a widget is a copy of its commands into the new frame.
+struct Frame {
+    Command commands[DISPLAY_LIST_MAX_COMMANDS];
+    uint32_t numCommands;
+
+    WidgetEntry widgets[DISPLAY_LIST_MAX_WIDGETS];
+    uint32_t numWidgets;
+
+    int16_t index[INDEX_SIZE];
+
+    char textPool[DISPLAY_LIST_TEXT_POOL_SIZE];
+    uint32_t textPoolSize;
+
+    // false if something didn't fit and was drawn immediately, also before
+    // the first frame
+    bool complete;
+};
+
+static Frame g_frames[2];
+static Frame *g_prevFrame = &g_frames[0];
+static Frame *g_frame = &g_frames[1];
+
+static WidgetEntry *g_recordingWidget;
+static bool g_overflow;
+static bool g_replaying;
+static ExecuteCommandFunc g_execute = executeCommand;
+
+static const Rect DISPLAY_RECT = { 0, 0, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1 };
+static const Rect EMPTY_RECT = { 0, 0, -1, -1 };
+
+// damage of the last frames drawn into each frame buffer
+static Damage g_damageHistory[DISPLAY_LIST_BUFFER_AGE];
+static uint32_t g_frameIndex;
+
+// what endFrame() redraws
+static Damage g_damage;
+
+Stats g_stats;
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t hashBytes(const void *data, size_t length, uint32_t hash) {
+    auto p = (const uint8_t *)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+uint32_t hashUint32(uint32_t value, uint32_t hash) {
+    return hashBytes(&value, sizeof(value), hash);
+}
+
+uint32_t hashString(const char *str, uint32_t hash) {
+    if (!str) {
+        return hashUint32(0, hash);
+    }
+    return hashBytes(str, strlen(str), hash);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static inline bool isEmpty(const Rect &rect) {
+    return rect.x1 > rect.x2 || rect.y1 > rect.y2;
+}
+
+static inline bool intersects(const Rect &a, const Rect &b) {
+    return a.x1 <= b.x2 && b.x1 <= a.x2 && a.y1 <= b.y2 && b.y1 <= a.y2;
+}
+
+static inline Rect unite(const Rect &a, const Rect &b) {
+    if (isEmpty(a)) {
+        return b;
+    }
+    if (isEmpty(b)) {
+        return a;
+    }
+    return Rect{
+        a.x1 < b.x1 ? a.x1 : b.x1,
+        a.y1 < b.y1 ? a.y1 : b.y1,
+        a.x2 > b.x2 ? a.x2 : b.x2,
+        a.y2 > b.y2 ? a.y2 : b.y2
+    };
+}
+
+static inline uint32_t getArea(const Rect &rect) {
+    return isEmpty(rect) ? 0 : (uint32_t)(rect.x2 - rect.x1 + 1) * (rect.y2 - rect.y1 + 1);
+}
+
+static Rect getBounds(const Command &command) {
+    switch (command.type) {
+    case COMMAND_HLINE:
+        return Rect{ command.x1, command.y1, (int16_t)(command.x1 + command.x2), command.y1 };
+    case COMMAND_VLINE:
+        return Rect{ command.x1, command.y1, command.x1, (int16_t)(command.y1 + command.x2) };
+    default:
+        return Rect{ command.x1, command.y1, command.x2, command.y2 };
+    }
+}
+
+// Overlapping rects are merged, so no pixel is drawn twice. When the list
+// is full, the rect is merged with the one which grows the least.
+static void addDamage(Damage &damage, Rect rect) {
+    if (rect.x1 < 0) rect.x1 = 0;
+    if (rect.y1 < 0) rect.y1 = 0;
+    if (rect.x2 > DISPLAY_RECT.x2) rect.x2 = DISPLAY_RECT.x2;
+    if (rect.y2 > DISPLAY_RECT.y2) rect.y2 = DISPLAY_RECT.y2;
+    if (isEmpty(rect)) {
+        return;
+    }
+
+    for (;;) {
+        uint32_t i;
+        for (i = 0; i < damage.numRects; i++) {
+            if (intersects(damage.rects[i], rect)) {
+                break;
+            }
+        }
+
+        if (i == damage.numRects) {
+            if (damage.numRects < DISPLAY_LIST_MAX_DAMAGE_RECTS) {
+                damage.rects[damage.numRects++] = rect;
+                return;
+            }
+
+            uint32_t minGrowth = UINT32_MAX;
+            for (uint32_t j = 0; j < damage.numRects; j++) {
+                uint32_t growth = getArea(unite(damage.rects[j], rect)) - getArea(damage.rects[j]);
+                if (growth < minGrowth) {
+                    minGrowth = growth;
+                    i = j;
+                }
+            }
+        }
+
+        rect = unite(rect, damage.rects[i]);
+        damage.rects[i] = damage.rects[--damage.numRects];
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t indexSlot(uint32_t widgetKey) {
+    return (widgetKey * 2654435761u) & (INDEX_SIZE - 1);
+}
+
+static WidgetEntry *findWidget(Frame *frame, uint32_t widgetKey) {
+    for (uint32_t slot = indexSlot(widgetKey), i = 0; i < INDEX_SIZE; slot = (slot + 1) & (INDEX_SIZE - 1), i++) {
+        auto widgetIndex = frame->index[slot];
+        if (widgetIndex == INDEX_EMPTY || (uint32_t)widgetIndex >= frame->numWidgets) {
+            return nullptr;
+        }
+        if (frame->widgets[widgetIndex].widgetKey == widgetKey) {
+            return &frame->widgets[widgetIndex];
+        }
+    }
+    return nullptr;
+}
+
+// A widget with the key already in the frame isn't indexed, it can't be
+// found and replayed in the next frame.
+static WidgetEntry *addWidget(Frame *frame, uint32_t widgetKey, uint32_t dependencyHash, ExecuteCommandFunc execute, bool indexed) {
+    if (frame->numWidgets == DISPLAY_LIST_MAX_WIDGETS) {
+        return nullptr;
+    }
+
+    if (indexed) {
+        uint32_t slot = indexSlot(widgetKey);
+        while (frame->index[slot] != INDEX_EMPTY) {
+            slot = (slot + 1) & (INDEX_SIZE - 1);
+        }
+        frame->index[slot] = (int16_t)frame->numWidgets;
+    }
+
+    auto widget = &frame->widgets[frame->numWidgets++];
+    widget->widgetKey = widgetKey;
+    widget->dependencyHash = dependencyHash;
+    widget->firstCommand = (uint16_t)frame->numCommands;
+    widget->numCommands = 0;
+    widget->valid = indexed;
+    widget->recorded = true;
+    widget->indexed = indexed;
+    widget->execute = execute;
+    widget->bounds = EMPTY_RECT;
+    return widget;
+}
+
+static const char *copyText(Frame *frame, const char *text, int textLength) {
+    if (frame->textPoolSize + textLength > DISPLAY_LIST_TEXT_POOL_SIZE) {
+        return nullptr;
+    }
+    auto dst = frame->textPool + frame->textPoolSize;
+    memcpy(dst, text, textLength);
+    frame->textPoolSize += textLength;
+    return dst;
+}
+
+static bool appendCommand(Frame *frame, const Command &command) {
+    if (frame->numCommands == DISPLAY_LIST_MAX_COMMANDS) {
+        return false;
+    }
+
+    auto &dst = frame->commands[frame->numCommands];
+    dst = command;
+
+    if (command.type == COMMAND_GLYPH_RUN && command.textLength > 0) {
+        dst.text = copyText(frame, command.text, command.textLength);
+        if (!dst.text) {
+            return false;
+        }
+    }
+
+    frame->numCommands++;
+    return true;
+}
+
+static void stopRecording() {
+    if (g_recordingWidget) {
+        g_recordingWidget->numCommands = (uint16_t)(g_frame->numCommands - g_recordingWidget->firstCommand);
+        g_recordingWidget = nullptr;
+    }
+}
+
+// Executes commands of the widgets which intersect clip, in drawing order.
+static void executeWidgets(Frame *frame, const Rect &clip) {
+    for (uint32_t i = 0; i < frame->numWidgets; i++) {
+        auto &widget = frame->widgets[i];
+        if (!intersects(widget.bounds, clip)) {
+            continue;
+        }
+
+        g_replaying = !widget.recorded;
+        for (uint32_t j = 0; j < widget.numCommands; j++) {
+            auto &command = frame->commands[widget.firstCommand + j];
+            if (intersects(getBounds(command), clip)) {
+                widget.execute(command, clip);
+                g_stats.commandsExecuted++;
+            }
+        }
+        g_replaying = false;
+    }
+}
+
+// Display list is full, what is recorded so far is drawn now and the rest
+// of the frame is drawn as it comes.
+static void overflow() {
+    if (g_recordingWidget) {
+        // not all commands are stored, widget must be redrawn next time
+        g_recordingWidget->valid = false;
+        stopRecording();
+    }
+    if (!g_overflow) {
+        g_overflow = true;
+        g_stats.overflows++;
+        executeWidgets(g_frame, DISPLAY_RECT);
+    }
+}
+
+static void record(const Command &command) {
+    if (g_recordingWidget) {
+        if (appendCommand(g_frame, command)) {
+            g_recordingWidget->bounds = unite(g_recordingWidget->bounds, getBounds(command));
+            g_stats.commandsRecorded++;
+            return;
+        }
+        overflow();
+    }
+
+    g_execute(command, DISPLAY_RECT);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void beginFrame() {
+    g_frame->numCommands = 0;
+    g_frame->numWidgets = 0;
+    g_frame->textPoolSize = 0;
+    memset(g_frame->index, 0xFF, sizeof(g_frame->index));
+
+    g_recordingWidget = nullptr;
+    g_overflow = false;
+}
+
+bool beginWidget(uint32_t widgetKey, uint32_t dependencyHash, ExecuteCommandFunc execute) {
+    stopRecording();
+
+    g_execute = execute;
+
+    // same key drawn twice in one frame, only the first one is replayed
+    bool isDuplicate = findWidget(g_frame, widgetKey) != nullptr;
+
+    auto prevWidget = isDuplicate ? nullptr : findWidget(g_prevFrame, widgetKey);
+    bool canReplay = prevWidget && prevWidget->valid && prevWidget->dependencyHash == dependencyHash;
+
+    WidgetEntry *widget = nullptr;
+    if (!g_overflow) {
+        widget = addWidget(g_frame, widgetKey, dependencyHash, execute, !isDuplicate);
+        if (!widget) {
+            overflow();
+        }
+    }
+
+    if (canReplay) {
+        auto commands = g_prevFrame->commands + prevWidget->firstCommand;
+        uint32_t i = 0;
+
+        if (widget) {
+            while (i < prevWidget->numCommands && appendCommand(g_frame, commands[i])) {
+                i++;
+            }
+            widget->numCommands = (uint16_t)i;
+            widget->bounds = prevWidget->bounds;
+            widget->recorded = false;
+            if (i < prevWidget->numCommands) {
+                widget->valid = false;
+                overflow();
+            }
+        }
+
+        // what didn't fit is drawn immediately
+        g_replaying = true;
+        for (; i < prevWidget->numCommands; i++) {
+            execute(commands[i], DISPLAY_RECT);
+        }
+        g_replaying = false;
+
+        g_stats.widgetsReplayed++;
+        g_stats.commandsReplayed += prevWidget->numCommands;
+        return true;
+    }
+
+    g_recordingWidget = widget;
+    g_stats.widgetsRecorded++;
+    return false;
+}
+
+void endWidget() {
+    stopRecording();
+}
+
+bool isReplaying() {
+    return g_replaying;
+}
+
+void fillRect(uint16_t color, uint8_t opacity, int x1, int y1, int x2, int y2, int radius) {
+    Command command;
+    memset(&command, 0, sizeof(command));
+    command.type = COMMAND_FILL_RECT;
+    command.color = color;
+    command.opacity = opacity;
+    command.x1 = (int16_t)x1;
+    command.y1 = (int16_t)y1;
+    command.x2 = (int16_t)x2;
+    command.y2 = (int16_t)y2;
+    command.radius = (int16_t)radius;
+    record(command);
+}
+
+void drawHLine(uint16_t color, uint8_t opacity, int x, int y, int length) {
+    Command command;
+    memset(&command, 0, sizeof(command));
+    command.type = COMMAND_HLINE;
+    command.color = color;
+    command.opacity = opacity;
+    command.x1 = (int16_t)x;
+    command.y1 = (int16_t)y;
+    command.x2 = (int16_t)length;
+    record(command);
+}
+
+void drawVLine(uint16_t color, uint8_t opacity, int x, int y, int length) {
+    Command command;
+    memset(&command, 0, sizeof(command));
+    command.type = COMMAND_VLINE;
+    command.color = color;
+    command.opacity = opacity;
+    command.x1 = (int16_t)x;
+    command.y1 = (int16_t)y;
+    command.x2 = (int16_t)length;
+    record(command);
+}
+
+void drawGlyphRun(uint16_t color, uint8_t opacity, const void *fontData, const char *text, int textLength, int x, int y, int clipX1, int clipY1, int clipX2, int clipY2) {
+    if (textLength == -1) {
+        textLength = (int)strlen(text);
+    }
+
+    Command command;
+    memset(&command, 0, sizeof(command));
+    command.type = COMMAND_GLYPH_RUN;
+    command.color = color;
+    command.opacity = opacity;
+    command.x1 = (int16_t)clipX1;
+    command.y1 = (int16_t)clipY1;
+    command.x2 = (int16_t)clipX2;
+    command.y2 = (int16_t)clipY2;
+    command.textX = (int16_t)x;
+    command.textY = (int16_t)y;
+    command.textLength = (uint16_t)textLength;
+    command.asset = fontData;
+    command.text = text;
+    record(command);
+}
+
+void drawBitmap(const void *image, int x, int y, int width, int height) {
+    Command command;
+    memset(&command, 0, sizeof(command));
+    command.type = COMMAND_BITMAP;
+    command.opacity = 255;
+    command.x1 = (int16_t)x;
+    command.y1 = (int16_t)y;
+    command.x2 = (int16_t)(x + width - 1);
+    command.y2 = (int16_t)(y + height - 1);
+    command.asset = image;
+    record(command);
+}
+
+void invalidateWidget(uint32_t widgetKey) {
+    auto widget = findWidget(g_prevFrame, widgetKey);
+    if (widget) {
+        widget->valid = false;
+    }
+}
+
+void invalidateAll() {
+    for (uint32_t i = 0; i < g_prevFrame->numWidgets; i++) {
+        g_prevFrame->widgets[i].valid = false;
+    }
+    g_prevFrame->complete = false;
+}
+
+static void addFrameDamage(Damage &damage) {
+    if (g_overflow || !g_prevFrame->complete) {
+        addDamage(damage, DISPLAY_RECT);
+        return;
+    }
+
+    // recorded widgets at the new and the old place
+    for (uint32_t i = 0; i < g_frame->numWidgets; i++) {
+        auto &widget = g_frame->widgets[i];
+        auto prevWidget = widget.indexed ? findWidget(g_prevFrame, widget.widgetKey) : nullptr;
+        if (!prevWidget || widget.recorded) {
+            addDamage(damage, widget.bounds);
+            if (prevWidget) {
+                addDamage(damage, prevWidget->bounds);
+            }
+        }
+    }
+
+    // widgets which are gone
+    for (uint32_t i = 0; i < g_prevFrame->numWidgets; i++) {
+        auto &prevWidget = g_prevFrame->widgets[i];
+        if (!prevWidget.indexed || !findWidget(g_frame, prevWidget.widgetKey)) {
+            addDamage(damage, prevWidget.bounds);
+        }
+    }
+}
+
+void endFrame() {
+    stopRecording();
+
+    auto &frameDamage = g_damageHistory[g_frameIndex++ % DISPLAY_LIST_BUFFER_AGE];
+    frameDamage.numRects = 0;
+    addFrameDamage(frameDamage);
+
+    g_damage.numRects = 0;
+    for (uint32_t i = 0; i < DISPLAY_LIST_BUFFER_AGE; i++) {
+        for (uint32_t j = 0; j < g_damageHistory[i].numRects; j++) {
+            addDamage(g_damage, g_damageHistory[i].rects[j]);
+        }
+    }
+
+    if (!g_overflow) {
+        for (uint32_t i = 0; i < g_damage.numRects; i++) {
+            executeWidgets(g_frame, g_damage.rects[i]);
+        }
+    }
+    for (uint32_t i = 0; i < g_damage.numRects; i++) {
+        g_stats.damagedPixels += getArea(g_damage.rects[i]);
+    }
+
+    g_frame->complete = !g_overflow;
+
+    auto frame = g_prevFrame;
+    g_prevFrame = g_frame;
+    g_frame = frame;
+}
+
+void replayFrame(ExecuteCommandFunc execute) {
+    for (uint32_t i = 0; i < g_prevFrame->numCommands; i++) {
+        execute(g_prevFrame->commands[i], DISPLAY_RECT);
+    }
+}
+
+const Command *getFrameCommands(uint32_t &numCommands) {
+    numCommands = g_prevFrame->numCommands;
+    return g_prevFrame->commands;
+}
+
+const Rect *getDamage(uint32_t &numRects) {
+    numRects = g_damage.numRects;
+    return g_damage.rects;
+}
+
+} // namespace display_list
+} // namespace gui
+} // namespace eez
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace eez {
+namespace gui {
+namespace display_list {
+
+// Draw commands recorded per widget. Coordinates are absolute display
+// coordinates, colors are in the native 16-bit theme format (RGB565).
+//
+// Nothing in the firmware records into the display list: eez-framework
+// draws the widgets and has no hook around the draw of one widget, so the
+// widgets are still drawn in full by the framework. Recording, replay and
+// the damage redraw run only in tools/display_list_bench.
+enum CommandType {
+    COMMAND_FILL_RECT,
+    COMMAND_HLINE,
+    COMMAND_VLINE,
+    COMMAND_GLYPH_RUN,
+    COMMAND_BITMAP
+};
+
+struct Command {
+    uint8_t type;
+    uint8_t opacity;
+    uint16_t color;
+
+    // FILL_RECT: (x1, y1) - (x2, y2) with corner radius
+    // HLINE/VLINE: (x1, y1) start, length in x2
+    // GLYPH_RUN: (x1, y1) - (x2, y2) is clip rect, text origin in (textX, textY)
+    // BITMAP: (x1, y1) - (x2, y2) is bitmap rect
+    int16_t x1;
+    int16_t y1;
+    int16_t x2;
+    int16_t y2;
+    int16_t radius;
+
+    int16_t textX;
+    int16_t textY;
+    uint16_t textLength;
+
+    // GLYPH_RUN: FontData, BITMAP: Image (both live in assets memory)
+    const void *asset;
+
+    // GLYPH_RUN: text, copied into the display list text pool
+    const char *text;
+};
+
+struct Rect {
+    int16_t x1;
+    int16_t y1;
+    int16_t x2; // inclusive
+    int16_t y2; // inclusive
+};
+
+// Draws one command, only the part inside clip. Default implementation
+// (display_list_exec.cpp) draws through eez::gui::display, other backends
+// (e.g. tile rasterizer in the simulator) can execute the same commands with
+// their own function.
+typedef void (*ExecuteCommandFunc)(const Command &command, const Rect &clip);
+
+void executeCommand(const Command &command, const Rect &clip);
+
+// Cheap hash used to describe the data values a widget depended on when its
+// commands were recorded. Widgets are replayed while the hash is unchanged.
+uint32_t hashBytes(const void *data, size_t length, uint32_t hash = 2166136261u);
+uint32_t hashUint32(uint32_t value, uint32_t hash = 2166136261u);
+uint32_t hashString(const char *str, uint32_t hash = 2166136261u);
+
+// Drawing is deferred to endFrame(), which redraws only the damaged area:
+// widgets recorded in this frame, at their old and new place, and widgets
+// which are gone. Replayed widgets are drawn only where they overlap the
+// damage. Frame buffer is expected to keep what was drawn into it
+// DISPLAY_LIST_BUFFER_AGE frames ago, damage of that many frames is redrawn.
+void beginFrame();
+
+// Returns true if the widget was replayed from the previous frame. Otherwise
+// recording is started and the caller must draw the widget through the record
+// functions below, followed by endWidget(). If the same key is used twice in
+// a frame, the second widget is recorded every time.
+bool beginWidget(uint32_t widgetKey, uint32_t dependencyHash, ExecuteCommandFunc execute = executeCommand);
+void endWidget();
+
+// True while commands of a replayed widget are executed.
+bool isReplaying();
+
+// Records the command of the current widget. Outside of a widget, or when
+// the display list is full, the command is drawn immediately.
+void fillRect(uint16_t color, uint8_t opacity, int x1, int y1, int x2, int y2, int radius = 0);
+void drawHLine(uint16_t color, uint8_t opacity, int x, int y, int length);
+void drawVLine(uint16_t color, uint8_t opacity, int x, int y, int length);
+void drawGlyphRun(uint16_t color, uint8_t opacity, const void *fontData, const char *text, int textLength, int x, int y, int clipX1, int clipY1, int clipX2, int clipY2);
+void drawBitmap(const void *image, int x, int y, int width, int height);
+
+// Forces widget to be re-recorded in the next frame.
+void invalidateWidget(uint32_t widgetKey);
+
+// All widgets are re-recorded and the whole display is redrawn.
+void invalidateAll();
+
+// Executes the commands of the frame inside the damaged area.
+void endFrame();
+
+// Executes all commands of the last completed frame in drawing order.
+void replayFrame(ExecuteCommandFunc execute);
+
+const Command *getFrameCommands(uint32_t &numCommands);
+
+// Area redrawn by the last endFrame(), for backends which draw the frame
+// commands themselves.
+const Rect *getDamage(uint32_t &numRects);
+
+struct Stats {
+    uint32_t widgetsReplayed;
+    uint32_t widgetsRecorded;
+    uint32_t commandsReplayed;
+    uint32_t commandsRecorded;
+    uint32_t commandsExecuted; // inside the damage
+    uint32_t damagedPixels;
+    uint32_t overflows;
+};
+
+extern Stats g_stats;
+
+} // namespace display_list
+} // namespace gui
+} // namespace eez
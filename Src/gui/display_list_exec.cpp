@@ -0,0 +1,123 @@
+#include <eez/gui/gui.h>
+#include <eez/gui/display.h>
+
+#include "eez-framework-conf.h"
+
+#include "bitmap_format.h"
+#include "display_list.h"
+#include "shape_mask_cache.h"
+
+namespace eez {
+namespace gui {
+namespace display_list {
+
+static inline bool isInside(int x1, int y1, int x2, int y2, const Rect &clip) {
+    return x1 >= clip.x1 && y1 >= clip.y1 && x2 <= clip.x2 && y2 <= clip.y2;
+}
+
+static void fillRect(const Command &command, const Rect &clip) {
+    int x1 = command.x1 > clip.x1 ? command.x1 : clip.x1;
+    int y1 = command.y1 > clip.y1 ? command.y1 : clip.y1;
+    int x2 = command.x2 < clip.x2 ? command.x2 : clip.x2;
+    int y2 = command.y2 < clip.y2 ? command.y2 : clip.y2;
+    if (x1 > x2 || y1 > y2) {
+        return;
+    }
+
+    if (command.radius == 0) {
+        display::setColor16(command.color);
+        display::setOpacity(command.opacity);
+        display::fillRect(x1, y1, x2, y2, 0);
+        return;
+    }
+
+    // Corners always come from the mask cache, also when the whole rect is
+    // inside the clip, so a rect redrawn in a damage rect gets the same
+    // pixels as one drawn in full.
+    shape_mask_cache::Rect maskClip = { x1, y1, x2, y2 };
+#if defined(EEZ_PLATFORM_STM32)
+    shape_mask_cache::drawRoundedRectDMA2D((uint16_t *)display::getBufferPointer(), DISPLAY_WIDTH, maskClip,
+        command.x1, command.y1, command.x2, command.y2, command.radius, 0,
+        command.color, command.color, command.opacity);
+#else
+    shape_mask_cache::drawRoundedRect<pixel_format::Argb8888>((uint32_t *)display::getBufferPointer(), DISPLAY_WIDTH, maskClip,
+        command.x1, command.y1, command.x2, command.y2, command.radius, 0,
+        command.color, command.color, command.opacity);
+#endif
+}
+
+static void drawLine(const Command &command, const Rect &clip) {
+    int x1 = command.x1;
+    int y1 = command.y1;
+    int x2 = command.type == COMMAND_HLINE ? x1 + command.x2 : x1;
+    int y2 = command.type == COMMAND_HLINE ? y1 : y1 + command.x2;
+
+    if (x1 < clip.x1) x1 = clip.x1;
+    if (y1 < clip.y1) y1 = clip.y1;
+    if (x2 > clip.x2) x2 = clip.x2;
+    if (y2 > clip.y2) y2 = clip.y2;
+    if (x1 > x2 || y1 > y2) {
+        return;
+    }
+
+    display::setColor16(command.color);
+    display::setOpacity(command.opacity);
+    if (command.type == COMMAND_HLINE) {
+        display::drawHLine(x1, y1, x2 - x1);
+    } else {
+        display::drawVLine(x1, y1, y2 - y1);
+    }
+}
+
+void executeCommand(const Command &command, const Rect &clip) {
+    switch (command.type) {
+    case COMMAND_FILL_RECT:
+        fillRect(command, clip);
+        break;
+
+    case COMMAND_HLINE:
+    case COMMAND_VLINE:
+        drawLine(command, clip);
+        break;
+
+    case COMMAND_GLYPH_RUN: {
+        int clipX1 = command.x1 > clip.x1 ? command.x1 : clip.x1;
+        int clipY1 = command.y1 > clip.y1 ? command.y1 : clip.y1;
+        int clipX2 = command.x2 < clip.x2 ? command.x2 : clip.x2;
+        int clipY2 = command.y2 < clip.y2 ? command.y2 : clip.y2;
+        if (clipX1 > clipX2 || clipY1 > clipY2) {
+            break;
+        }
+
+        font::Font font((const FontData *)command.asset);
+        display::setColor16(command.color);
+        display::setOpacity(command.opacity);
+        display::drawStr(command.text, command.textLength, command.textX, command.textY,
+            clipX1, clipY1, clipX2, clipY2, font, -1);
+        break;
+    }
+
+    case COMMAND_BITMAP: {
+        auto image = (const Image *)command.asset;
+        bitmap_format::Rect bitmapClip = { clip.x1, clip.y1, clip.x2, clip.y2 };
+#if defined(EEZ_PLATFORM_STM32)
+        bitmap_format::drawBitmapRgb565((uint16_t *)display::getBufferPointer(), DISPLAY_WIDTH, bitmapClip,
+            image->bpp, image->width, image->height, image->lineOffset, (const uint8_t *)image->pixels,
+            command.x1, command.y1);
+#else
+        if (bitmap_format::isExtendedFormat(image->bpp) || !isInside(command.x1, command.y1, command.x2, command.y2, clip)) {
+            bitmap_format::drawBitmap<pixel_format::Argb8888>((uint32_t *)display::getBufferPointer(), DISPLAY_WIDTH, bitmapClip,
+                image->bpp, image->width, image->height, image->lineOffset, (const uint8_t *)image->pixels,
+                command.x1, command.y1);
+        } else {
+            display::drawBitmap((Image *)command.asset, command.x1, command.y1);
+        }
+#endif
+        break;
+    }
+    }
+}
+
+} // namespace display_list
+} // namespace gui
+} // namespace eez
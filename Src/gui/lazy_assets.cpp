@@ -0,0 +1,386 @@
+#include <string.h>
+
+#include "eez-framework-conf.h"
+
+#include "assets_codec.h"
+#include "lazy_assets.h"
+
+#if defined(EEZ_PLATFORM_SIMULATOR) && defined(__linux__)
+#define LAZY_ASSETS_DEMAND_PAGING 1
+#include <atomic>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define LAZY_ASSETS_DEMAND_PAGING 0
+#endif
+
+namespace eez {
+namespace gui {
+namespace lazy_assets {
+
+Stats g_stats;
+
+static const Header *g_header;
+static const BlockEntry *g_blocks;
+static ReadBlockFunc g_readBlock;
+
+// decompressed data, i.e. Assets::settings
+static uint8_t *g_data;
+
+static bool decompressBlock(uint32_t blockIndex) {
+    auto &block = g_blocks[blockIndex];
+    uint32_t offset = blockIndex * g_header->blockSize;
+    uint32_t size = g_header->decompressedSize - offset;
+    if (size > g_header->blockSize) {
+        size = g_header->blockSize;
+    }
+
+    auto compressed = g_readBlock(block);
+    if (!compressed) {
+        return false;
+    }
+
+    g_stats.blocksDecompressed++;
+
+    return assets_codec::decompress(block.codec, compressed, block.compressedSize, g_data + offset, size);
+}
+
+static const uint8_t *readImageBlock(const BlockEntry &block) {
+    // image starts with the header
+    return (const uint8_t *)g_header + block.compressedOffset;
+}
+
+#if LAZY_ASSETS_DEMAND_PAGING
+
+static const uint32_t MAX_BLOCKS = 4096;
+static const uint32_t MAX_RETIRED_REGIONS = 4;
+
+static bool g_resident[MAX_BLOCKS];
+static bool g_accessible[MAX_BLOCKS];
+static bool g_referenced[MAX_BLOCKS]; // accessed since the clock hand passed
+static uint32_t g_clockHand;
+static uint32_t g_pageSize;
+static uint32_t g_dataSize; // rounded up to the page size
+
+// blocks can be requested from any thread, also from the signal handler
+static std::atomic_flag g_lock = ATOMIC_FLAG_INIT;
+
+// fault while this thread holds the lock is a bug in decompression, waiting
+// for the lock would never end
+static thread_local bool t_isLocked;
+
+// regions of the assets loaded before, see releaseRetired()
+struct RetiredRegion {
+    uint8_t *address;
+    uint32_t size;
+    bool isSeen;
+};
+
+static RetiredRegion g_retired[MAX_RETIRED_REGIONS];
+static uint32_t g_numRetired;
+
+static struct sigaction g_prevAction;
+
+static void lock() {
+    while (g_lock.test_and_set(std::memory_order_acquire)) {
+    }
+    t_isLocked = true;
+}
+
+static void unlock() {
+    t_isLocked = false;
+    g_lock.clear(std::memory_order_release);
+}
+
+// CLOCK approximation of LRU. Access to an accessible block can't be seen,
+// so the hand takes access away from a referenced block instead of
+// evicting it, and the next access to it (reference fault, nothing is
+// decompressed) marks it referenced again. Block not accessed during a
+// whole turn of the hand is evicted.
+static void evictBlock(uint32_t exceptBlockIndex) {
+    auto blockSize = g_header->blockSize;
+    for (uint32_t n = 0; n < 2 * g_header->numBlocks; n++) {
+        uint32_t i = g_clockHand;
+        g_clockHand = (g_clockHand + 1) % g_header->numBlocks;
+        if (!g_resident[i] || i == exceptBlockIndex) {
+            continue;
+        }
+
+        auto address = g_data + i * blockSize;
+        if (g_referenced[i]) {
+            g_referenced[i] = false;
+            g_accessible[i] = false;
+            mprotect(address, blockSize, PROT_NONE);
+            continue;
+        }
+
+        madvise(address, blockSize, MADV_DONTNEED);
+        mprotect(address, blockSize, PROT_NONE);
+        g_resident[i] = false;
+        g_accessible[i] = false;
+        g_stats.residentBlocks--;
+        g_stats.evictions++;
+        return;
+    }
+}
+
+// lock must be held
+static void accessBlock(uint32_t blockIndex) {
+    auto blockSize = g_header->blockSize;
+    auto address = g_data + blockIndex * blockSize;
+
+    if (!g_resident[blockIndex]) {
+        while ((g_stats.residentBlocks + 1) * blockSize > LAZY_ASSETS_MAX_RESIDENT_SIZE && g_stats.residentBlocks > 0) {
+            evictBlock(blockIndex);
+        }
+
+        mprotect(address, blockSize, PROT_READ | PROT_WRITE);
+        decompressBlock(blockIndex);
+
+        g_resident[blockIndex] = true;
+        g_stats.residentBlocks++;
+    } else if (!g_accessible[blockIndex]) {
+        mprotect(address, blockSize, PROT_READ | PROT_WRITE);
+        g_stats.referenceFaults++;
+    }
+
+    g_accessible[blockIndex] = true;
+    g_referenced[blockIndex] = true;
+}
+
+static void segvHandler(int sig, siginfo_t *info, void *context) {
+    if (!t_isLocked) {
+        auto address = (uint8_t *)info->si_addr;
+
+        lock();
+        bool isOurs = address >= g_data && address < g_data + g_dataSize;
+        if (isOurs) {
+            uint32_t blockIndex = (address - g_data) / g_header->blockSize;
+            if (!g_resident[blockIndex]) {
+                g_stats.faults++;
+            }
+            // also when another thread made it accessible meanwhile
+            accessBlock(blockIndex);
+        }
+        unlock();
+
+        if (isOurs) {
+            return;
+        }
+    }
+
+    // not ours, pass it on
+    if (g_prevAction.sa_flags & SA_SIGINFO) {
+        g_prevAction.sa_sigaction(sig, info, context);
+    } else if (g_prevAction.sa_handler != SIG_DFL && g_prevAction.sa_handler != SIG_IGN) {
+        g_prevAction.sa_handler(sig);
+    } else {
+        // faulting instruction is executed again and crashes as usual
+        signal(SIGSEGV, SIG_DFL);
+    }
+}
+
+// lock must be held
+static void retireRegion() {
+    if (g_numRetired == MAX_RETIRED_REGIONS) {
+        // reloaded faster than released, oldest one goes now
+        munmap(g_retired[0].address, g_retired[0].size);
+        memmove(g_retired, g_retired + 1, (MAX_RETIRED_REGIONS - 1) * sizeof(RetiredRegion));
+        g_numRetired--;
+    }
+
+    // whoever still reads the previous assets gets all of them without
+    // faults, for the time being over the resident size
+    for (uint32_t i = 0; i < g_header->numBlocks; i++) {
+        if (!g_resident[i]) {
+            mprotect(g_data + i * g_header->blockSize, g_header->blockSize, PROT_READ | PROT_WRITE);
+            decompressBlock(i);
+        }
+    }
+    mprotect(g_data, g_dataSize, PROT_READ);
+
+    auto &retired = g_retired[g_numRetired++];
+    retired.address = g_data - g_pageSize;
+    retired.size = g_pageSize + g_dataSize;
+    retired.isSeen = false;
+}
+
+static void *loadDemandPaged(const Header *header, const BlockEntry *blocks, ReadBlockFunc readBlock, SwitchFunc onSwitch) {
+    uint32_t pageSize = (uint32_t)sysconf(_SC_PAGESIZE);
+    if (header->blockSize % pageSize != 0 || header->numBlocks > MAX_BLOCKS) {
+        return nullptr;
+    }
+
+    // one page for the Assets fields before settings, then the data
+    uint32_t dataSize = header->numBlocks * header->blockSize;
+    auto region = (uint8_t *)mmap(nullptr, pageSize + dataSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        return nullptr;
+    }
+    mprotect(region, pageSize, PROT_READ | PROT_WRITE);
+
+    lock();
+
+    bool handlerInstalled = g_dataSize != 0;
+    if (handlerInstalled) {
+        // loaded again (assets switched), previous region may still be read
+        retireRegion();
+    }
+
+    if (onSwitch) {
+        onSwitch();
+    }
+
+    g_header = header;
+    g_blocks = blocks;
+    g_readBlock = readBlock;
+    g_pageSize = pageSize;
+    g_data = region + pageSize;
+    g_dataSize = dataSize;
+    memset(g_resident, 0, sizeof(g_resident));
+    memset(g_accessible, 0, sizeof(g_accessible));
+    memset(g_referenced, 0, sizeof(g_referenced));
+    g_clockHand = 0;
+    g_stats.residentBlocks = 0;
+
+    unlock();
+
+    if (!handlerInstalled) {
+        // without SA_NODEFER a fault inside of the handler kills the process
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = segvHandler;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGSEGV, &action, &g_prevAction);
+    }
+
+    return g_data - ASSETS_PREFIX_SIZE;
+}
+
+#endif // LAZY_ASSETS_DEMAND_PAGING
+
+bool isHeaderValid(const Header *header) {
+    return header->tag == HEADER_TAG && header->blockSize != 0 &&
+        (uint64_t)header->numBlocks * header->blockSize >= header->decompressedSize;
+}
+
+void *load(const uint8_t *image, uint32_t imageSize, void *region, uint32_t regionSize) {
+    auto header = (const Header *)image;
+    if (imageSize < sizeof(Header) || !isHeaderValid(header) ||
+        imageSize < sizeof(Header) + header->numBlocks * sizeof(BlockEntry)) {
+        return nullptr;
+    }
+
+    for (uint32_t i = 0; i < header->numBlocks; i++) {
+        auto &block = ((const BlockEntry *)(image + sizeof(Header)))[i];
+        if ((uint64_t)block.compressedOffset + block.compressedSize > imageSize) {
+            return nullptr;
+        }
+    }
+
+    return load(header, (const BlockEntry *)(image + sizeof(Header)), readImageBlock, region, regionSize);
+}
+
+void *load(const Header *header, const BlockEntry *blocks, ReadBlockFunc readBlock, void *region, uint32_t regionSize,
+    SwitchFunc onSwitch) {
+    if (!isHeaderValid(header)) {
+        return nullptr;
+    }
+
+    g_stats.numBlocks = header->numBlocks;
+    g_stats.blockSize = header->blockSize;
+
+    uint8_t *assets = nullptr;
+
+#if LAZY_ASSETS_DEMAND_PAGING
+    assets = (uint8_t *)loadDemandPaged(header, blocks, readBlock, onSwitch);
+#endif
+
+    if (!assets) {
+        if (!region || regionSize < ASSETS_PREFIX_SIZE + header->decompressedSize) {
+            return nullptr;
+        }
+
+        // blocks are decompressed right away, nothing reads the previous
+        // ones anymore
+        if (onSwitch) {
+            onSwitch();
+        }
+
+        g_header = header;
+        g_blocks = blocks;
+        g_readBlock = readBlock;
+
+        assets = (uint8_t *)region;
+        g_data = assets + ASSETS_PREFIX_SIZE;
+
+        for (uint32_t i = 0; i < header->numBlocks; i++) {
+            if (!decompressBlock(i)) {
+                return nullptr;
+            }
+        }
+        g_stats.residentBlocks = header->numBlocks;
+    }
+
+    // Assets: projectMajorVersion (u8), projectMinorVersion (u8),
+    // reserved[2], external (u32)
+    memset(assets, 0, ASSETS_PREFIX_SIZE);
+    assets[0] = (uint8_t)header->projectMajorVersion;
+    assets[1] = (uint8_t)header->projectMinorVersion;
+
+    return assets;
+}
+
+void ensure(const void *address, uint32_t size) {
+#if LAZY_ASSETS_DEMAND_PAGING
+    if (size == 0) {
+        return;
+    }
+
+    auto begin = (const uint8_t *)address;
+    lock();
+    if (begin >= g_data && begin + size <= g_data + g_dataSize) {
+        uint32_t first = (begin - g_data) / g_header->blockSize;
+        uint32_t last = (begin + size - 1 - g_data) / g_header->blockSize;
+        for (uint32_t i = first; i <= last; i++) {
+            accessBlock(i);
+        }
+    }
+    unlock();
+#endif
+}
+
+void releaseRetired() {
+#if LAZY_ASSETS_DEMAND_PAGING
+    if (g_numRetired == 0) {
+        return;
+    }
+
+    lock();
+    uint32_t numKept = 0;
+    for (uint32_t i = 0; i < g_numRetired; i++) {
+        if (g_retired[i].isSeen) {
+            munmap(g_retired[i].address, g_retired[i].size);
+        } else {
+            g_retired[i].isSeen = true;
+            g_retired[numKept++] = g_retired[i];
+        }
+    }
+    g_numRetired = numKept;
+    unlock();
+#endif
+}
+
+bool isDemandPaging() {
+#if LAZY_ASSETS_DEMAND_PAGING
+    return g_dataSize != 0;
+#else
+    return false;
+#endif
+}
+
+} // namespace lazy_assets
+} // namespace gui
+} // namespace eez
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+namespace gui {
+namespace lazy_assets {
+
+// Block compressed assets (OPTION_LAZY_ASSETS). Decompressed assets are
+// split into fixed size blocks, each one compressed separately, so a block
+// can be decompressed when it is first used instead of the whole blob at
+// boot. Self-relative pointers stay valid because every block is
+// decompressed to its original offset.
+//
+// In the Linux simulator blocks are loaded on demand: the assets region is
+// reserved with no access and the first access to a block is caught as
+// SIGSEGV, the block is decompressed and access enabled. Number of resident
+// blocks is bounded by LAZY_ASSETS_MAX_RESIDENT_SIZE, a block not used
+// recently is discarded (and loaded again on next access) when it is
+// reached. Use is sampled CLOCK style, see evictBlock() in lazy_assets.cpp.
+//
+// On other platforms there is no way to catch the first access, so all
+// blocks are decompressed by load(), and ensure() is there for the code that
+// knows what it is about to read. That is no RAM saving and the block image
+// is larger than the assets[] blob, so OPTION_LAZY_ASSETS is only for the
+// simulator. On STM32 this is used by gui/sd_assets.h, which needs the
+// decompressed assets in RAM anyway.
+//
+// Image is generated from gui/document.cpp by Src/tools/assets_lazy_gen:
+//
+//   Header
+//   BlockEntry[numBlocks]
+//   compressed blocks
+
+// "~blk"
+static const uint32_t HEADER_TAG = 0x6B6C627E;
+
+struct Header {
+    uint32_t tag;
+    uint16_t projectMajorVersion;
+    uint16_t projectMinorVersion;
+    uint32_t decompressedSize;
+    uint32_t blockSize; // multiple of 4096
+    uint32_t numBlocks;
+};
+
+struct BlockEntry {
+    uint32_t compressedOffset; // from the start of the image
+    uint32_t compressedSize;
+    uint8_t codec; // assets_codec::Codec
+    uint8_t reserved[3];
+};
+
+// size of Assets fields before settings
+static const uint32_t ASSETS_PREFIX_SIZE = 8;
+
+bool isHeaderValid(const Header *header);
+
+// Returns pointer to Assets or nullptr. Region is used when demand paging
+// is not available and must hold ASSETS_PREFIX_SIZE + decompressedSize.
+void *load(const uint8_t *image, uint32_t imageSize, void *region, uint32_t regionSize);
+
+// Returns compressed data of the block or nullptr on read error, pointer
+// must stay valid until the next call. With demand paging it is called from
+// the SIGSEGV handler, so it must be async-signal-safe.
+typedef const uint8_t *(*ReadBlockFunc)(const BlockEntry &block);
+
+// Called when the blocks of the previous assets are not read anymore and
+// the new ones will be, under the same lock as readBlock, e.g. to switch
+// the file read by readBlock.
+typedef void (*SwitchFunc)();
+
+// Same as above, but the image is not in memory (e.g. a file on the SD
+// card) and blocks are read with readBlock. Header and block table must
+// stay valid while the assets are used, also the previous ones until
+// onSwitch is called.
+void *load(const Header *header, const BlockEntry *blocks, ReadBlockFunc readBlock, void *region, uint32_t regionSize,
+    SwitchFunc onSwitch = nullptr);
+
+// Make sure that blocks in the given range of the assets are decompressed.
+void ensure(const void *address, uint32_t size);
+
+// With demand paging load() called again keeps the region of the previous
+// assets mapped, other threads may still read it, and decompresses the
+// blocks of it which are not resident. Region is unmapped by the second
+// call of this after it was replaced, so the GUI thread calls it once per
+// frame.
+void releaseRetired();
+
+bool isDemandPaging();
+
+struct Stats {
+    uint32_t numBlocks;
+    uint32_t blockSize;
+    uint32_t residentBlocks;
+    uint32_t blocksDecompressed;
+    uint32_t evictions;
+    uint32_t faults;
+    uint32_t referenceFaults; // resident block accessed again, see evictBlock()
+};
+
+extern Stats g_stats;
+
+} // namespace lazy_assets
+} // namespace gui
+} // namespace eez
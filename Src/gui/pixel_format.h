@@ -0,0 +1,152 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+namespace eez {
+namespace gui {
+namespace pixel_format {
+
+// Drawing kernels parameterized on pixel format. Both formats are available
+// in every build, so the simulator can run exactly the same 16-bpp path as
+// the target, while the compiler specializes and inlines each inner loop.
+//
+// Colors are passed in the 16-bit theme format (RGB565) and converted once
+// per call with Format::fromColor16(), alpha is 0 .. 255.
+
+struct Rgb565 {
+    typedef uint16_t Pixel;
+    static const int BPP = 16;
+
+    static inline Pixel fromColor16(uint16_t color) {
+        return color;
+    }
+
+    static inline Pixel fromArgb8888(uint32_t color) {
+        return (Pixel)(((color >> 8) & 0xF800) | ((color >> 5) & 0x07E0) | ((color >> 3) & 0x001F));
+    }
+
+    static inline uint32_t toArgb8888(Pixel pixel) {
+        uint32_t r = (pixel >> 11) & 0x1F;
+        uint32_t g = (pixel >> 5) & 0x3F;
+        uint32_t b = pixel & 0x1F;
+        r = (r << 3) | (r >> 2);
+        g = (g << 2) | (g >> 4);
+        b = (b << 3) | (b >> 2);
+        return 0xFF000000 | (r << 16) | (g << 8) | b;
+    }
+
+    static inline Pixel blend(Pixel dst, Pixel src, uint32_t alpha) {
+        uint32_t ia = 255 - alpha;
+        uint32_t r = (((src >> 11) & 0x1F) * alpha + ((dst >> 11) & 0x1F) * ia + 127) / 255;
+        uint32_t g = (((src >> 5) & 0x3F) * alpha + ((dst >> 5) & 0x3F) * ia + 127) / 255;
+        uint32_t b = ((src & 0x1F) * alpha + (dst & 0x1F) * ia + 127) / 255;
+        return (Pixel)((r << 11) | (g << 5) | b);
+    }
+};
+
+struct Argb8888 {
+    typedef uint32_t Pixel;
+    static const int BPP = 32;
+
+    static inline Pixel fromColor16(uint16_t color) {
+        return Rgb565::toArgb8888(color);
+    }
+
+    static inline Pixel fromArgb8888(uint32_t color) {
+        return color | 0xFF000000;
+    }
+
+    static inline uint32_t toArgb8888(Pixel pixel) {
+        return pixel;
+    }
+
+    static inline Pixel blend(Pixel dst, Pixel src, uint32_t alpha) {
+        uint32_t ia = 255 - alpha;
+        uint32_t r = (((src >> 16) & 0xFF) * alpha + ((dst >> 16) & 0xFF) * ia + 127) / 255;
+        uint32_t g = (((src >> 8) & 0xFF) * alpha + ((dst >> 8) & 0xFF) * ia + 127) / 255;
+        uint32_t b = ((src & 0xFF) * alpha + (dst & 0xFF) * ia + 127) / 255;
+        return 0xFF000000 | (r << 16) | (g << 8) | b;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <typename Format>
+inline void fillSpan(typename Format::Pixel *dst, int count, typename Format::Pixel color) {
+    for (int i = 0; i < count; i++) {
+        dst[i] = color;
+    }
+}
+
+template <typename Format>
+inline void blendSpan(typename Format::Pixel *dst, int count, typename Format::Pixel color, uint32_t alpha) {
+    if (alpha == 255) {
+        fillSpan<Format>(dst, count, color);
+    } else if (alpha != 0) {
+        for (int i = 0; i < count; i++) {
+            dst[i] = Format::blend(dst[i], color, alpha);
+        }
+    }
+}
+
+// Rect is inclusive and must be already clipped to the buffer.
+template <typename Format>
+void fillRect(typename Format::Pixel *buffer, int stride, int x1, int y1, int x2, int y2, uint16_t color16, uint32_t alpha) {
+    auto color = Format::fromColor16(color16);
+    auto dst = buffer + y1 * stride + x1;
+    int width = x2 - x1 + 1;
+    for (int y = y1; y <= y2; y++, dst += stride) {
+        blendSpan<Format>(dst, width, color, alpha);
+    }
+}
+
+// Copy with format conversion, memcpy when formats are the same.
+template <typename DstFormat, typename SrcFormat>
+void blit(typename DstFormat::Pixel *dst, int dstStride, const typename SrcFormat::Pixel *src, int srcStride, int width, int height) {
+    for (int y = 0; y < height; y++, dst += dstStride, src += srcStride) {
+        if (sizeof(typename DstFormat::Pixel) == sizeof(typename SrcFormat::Pixel) && DstFormat::BPP == SrcFormat::BPP) {
+            memcpy(dst, src, width * sizeof(typename DstFormat::Pixel));
+        } else {
+            for (int x = 0; x < width; x++) {
+                dst[x] = DstFormat::fromArgb8888(SrcFormat::toArgb8888(src[x]));
+            }
+        }
+    }
+}
+
+// Blend ARGB8888 source with per pixel alpha (source is given as bytes,
+// little endian B, G, R, A, because bitmap data in assets is not aligned).
+template <typename DstFormat>
+void blitBlend(typename DstFormat::Pixel *dst, int dstStride, const uint8_t *src, int srcStride, int width, int height) {
+    for (int y = 0; y < height; y++, dst += dstStride, src += srcStride * 4) {
+        auto s = src;
+        for (int x = 0; x < width; x++, s += 4) {
+            uint32_t alpha = s[3];
+            if (alpha) {
+                auto color = DstFormat::fromArgb8888(s[0] | (s[1] << 8) | (s[2] << 16));
+                dst[x] = alpha == 255 ? color : DstFormat::blend(dst[x], color, alpha);
+            }
+        }
+    }
+}
+
+// Draw A8 coverage mask (glyph, anti-aliased shape) in the given color.
+template <typename Format>
+void drawMask(typename Format::Pixel *dst, int dstStride, const uint8_t *mask, int maskStride, int width, int height, uint16_t color16, uint32_t opacity) {
+    auto color = Format::fromColor16(color16);
+    for (int y = 0; y < height; y++, dst += dstStride, mask += maskStride) {
+        for (int x = 0; x < width; x++) {
+            uint32_t alpha = opacity == 255 ? mask[x] : mask[x] * opacity / 255;
+            if (alpha == 255) {
+                dst[x] = color;
+            } else if (alpha) {
+                dst[x] = Format::blend(dst[x], color, alpha);
+            }
+        }
+    }
+}
+
+} // namespace pixel_format
+} // namespace gui
+} // namespace eez
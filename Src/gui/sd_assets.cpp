@@ -0,0 +1,349 @@
+#include <string.h>
+
+#include "eez-framework-conf.h"
+
+#if OPTION_SD_ASSETS
+
+#if defined(EEZ_PLATFORM_STM32)
+#include "main.h"
+#include "crc.h"
+#include "fatfs.h"
+#elif defined(_WIN32)
+#include <stdio.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "lazy_assets.h"
+#include "sd_assets.h"
+
+namespace eez {
+namespace gui {
+namespace sd_assets {
+
+Stats g_stats;
+
+////////////////////////////////////////////////////////////////////////////////
+// platform file access, read() must be async-signal-safe in the simulator
+// because blocks are read from the SIGSEGV handler (see lazy_assets.cpp)
+
+#if defined(EEZ_PLATFORM_STM32)
+
+struct File {
+    FIL fil;
+    bool isOpen;
+};
+
+static bool g_isMounted;
+
+static bool openFile(File &file, const char *path, uint32_t &size) {
+    if (!g_isMounted) {
+        if (f_mount(&SDFatFS, SDPath, 1) != FR_OK) {
+            return false;
+        }
+        g_isMounted = true;
+    }
+
+    if (f_open(&file.fil, path, FA_READ) != FR_OK) {
+        return false;
+    }
+    file.isOpen = true;
+    size = (uint32_t)f_size(&file.fil);
+    return true;
+}
+
+static bool readFile(File &file, uint32_t offset, void *buffer, uint32_t size) {
+    UINT numRead;
+    return f_lseek(&file.fil, offset) == FR_OK && f_read(&file.fil, buffer, size, &numRead) == FR_OK && numRead == size;
+}
+
+static void closeFile(File &file) {
+    if (file.isOpen) {
+        f_close(&file.fil);
+        file.isOpen = false;
+    }
+}
+
+const char *getDefaultFilePath() {
+    static char path[sizeof(SDPath) + sizeof(FILE_NAME)];
+    strcpy(path, SDPath);
+    strcat(path, FILE_NAME);
+    return path;
+}
+
+#elif defined(_WIN32)
+
+struct File {
+    FILE *fp;
+};
+
+static bool openFile(File &file, const char *path, uint32_t &size) {
+    file.fp = fopen(path, "rb");
+    if (!file.fp) {
+        return false;
+    }
+    fseek(file.fp, 0, SEEK_END);
+    size = (uint32_t)ftell(file.fp);
+    return true;
+}
+
+static bool readFile(File &file, uint32_t offset, void *buffer, uint32_t size) {
+    return fseek(file.fp, offset, SEEK_SET) == 0 && fread(buffer, 1, size, file.fp) == size;
+}
+
+static void closeFile(File &file) {
+    if (file.fp) {
+        fclose(file.fp);
+        file.fp = nullptr;
+    }
+}
+
+const char *getDefaultFilePath() {
+    return FILE_NAME;
+}
+
+#else
+
+struct File {
+    int fd;
+    bool isOpen;
+};
+
+static bool openFile(File &file, const char *path, uint32_t &size) {
+    file.fd = open(path, O_RDONLY);
+    if (file.fd < 0) {
+        return false;
+    }
+    file.isOpen = true;
+    size = (uint32_t)lseek(file.fd, 0, SEEK_END);
+    return true;
+}
+
+static bool readFile(File &file, uint32_t offset, void *buffer, uint32_t size) {
+    return pread(file.fd, buffer, size, offset) == (ssize_t)size;
+}
+
+static void closeFile(File &file) {
+    if (file.isOpen) {
+        close(file.fd);
+        file.isOpen = false;
+    }
+}
+
+const char *getDefaultFilePath() {
+    return FILE_NAME;
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// new file is opened and validated in the other slot, the current one stays
+// usable until lazy_assets calls switchFile()
+static File g_files[2];
+static lazy_assets::Header g_headers[2];
+static lazy_assets::BlockEntry g_blocks[2][SD_ASSETS_MAX_BLOCKS];
+static uint32_t g_fileSizes[2];
+static int g_current = -1;
+static int g_next;
+static uint32_t g_fileSize;
+
+// compressed block, also used for reading the file while computing CRC
+static uint32_t g_blockBuffer[SD_ASSETS_BLOCK_BUFFER_SIZE / 4];
+
+struct Sector {
+    uint32_t index;
+    uint32_t lastUsed;
+    bool isValid;
+};
+
+static Sector g_sectors[SD_ASSETS_CACHE_SECTORS];
+static uint32_t g_sectorData[SD_ASSETS_CACHE_SECTORS][SECTOR_SIZE / 4];
+static uint32_t g_useCounter;
+
+static int findSector(uint32_t index) {
+    for (uint32_t i = 0; i < SD_ASSETS_CACHE_SECTORS; i++) {
+        if (g_sectors[i].isValid && g_sectors[i].index == index) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static const uint8_t *getSector(uint32_t index) {
+    int i = findSector(index);
+    if (i != -1) {
+        g_stats.sectorHits++;
+    } else {
+        g_stats.sectorMisses++;
+
+        i = 0;
+        for (uint32_t j = 1; j < SD_ASSETS_CACHE_SECTORS; j++) {
+            if (!g_sectors[j].isValid || (g_sectors[i].isValid && g_sectors[j].lastUsed < g_sectors[i].lastUsed)) {
+                i = (int)j;
+            }
+        }
+
+        uint32_t offset = index * SECTOR_SIZE;
+        uint32_t size = g_fileSize - offset < SECTOR_SIZE ? g_fileSize - offset : SECTOR_SIZE;
+        g_sectors[i].isValid = readFile(g_files[g_current], offset, g_sectorData[i], size);
+        if (!g_sectors[i].isValid) {
+            return nullptr;
+        }
+        g_sectors[i].index = index;
+    }
+
+    g_sectors[i].lastUsed = ++g_useCounter;
+    return (const uint8_t *)g_sectorData[i];
+}
+
+static bool readBytes(uint32_t offset, uint8_t *dst, uint32_t size) {
+    if (offset + size > g_fileSize) {
+        return false;
+    }
+
+    while (size > 0) {
+        uint32_t index = offset / SECTOR_SIZE;
+        uint32_t sectorOffset = offset % SECTOR_SIZE;
+
+        if (sectorOffset == 0 && size >= SECTOR_SIZE && findSector(index) == -1) {
+            // whole sectors inside of a block are read only once, don't
+            // push the shared ones out of the cache
+            uint32_t n = size / SECTOR_SIZE;
+            if (!readFile(g_files[g_current], offset, dst, n * SECTOR_SIZE)) {
+                return false;
+            }
+            g_stats.sectorsReadDirect += n;
+            n *= SECTOR_SIZE;
+            offset += n;
+            dst += n;
+            size -= n;
+            continue;
+        }
+
+        auto data = getSector(index);
+        if (!data) {
+            return false;
+        }
+
+        uint32_t n = SECTOR_SIZE - sectorOffset < size ? SECTOR_SIZE - sectorOffset : size;
+        memcpy(dst, data + sectorOffset, n);
+        offset += n;
+        dst += n;
+        size -= n;
+    }
+
+    return true;
+}
+
+static const uint8_t *readBlock(const lazy_assets::BlockEntry &block) {
+    auto buffer = (uint8_t *)g_blockBuffer;
+    if (block.compressedSize > sizeof(g_blockBuffer) || !readBytes(block.compressedOffset, buffer, block.compressedSize)) {
+        return nullptr;
+    }
+    return buffer;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+uint32_t crc32(uint32_t crc, const uint32_t *words, uint32_t numWords) {
+    for (uint32_t i = 0; i < numWords; i++) {
+        crc ^= words[i];
+        for (int bit = 0; bit < 32; bit++) {
+            crc = crc & 0x80000000 ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static bool validate(File &file, uint32_t fileSize) {
+    lazy_assets::Header header;
+    if (fileSize < sizeof(header) + 4 || fileSize % 4 != 0 ||
+        !readFile(file, 0, &header, sizeof(header)) || !lazy_assets::isHeaderValid(&header) ||
+        header.numBlocks > SD_ASSETS_MAX_BLOCKS ||
+        sizeof(header) + header.numBlocks * sizeof(lazy_assets::BlockEntry) > fileSize - 4) {
+        return false;
+    }
+
+    uint32_t dataSize = fileSize - 4;
+
+    // block table
+    static const uint32_t ENTRIES_PER_READ = SD_ASSETS_BLOCK_BUFFER_SIZE / sizeof(lazy_assets::BlockEntry);
+    auto entries = (const lazy_assets::BlockEntry *)g_blockBuffer;
+    for (uint32_t i = 0; i < header.numBlocks; i += ENTRIES_PER_READ) {
+        uint32_t n = header.numBlocks - i < ENTRIES_PER_READ ? header.numBlocks - i : ENTRIES_PER_READ;
+        if (!readFile(file, sizeof(header) + i * sizeof(lazy_assets::BlockEntry), g_blockBuffer, n * sizeof(lazy_assets::BlockEntry))) {
+            return false;
+        }
+        for (uint32_t j = 0; j < n; j++) {
+            if (entries[j].compressedSize > sizeof(g_blockBuffer) ||
+                (uint64_t)entries[j].compressedOffset + entries[j].compressedSize > dataSize) {
+                return false;
+            }
+        }
+    }
+
+    // CRC of the whole file, done by the CRC unit on the target
+    uint32_t crc = 0xFFFFFFFF;
+    for (uint32_t offset = 0; offset < dataSize; offset += sizeof(g_blockBuffer)) {
+        uint32_t size = dataSize - offset < sizeof(g_blockBuffer) ? dataSize - offset : sizeof(g_blockBuffer);
+        if (!readFile(file, offset, g_blockBuffer, size)) {
+            return false;
+        }
+#if defined(EEZ_PLATFORM_STM32)
+        crc = offset == 0 ? HAL_CRC_Calculate(&hcrc, g_blockBuffer, size / 4) : HAL_CRC_Accumulate(&hcrc, g_blockBuffer, size / 4);
+#else
+        crc = crc32(crc, g_blockBuffer, size / 4);
+#endif
+    }
+
+    uint32_t expectedCrc;
+    return readFile(file, dataSize, &expectedCrc, 4) && crc == expectedCrc;
+}
+
+// called by lazy_assets under its lock
+static void switchFile() {
+    if (g_current != -1) {
+        closeFile(g_files[g_current]);
+    }
+    g_current = g_next;
+    g_fileSize = g_fileSizes[g_current];
+
+    memset(g_sectors, 0, sizeof(g_sectors));
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_stats.fileSize = g_fileSize;
+}
+
+void *load(const char *filePath, void *region, uint32_t regionSize) {
+    int slot = g_current == 0 ? 1 : 0;
+    auto &file = g_files[slot];
+    auto &header = g_headers[slot];
+    auto blocks = g_blocks[slot];
+
+    uint32_t fileSize;
+    if (!openFile(file, filePath, fileSize)) {
+        return nullptr;
+    }
+
+    if (!validate(file, fileSize) || !readFile(file, 0, &header, sizeof(header)) ||
+        !readFile(file, sizeof(header), blocks, header.numBlocks * sizeof(lazy_assets::BlockEntry))) {
+        closeFile(file);
+        return nullptr;
+    }
+
+    g_next = slot;
+    g_fileSizes[slot] = fileSize;
+
+    auto assets = lazy_assets::load(&header, blocks, readBlock, region, regionSize, switchFile);
+    if (!assets && g_current != slot) {
+        closeFile(file);
+    }
+    return assets;
+}
+
+} // namespace sd_assets
+} // namespace gui
+} // namespace eez
+
+#endif // OPTION_SD_ASSETS
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+namespace gui {
+namespace sd_assets {
+
+// Assets loaded from the SD card (OPTION_SD_ASSETS), so the GUI can be
+// changed by copying a new file to the card instead of reflashing. File is
+// the block compressed image from gui/lazy_assets.h followed by a CRC:
+//
+//   lazy_assets::Header
+//   lazy_assets::BlockEntry[numBlocks]
+//   compressed blocks
+//   padding to multiple of 4
+//   uint32_t crc (of everything before it)
+//
+// CRC is what the STM32 CRC unit computes: CRC-32/MPEG-2, polynomial
+// 0x04C11DB7, initial value 0xFFFFFFFF, 32-bit little endian words fed
+// MSB first, no reflection and no final xor. Whole file is checked before
+// the current assets are touched, so a bad or half copied file is ignored.
+//
+// File is read through a small LRU cache of 512 byte sectors, sectors at
+// block boundaries and the block table are shared between neighbouring
+// reads. Blocks are decompressed by lazy_assets, i.e. on first access in
+// the Linux simulator and at load() elsewhere.
+//
+// File is generated from gui/document.cpp by Src/tools/assets_sd_gen.
+
+// 8.3 name, FatFs is built without long file names
+static const char FILE_NAME[] = "ASSETS.BIN";
+
+static const uint32_t SECTOR_SIZE = 512;
+
+// "0:/ASSETS.BIN" on the target, current directory in the simulator
+const char *getDefaultFilePath();
+
+// Returns pointer to Assets or nullptr. Missing or not valid file doesn't
+// touch the current assets. Can be called again to switch to another file,
+// the current one is read until lazy_assets switches the assets. With
+// demand paging the current assets stay readable until
+// lazy_assets::releaseRetired(), otherwise they are overwritten in region
+// and GUI and flow must not use them while it runs. Region is the same as
+// for lazy_assets::load().
+void *load(const char *filePath, void *region, uint32_t regionSize);
+
+uint32_t crc32(uint32_t crc, const uint32_t *words, uint32_t numWords);
+
+struct Stats {
+    uint32_t fileSize;
+    uint32_t sectorHits;
+    uint32_t sectorMisses;
+    uint32_t sectorsReadDirect; // bypassed the cache, inside of a block
+};
+
+extern Stats g_stats;
+
+} // namespace sd_assets
+} // namespace gui
+} // namespace eez
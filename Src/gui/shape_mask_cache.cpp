@@ -0,0 +1,256 @@
+#include <string.h>
+
+#if defined(EEZ_PLATFORM_STM32)
+#include "main.h"
+#endif
+
+#include "eez-framework-conf.h"
+
+#include "shape_mask_cache.h"
+
+namespace eez {
+namespace gui {
+namespace shape_mask_cache {
+
+struct Entry {
+    uint16_t radius;
+    uint16_t borderWidth;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t lastUsed;
+};
+
+static const int MAX_ENTRIES = 32;
+
+// DMA2D can't access CCM RAM, so masks must be in regular SRAM
+static uint8_t g_arena[SHAPE_MASK_CACHE_SIZE];
+static uint32_t g_arenaUsed;
+
+static Entry g_entries[MAX_ENTRIES];
+static int g_numEntries;
+static uint32_t g_useCounter;
+
+Stats g_stats;
+
+#if defined(EEZ_PLATFORM_STM32)
+static inline void waitDMA2D() {
+    while (DMA2D->CR & DMA2D_CR_START) {
+    }
+}
+#endif
+
+// 4x4 supersampled coverage of pixel (x, y) inside the ring between outer
+// radius r and inner radius r - borderWidth, centered at (r, r). Integer
+// math in 1/8 pixel units, so masks are the same on every platform.
+static uint8_t coverage(int x, int y, int r, int borderWidth) {
+    int outer = 8 * r;
+    int inner = borderWidth > 0 && borderWidth < r ? 8 * (r - borderWidth) : 0;
+
+    int count = 0;
+    for (int sy = 0; sy < 4; sy++) {
+        int dy = 8 * y + 2 * sy + 1 - 8 * r;
+        for (int sx = 0; sx < 4; sx++) {
+            int dx = 8 * x + 2 * sx + 1 - 8 * r;
+            int d2 = dx * dx + dy * dy;
+            if (d2 <= outer * outer && (inner == 0 || d2 > inner * inner)) {
+                count++;
+            }
+        }
+    }
+
+    return (uint8_t)((count * 255 + 8) / 16);
+}
+
+static void rasterizeMask(uint8_t *pixels, int r, int borderWidth) {
+    int size = 2 * r;
+    // compute one quadrant and mirror it to the others
+    for (int y = 0; y < r; y++) {
+        for (int x = 0; x < r; x++) {
+            uint8_t value = coverage(x, y, r, borderWidth);
+            pixels[y * size + x] = value;
+            pixels[y * size + size - 1 - x] = value;
+            pixels[(size - 1 - y) * size + x] = value;
+            pixels[(size - 1 - y) * size + size - 1 - x] = value;
+        }
+    }
+}
+
+static void removeEntry(int index) {
+    g_stats.evictions++;
+    memmove(&g_entries[index], &g_entries[index + 1], (g_numEntries - index - 1) * sizeof(Entry));
+    g_numEntries--;
+}
+
+// Entries are kept sorted by offset, compaction keeps the order.
+static void compact() {
+    uint32_t offset = 0;
+    for (int i = 0; i < g_numEntries; i++) {
+        auto &entry = g_entries[i];
+        if (entry.offset != offset) {
+            memmove(g_arena + offset, g_arena + entry.offset, entry.size);
+            entry.offset = offset;
+        }
+        offset += entry.size;
+    }
+    g_arenaUsed = offset;
+}
+
+static void evictLeastRecentlyUsed() {
+    int lruIndex = 0;
+    for (int i = 1; i < g_numEntries; i++) {
+        if (g_entries[i].lastUsed < g_entries[lruIndex].lastUsed) {
+            lruIndex = i;
+        }
+    }
+    removeEntry(lruIndex);
+}
+
+bool getMask(int radius, int borderWidth, Mask &mask) {
+    if (radius <= 0) {
+        return false;
+    }
+
+    if (borderWidth >= radius) {
+        // ring without hole is a disc
+        borderWidth = 0;
+    }
+
+    for (int i = 0; i < g_numEntries; i++) {
+        auto &entry = g_entries[i];
+        if (entry.radius == radius && entry.borderWidth == borderWidth) {
+            entry.lastUsed = ++g_useCounter;
+            g_stats.hits++;
+
+            mask.pixels = g_arena + entry.offset;
+            mask.radius = radius;
+            mask.stride = 2 * radius;
+            return true;
+        }
+    }
+
+    g_stats.misses++;
+
+    uint32_t size = 4 * radius * radius;
+    if (size > SHAPE_MASK_CACHE_SIZE) {
+        return false;
+    }
+
+#if defined(EEZ_PLATFORM_STM32)
+    // previous mask could still be read by DMA2D
+    waitDMA2D();
+#endif
+
+    if (g_arenaUsed + size > SHAPE_MASK_CACHE_SIZE || g_numEntries == MAX_ENTRIES) {
+        while (g_numEntries > 0) {
+            uint32_t used = 0;
+            for (int i = 0; i < g_numEntries; i++) {
+                used += g_entries[i].size;
+            }
+            if (used + size <= SHAPE_MASK_CACHE_SIZE && g_numEntries < MAX_ENTRIES) {
+                break;
+            }
+            evictLeastRecentlyUsed();
+        }
+        compact();
+    }
+
+    auto &entry = g_entries[g_numEntries++];
+    entry.radius = (uint16_t)radius;
+    entry.borderWidth = (uint16_t)borderWidth;
+    entry.offset = g_arenaUsed;
+    entry.size = size;
+    entry.lastUsed = ++g_useCounter;
+
+    g_arenaUsed += size;
+
+    rasterizeMask(g_arena + entry.offset, radius, borderWidth);
+
+    mask.pixels = g_arena + entry.offset;
+    mask.radius = radius;
+    mask.stride = 2 * radius;
+    return true;
+}
+
+void clear() {
+#if defined(EEZ_PLATFORM_STM32)
+    waitDMA2D();
+#endif
+    g_numEntries = 0;
+    g_arenaUsed = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(EEZ_PLATFORM_STM32)
+
+static void fillDMA2D(uint16_t *dst, int stride, int width, int height, uint16_t color, uint32_t opacity) {
+    waitDMA2D();
+
+    if (opacity == 255) {
+        DMA2D->CR = DMA2D_R2M;
+        DMA2D->OPFCCR = DMA2D_OUTPUT_RGB565;
+        DMA2D->OCOLR = color;
+    } else {
+        // blend constant color with the background, A8 foreground values
+        // are ignored because alpha is replaced, so any readable address
+        // will do
+        DMA2D->CR = DMA2D_M2M_BLEND;
+        DMA2D->FGMAR = (uint32_t)dst;
+        DMA2D->FGOR = stride - width;
+        DMA2D->FGPFCCR = DMA2D_INPUT_A8 | (DMA2D_REPLACE_ALPHA << DMA2D_FGPFCCR_AM_Pos) | (opacity << DMA2D_FGPFCCR_ALPHA_Pos);
+        DMA2D->FGCOLR = pixel_format::Argb8888::fromColor16(color) & 0x00FFFFFF;
+        DMA2D->BGMAR = (uint32_t)dst;
+        DMA2D->BGOR = stride - width;
+        DMA2D->BGPFCCR = DMA2D_INPUT_RGB565;
+        DMA2D->OPFCCR = DMA2D_OUTPUT_RGB565;
+    }
+
+    DMA2D->OMAR = (uint32_t)dst;
+    DMA2D->OOR = stride - width;
+    DMA2D->NLR = (uint32_t)((width << DMA2D_NLR_PL_Pos) | height);
+    DMA2D->CR |= DMA2D_CR_START;
+}
+
+static void blendMaskDMA2D(uint16_t *dst, int stride, const uint8_t *mask, int maskStride, int width, int height, uint16_t color, uint32_t opacity) {
+    waitDMA2D();
+
+    DMA2D->CR = DMA2D_M2M_BLEND;
+
+    DMA2D->FGMAR = (uint32_t)mask;
+    DMA2D->FGOR = maskStride - width;
+    DMA2D->FGPFCCR = DMA2D_INPUT_A8 | (DMA2D_COMBINE_ALPHA << DMA2D_FGPFCCR_AM_Pos) | (opacity << DMA2D_FGPFCCR_ALPHA_Pos);
+    DMA2D->FGCOLR = pixel_format::Argb8888::fromColor16(color) & 0x00FFFFFF;
+
+    DMA2D->BGMAR = (uint32_t)dst;
+    DMA2D->BGOR = stride - width;
+    DMA2D->BGPFCCR = DMA2D_INPUT_RGB565;
+
+    DMA2D->OMAR = (uint32_t)dst;
+    DMA2D->OOR = stride - width;
+    DMA2D->OPFCCR = DMA2D_OUTPUT_RGB565;
+
+    DMA2D->NLR = (uint32_t)((width << DMA2D_NLR_PL_Pos) | height);
+    DMA2D->CR |= DMA2D_CR_START;
+}
+
+void drawRoundedRectDMA2D(uint16_t *buffer, int stride, const Rect &clip,
+    int x1, int y1, int x2, int y2, int radius, int borderWidth,
+    uint16_t color, uint16_t borderColor, uint32_t opacity) {
+    decomposeRoundedRect(clip, x1, y1, x2, y2, radius, borderWidth,
+        [&](const Rect &rect, bool border) {
+            fillDMA2D(buffer + rect.y1 * stride + rect.x1, stride,
+                rect.x2 - rect.x1 + 1, rect.y2 - rect.y1 + 1, border ? borderColor : color, opacity);
+        },
+        [&](const Rect &rect, const uint8_t *maskPixels, int maskStride, bool border) {
+            blendMaskDMA2D(buffer + rect.y1 * stride + rect.x1, stride, maskPixels, maskStride,
+                rect.x2 - rect.x1 + 1, rect.y2 - rect.y1 + 1, border ? borderColor : color, opacity);
+        });
+
+    waitDMA2D();
+}
+
+#endif
+
+} // namespace shape_mask_cache
+} // namespace gui
+} // namespace eez
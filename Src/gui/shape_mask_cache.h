@@ -0,0 +1,168 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "pixel_format.h"
+
+namespace eez {
+namespace gui {
+namespace shape_mask_cache {
+
+// Cache of pre-rasterized anti-aliased A8 circle masks used for the corners
+// of rounded rectangles drawn from the display list. A mask is
+// (2 * radius) x (2 * radius) pixels, each corner is one quadrant of it, so
+// it can be composited with the fill color by DMA2D (A8 foreground with
+// constant color) using line offset, without per pixel AA computation.
+//
+// borderWidth == 0 gives filled disc, otherwise ring of the given width.
+//
+// Rectangle, Button, Switch and Slider widgets are drawn by eez-framework
+// through its own agg path, which has no hook to replace the corner
+// rasterizer, so the firmware doesn't go through this cache.
+
+struct Mask {
+    const uint8_t *pixels;
+    int radius;
+    int stride; // 2 * radius
+};
+
+// Returned mask stays valid until the next getMask() call.
+bool getMask(int radius, int borderWidth, Mask &mask);
+
+void clear();
+
+struct Stats {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+};
+
+extern Stats g_stats;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct Rect {
+    int x1;
+    int y1;
+    int x2; // inclusive
+    int y2; // inclusive
+};
+
+#if defined(EEZ_PLATFORM_STM32)
+// Same as drawRoundedRect<Rgb565>, but straight parts are DMA2D R2M fills and
+// corners are DMA2D M2M_BLEND with A8 mask. Clip must be inside the buffer.
+void drawRoundedRectDMA2D(uint16_t *buffer, int stride, const Rect &clip,
+    int x1, int y1, int x2, int y2, int radius, int borderWidth,
+    uint16_t color, uint16_t borderColor, uint32_t opacity);
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline bool intersect(Rect &rect, const Rect &clip) {
+    if (rect.x1 < clip.x1) rect.x1 = clip.x1;
+    if (rect.y1 < clip.y1) rect.y1 = clip.y1;
+    if (rect.x2 > clip.x2) rect.x2 = clip.x2;
+    if (rect.y2 > clip.y2) rect.y2 = clip.y2;
+    return rect.x1 <= rect.x2 && rect.y1 <= rect.y2;
+}
+
+// Splits a rounded rect into straight fills and corner quadrants of the
+// masks, both already clipped. Used by the software and DMA2D paths, so
+// they produce the same geometry. Masks come from getMask unless another
+// function with the same signature is given.
+//
+//   fill(const Rect &rect, bool border)
+//   corner(const Rect &rect, const uint8_t *maskPixels, int maskStride, bool border)
+template <typename FillFunc, typename CornerFunc, typename GetMaskFunc = bool (*)(int, int, Mask &)>
+void decomposeRoundedRect(const Rect &clip, int x1, int y1, int x2, int y2, int radius, int borderWidth,
+    FillFunc fill, CornerFunc corner, GetMaskFunc getMaskFunc = getMask) {
+    int w = x2 - x1 + 1;
+    int h = y2 - y1 + 1;
+    if (radius > w / 2) radius = w / 2;
+    if (radius > h / 2) radius = h / 2;
+
+    auto fillClipped = [&](int fx1, int fy1, int fx2, int fy2, bool border) {
+        Rect rect = { fx1, fy1, fx2, fy2 };
+        if (intersect(rect, clip)) {
+            fill(rect, border);
+        }
+    };
+
+    auto corners = [&](int cx1, int cy1, int cx2, int cy2, int r, int maskBorderWidth, bool border) {
+        Mask mask;
+        if (r <= 0 || !getMaskFunc(r, maskBorderWidth, mask)) {
+            return;
+        }
+        // top-left, top-right, bottom-left, bottom-right quadrant
+        int qx[4] = { cx1, cx2 - r + 1, cx1, cx2 - r + 1 };
+        int qy[4] = { cy1, cy1, cy2 - r + 1, cy2 - r + 1 };
+        for (int i = 0; i < 4; i++) {
+            Rect rect = { qx[i], qy[i], qx[i] + r - 1, qy[i] + r - 1 };
+            if (intersect(rect, clip)) {
+                int mx = (i & 1 ? r : 0) + rect.x1 - qx[i];
+                int my = (i & 2 ? r : 0) + rect.y1 - qy[i];
+                corner(rect, mask.pixels + my * mask.stride + mx, mask.stride, border);
+            }
+        }
+    };
+
+    bool interiorIsBorder = false;
+
+    if (borderWidth > 0 && (2 * borderWidth >= w || 2 * borderWidth >= h)) {
+        // no room for the interior, everything is border
+        interiorIsBorder = true;
+    } else if (borderWidth > 0) {
+        int b = borderWidth;
+        int bandHeight = radius < b ? radius : b;
+        int edgeInset = radius > b ? radius : b;
+
+        // border edges between the corners, when border is wider than the
+        // radius rows below the corners are full width
+        fillClipped(x1 + radius, y1, x2 - radius, y1 + bandHeight - 1, true);
+        fillClipped(x1, y1 + radius, x2, y1 + b - 1, true);
+        fillClipped(x1 + radius, y2 - bandHeight + 1, x2 - radius, y2, true);
+        fillClipped(x1, y2 - b + 1, x2, y2 - radius, true);
+        fillClipped(x1, y1 + edgeInset, x1 + b - 1, y2 - edgeInset, true);
+        fillClipped(x2 - b + 1, y1 + edgeInset, x2, y2 - edgeInset, true);
+
+        // ring corners, interior corners below are blended over their hole
+        corners(x1, y1, x2, y2, radius, b, true);
+
+        x1 += b;
+        y1 += b;
+        x2 -= b;
+        y2 -= b;
+        radius = radius > b ? radius - b : 0;
+    }
+
+    // interior: middle band and the parts of top and bottom band between
+    // the corners
+    fillClipped(x1, y1 + radius, x2, y2 - radius, interiorIsBorder);
+    if (radius > 0) {
+        fillClipped(x1 + radius, y1, x2 - radius, y1 + radius - 1, interiorIsBorder);
+        fillClipped(x1 + radius, y2 - radius + 1, x2 - radius, y2, interiorIsBorder);
+        corners(x1, y1, x2, y2, radius, 0, interiorIsBorder);
+    }
+}
+
+// Software compositing with the kernels from pixel_format.h. Rectangle
+// coordinates are inclusive, only the part inside clip is drawn.
+template <typename Format, typename GetMaskFunc = bool (*)(int, int, Mask &)>
+void drawRoundedRect(typename Format::Pixel *buffer, int stride, const Rect &clip,
+    int x1, int y1, int x2, int y2, int radius, int borderWidth,
+    uint16_t color, uint16_t borderColor, uint32_t opacity, GetMaskFunc getMaskFunc = getMask) {
+    decomposeRoundedRect(clip, x1, y1, x2, y2, radius, borderWidth,
+        [&](const Rect &rect, bool border) {
+            pixel_format::fillRect<Format>(buffer, stride, rect.x1, rect.y1, rect.x2, rect.y2,
+                border ? borderColor : color, opacity);
+        },
+        [&](const Rect &rect, const uint8_t *maskPixels, int maskStride, bool border) {
+            pixel_format::drawMask<Format>(buffer + rect.y1 * stride + rect.x1, stride, maskPixels, maskStride,
+                rect.x2 - rect.x1 + 1, rect.y2 - rect.y1 + 1, border ? borderColor : color, opacity);
+        },
+        getMaskFunc);
+}
+
+} // namespace shape_mask_cache
+} // namespace gui
+} // namespace eez
@@ -0,0 +1,23 @@
+#include "eez-framework-conf.h"
+
+#if OPTION_STYLE_TABLE
+
+#include "style_table.h"
+
+namespace eez {
+namespace gui {
+namespace style_table {
+
+const FlatStyle *g_themeStyles = g_flatStyles;
+
+void selectTheme(uint32_t themeIndex) {
+    if (themeIndex < g_numThemes) {
+        g_themeStyles = g_flatStyles + themeIndex * g_numStyles;
+    }
+}
+
+} // namespace style_table
+} // namespace gui
+} // namespace eez
+
+#endif // OPTION_STYLE_TABLE
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "pixel_format.h"
+
+namespace eez {
+namespace gui {
+namespace style_table {
+
+// Styles resolved at asset build time by tools/style_table_gen into
+// gui/document_styles.cpp: one array of FlatStyle per theme, indexed by
+// style ID, with theme colors already looked up and converted to the
+// frame buffer format. Getting a widget background color is
+// getStyle(styleId)->backgroundColor instead of style -> color index ->
+// theme -> colors list.
+//
+// Table is generated from document.cpp, so it doesn't match assets loaded
+// from the SD card.
+//
+// Nothing in the firmware looks styles up here. Widgets are drawn by
+// eez-framework, which resolves style -> theme -> color itself, and
+// g_hooks.overrideStyle can only swap one style ID for another, so the
+// widgets can't be handed a FlatStyle. Only tools/style_table_gen uses it.
+
+#if defined(EEZ_PLATFORM_STM32)
+typedef pixel_format::Rgb565 NativeFormat;
+#else
+typedef pixel_format::Argb8888 NativeFormat;
+#endif
+
+typedef NativeFormat::Pixel NativeColor;
+
+// bits in FlatStyle::transparent, color index was COLOR_ID_TRANSPARENT
+enum {
+    TRANSPARENT_BACKGROUND = 1 << 0,
+    TRANSPARENT_COLOR = 1 << 1,
+    TRANSPARENT_ACTIVE_BACKGROUND = 1 << 2,
+    TRANSPARENT_ACTIVE_COLOR = 1 << 3,
+    TRANSPARENT_FOCUS_BACKGROUND = 1 << 4,
+    TRANSPARENT_FOCUS_COLOR = 1 << 5,
+    TRANSPARENT_BORDER = 1 << 6
+};
+
+struct FlatStyle {
+    NativeColor backgroundColor;
+    NativeColor color;
+    NativeColor activeBackgroundColor;
+    NativeColor activeColor;
+    NativeColor focusBackgroundColor;
+    NativeColor focusColor;
+    NativeColor borderColor;
+
+    uint16_t flags; // Style::flags
+    int16_t backgroundImage;
+
+    uint8_t borderSizeTop;
+    uint8_t borderSizeRight;
+    uint8_t borderSizeBottom;
+    uint8_t borderSizeLeft;
+
+    uint8_t borderRadius[8];
+
+    uint8_t font;
+    uint8_t opacity;
+    uint8_t transparent;
+    uint8_t reserved;
+
+    uint8_t paddingTop;
+    uint8_t paddingRight;
+    uint8_t paddingBottom;
+    uint8_t paddingLeft;
+};
+
+// generated
+extern const uint32_t g_numThemes;
+extern const uint32_t g_numStyles;
+extern const FlatStyle g_flatStyles[]; // g_numThemes * g_numStyles
+
+extern const FlatStyle *g_themeStyles;
+
+// Call when the theme is changed, same index as in the project themes.
+void selectTheme(uint32_t themeIndex);
+
+inline const FlatStyle *getStyle(uint16_t styleId) {
+    return styleId > 0 && styleId <= g_numStyles ? &g_themeStyles[styleId - 1] : nullptr;
+}
+
+} // namespace style_table
+} // namespace gui
+} // namespace eez
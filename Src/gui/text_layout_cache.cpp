@@ -0,0 +1,375 @@
+#include <string.h>
+
+#if defined(EEZ_PLATFORM_STM32)
+#include "main.h"
+#endif
+
+#include "eez-framework-conf.h"
+
+#include "text_layout_cache.h"
+
+namespace eez {
+namespace gui {
+namespace text_layout_cache {
+
+// Arena holds per layout: glyphs, lines, text (for the compare on lookup).
+struct Entry {
+    uint32_t hash;
+    const void *fontData;
+    int16_t maxWidth;
+    int16_t lineHeight;
+    uint16_t textLength;
+    Layout layout;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t lastUsed;
+};
+
+static uint8_t g_arena[TEXT_LAYOUT_CACHE_SIZE] __attribute__((aligned(4)));
+static uint32_t g_arenaUsed;
+
+static Entry g_entries[TEXT_LAYOUT_CACHE_MAX_ENTRIES];
+static uint32_t g_numEntries;
+static uint32_t g_useCounter;
+
+// hashes of the texts laid out once and not kept, see getLayout()
+static const uint32_t NUM_SEEN = 8;
+static uint32_t g_seen[NUM_SEEN];
+static uint32_t g_nextSeen;
+
+// layout of a text which is not kept, in the free space of the arena
+static Layout g_transientLayout;
+
+Stats g_stats;
+
+// FNV-1a
+static uint32_t hashText(const char *text, int textLength) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < textLength; i++) {
+        hash = (hash ^ (uint8_t)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void setPointers(Entry &entry) {
+    entry.layout.glyphs = (const PositionedGlyph *)(g_arena + entry.offset);
+    entry.layout.lines = (const Line *)(g_arena + entry.offset + entry.layout.numGlyphs * sizeof(PositionedGlyph));
+}
+
+static const char *getText(const Entry &entry) {
+    return (const char *)(g_arena + entry.offset + entry.layout.numGlyphs * sizeof(PositionedGlyph) + entry.layout.numLines * sizeof(Line));
+}
+
+static int findEntry(uint32_t hash, const void *fontData, const char *text, int textLength, int maxWidth, int lineHeight) {
+    for (uint32_t i = 0; i < g_numEntries; i++) {
+        auto &entry = g_entries[i];
+        if (entry.hash == hash && entry.fontData == fontData && entry.textLength == textLength &&
+            entry.maxWidth == maxWidth && entry.lineHeight == lineHeight &&
+            memcmp(getText(entry), text, textLength) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static void evictLeastRecentlyUsed() {
+    uint32_t lruIndex = 0;
+    for (uint32_t i = 1; i < g_numEntries; i++) {
+        if (g_entries[i].lastUsed < g_entries[lruIndex].lastUsed) {
+            lruIndex = i;
+        }
+    }
+
+    g_stats.evictions++;
+    g_stats.usedBytes -= g_entries[lruIndex].size;
+    memmove(&g_entries[lruIndex], &g_entries[lruIndex + 1], (g_numEntries - lruIndex - 1) * sizeof(Entry));
+    g_numEntries--;
+}
+
+// Entries are kept sorted by offset, compaction keeps the order.
+static void compact() {
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < g_numEntries; i++) {
+        auto &entry = g_entries[i];
+        if (entry.offset != offset) {
+            memmove(g_arena + offset, g_arena + entry.offset, entry.size);
+            entry.offset = offset;
+            setPointers(entry);
+        }
+        offset += entry.size;
+    }
+    g_arenaUsed = offset;
+}
+
+static void makeRoom(uint32_t size, bool isKept) {
+    while (g_numEntries > 0 && (g_stats.usedBytes + size > TEXT_LAYOUT_CACHE_SIZE || (isKept && g_numEntries == TEXT_LAYOUT_CACHE_MAX_ENTRIES))) {
+        evictLeastRecentlyUsed();
+    }
+    compact();
+}
+
+// Text is kept when it misses again within NUM_SEEN misses, a text which
+// changes on every frame (e.g. a running value) is then laid out on every
+// draw, as without the cache, and doesn't push out the layouts which are
+// drawn again.
+static bool isSeen(uint32_t hash) {
+    for (uint32_t i = 0; i < NUM_SEEN; i++) {
+        if (g_seen[i] == hash) {
+            return true;
+        }
+    }
+    g_seen[g_nextSeen] = hash;
+    g_nextSeen = (g_nextSeen + 1) % NUM_SEEN;
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct LayoutState {
+    PositionedGlyph *glyphs;
+    Line *lines;
+    int numGlyphs;
+    int numLines;
+    int lineHeight;
+    int firstGlyph; // of the current line
+    int x;
+    int lastSpace; // glyph index of the last space in the current line, -1 if none
+    int width;
+};
+
+static void endLine(LayoutState &state, int lastGlyph, int width) {
+    Line &line = state.lines[state.numLines];
+    line.firstGlyph = (uint16_t)state.firstGlyph;
+    line.numGlyphs = (uint16_t)(lastGlyph - state.firstGlyph);
+    line.width = (int16_t)width;
+    line.y = (int16_t)(state.numLines * state.lineHeight);
+    state.numLines++;
+
+    if (width > state.width) {
+        state.width = width;
+    }
+}
+
+// Wraps at the last space of the line, glyphs after it go to the new line,
+// or before the current glyph if the line has no space.
+static void wrapLine(LayoutState &state) {
+    if (state.lastSpace == -1) {
+        endLine(state, state.numGlyphs, state.x);
+        state.firstGlyph = state.numGlyphs;
+        state.x = 0;
+        return;
+    }
+
+    int space = state.lastSpace;
+    endLine(state, space, state.glyphs[space].x);
+
+    int numMoved = state.numGlyphs - space - 1;
+    memmove(state.glyphs + space, state.glyphs + space + 1, numMoved * sizeof(PositionedGlyph));
+    state.numGlyphs--;
+
+    int shift = numMoved > 0 ? state.glyphs[space].x : state.x;
+    for (int i = space; i < state.numGlyphs; i++) {
+        state.glyphs[i].x -= (int16_t)shift;
+    }
+
+    state.firstGlyph = space;
+    state.x -= shift;
+    state.lastSpace = -1;
+}
+
+static void layoutText(LayoutState &state, const void *fontData, LoadGlyphFunc loadGlyph,
+    const char *text, int textLength, int maxWidth) {
+    state.numGlyphs = 0;
+    state.numLines = 0;
+    state.firstGlyph = 0;
+    state.x = 0;
+    state.lastSpace = -1;
+    state.width = 0;
+
+    for (int i = 0; i < textLength;) {
+        int encoding = decodeUtf8(text, textLength, i);
+
+        if (encoding == '\n') {
+            endLine(state, state.numGlyphs, state.x);
+            state.firstGlyph = state.numGlyphs;
+            state.x = 0;
+            state.lastSpace = -1;
+            continue;
+        }
+
+        Glyph glyph;
+        if (encoding > 0xFFFF || !loadGlyph(fontData, encoding, glyph)) {
+            continue;
+        }
+
+        // second pass breaks a word that is still too wide on its own line
+        while (encoding != ' ' && state.x + glyph.dx > maxWidth && state.numGlyphs > state.firstGlyph) {
+            wrapLine(state);
+        }
+
+        if (encoding == ' ') {
+            state.lastSpace = state.numGlyphs;
+        }
+
+        auto &positioned = state.glyphs[state.numGlyphs++];
+        positioned.x = (int16_t)state.x;
+        positioned.encoding = (uint16_t)encoding;
+        state.x += glyph.dx;
+    }
+
+    endLine(state, state.numGlyphs, state.x);
+}
+
+const Layout *getLayout(const void *fontData, LoadGlyphFunc loadGlyph,
+    const char *text, int textLength, int maxWidth, int lineHeight) {
+    if (textLength == -1) {
+        textLength = (int)strlen(text);
+    }
+
+    uint32_t hash = hashText(text, textLength);
+
+    int entryIndex = findEntry(hash, fontData, text, textLength, maxWidth, lineHeight);
+    if (entryIndex != -1) {
+        auto &entry = g_entries[entryIndex];
+        entry.lastUsed = ++g_useCounter;
+        g_stats.hits++;
+        return &entry.layout;
+    }
+
+    g_stats.misses++;
+
+    // worst case, every glyph on its own line
+    uint32_t glyphsSize = textLength * sizeof(PositionedGlyph);
+    uint32_t maxSize = (glyphsSize + (textLength + 1) * sizeof(Line) + textLength + 3) & ~3;
+    if (maxSize > TEXT_LAYOUT_CACHE_SIZE || textLength > 0xFFFF) {
+        g_stats.uncached++;
+        return nullptr;
+    }
+
+    bool isKept = isSeen(hash);
+    if (g_arenaUsed + maxSize > TEXT_LAYOUT_CACHE_SIZE || (isKept && g_numEntries == TEXT_LAYOUT_CACHE_MAX_ENTRIES)) {
+        makeRoom(maxSize, isKept);
+    }
+
+    // lines are laid out after the worst case glyphs and moved down after
+    LayoutState state;
+    state.glyphs = (PositionedGlyph *)(g_arena + g_arenaUsed);
+    state.lines = (Line *)(g_arena + g_arenaUsed + glyphsSize);
+    state.lineHeight = lineHeight;
+    layoutText(state, fontData, loadGlyph, text, textLength, maxWidth);
+
+    if (!isKept) {
+        g_stats.transient++;
+        g_transientLayout.numLines = (uint16_t)state.numLines;
+        g_transientLayout.numGlyphs = (uint16_t)state.numGlyphs;
+        g_transientLayout.width = (int16_t)state.width;
+        g_transientLayout.height = (int16_t)(state.numLines * lineHeight);
+        g_transientLayout.lines = state.lines;
+        g_transientLayout.glyphs = state.glyphs;
+        return &g_transientLayout;
+    }
+
+    uint8_t *lines = g_arena + g_arenaUsed + state.numGlyphs * sizeof(PositionedGlyph);
+    memmove(lines, state.lines, state.numLines * sizeof(Line));
+    memcpy(lines + state.numLines * sizeof(Line), text, textLength);
+
+    auto &entry = g_entries[g_numEntries];
+    entry.hash = hash;
+    entry.fontData = fontData;
+    entry.maxWidth = (int16_t)maxWidth;
+    entry.lineHeight = (int16_t)lineHeight;
+    entry.textLength = (uint16_t)textLength;
+    entry.layout.numLines = (uint16_t)state.numLines;
+    entry.layout.numGlyphs = (uint16_t)state.numGlyphs;
+    entry.layout.width = (int16_t)state.width;
+    entry.layout.height = (int16_t)(state.numLines * lineHeight);
+    entry.offset = g_arenaUsed;
+    entry.size = (state.numGlyphs * sizeof(PositionedGlyph) + state.numLines * sizeof(Line) + textLength + 3) & ~3;
+    entry.lastUsed = ++g_useCounter;
+    setPointers(entry);
+
+    g_arenaUsed += entry.size;
+    g_numEntries++;
+
+    g_stats.usedBytes += entry.size;
+    g_stats.numLayouts = g_numEntries;
+
+    return &entry.layout;
+}
+
+int decodeUtf8(const char *text, int textLength, int &i) {
+    uint8_t c = (uint8_t)text[i++];
+
+    int codepoint;
+    int numContinuation;
+    if ((c & 0xE0) == 0xC0) {
+        codepoint = c & 0x1F;
+        numContinuation = 1;
+    } else if ((c & 0xF0) == 0xE0) {
+        codepoint = c & 0x0F;
+        numContinuation = 2;
+    } else if ((c & 0xF8) == 0xF0) {
+        codepoint = c & 0x07;
+        numContinuation = 3;
+    } else {
+        // ASCII or a stray continuation byte
+        return c;
+    }
+
+    if (i + numContinuation > textLength) {
+        return c;
+    }
+    for (int j = 0; j < numContinuation; j++) {
+        if (((uint8_t)text[i + j] & 0xC0) != 0x80) {
+            return c;
+        }
+    }
+
+    for (int j = 0; j < numContinuation; j++) {
+        codepoint = (codepoint << 6) | ((uint8_t)text[i++] & 0x3F);
+    }
+    return codepoint;
+}
+
+void clear() {
+    memset(g_seen, 0, sizeof(g_seen));
+    g_numEntries = 0;
+    g_arenaUsed = 0;
+    g_stats.usedBytes = 0;
+    g_stats.numLayouts = 0;
+}
+
+float getHitRate() {
+    uint32_t lookups = g_stats.hits + g_stats.misses;
+    return lookups > 0 ? 100.0f * g_stats.hits / lookups : 0.0f;
+}
+
+void resetStats() {
+    g_stats.hits = 0;
+    g_stats.misses = 0;
+    g_stats.evictions = 0;
+    g_stats.uncached = 0;
+    g_stats.transient = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined(EEZ_PLATFORM_STM32)
+
+void drawLayoutRgb565(uint16_t *buffer, int stride,
+    int clipX1, int clipY1, int clipX2, int clipY2,
+    const void *fontData, LoadGlyphFunc loadGlyph, int ascent,
+    const Layout &layout, int align, int alignWidth, int x, int y, uint16_t color, uint32_t opacity) {
+    // background under the text could still be filled by DMA2D
+    while (DMA2D->CR & DMA2D_CR_START) {
+    }
+
+    drawLayout<pixel_format::Rgb565>(buffer, stride, clipX1, clipY1, clipX2, clipY2,
+        fontData, loadGlyph, ascent, layout, align, alignWidth, x, y, color, opacity);
+}
+
+#endif
+
+} // namespace text_layout_cache
+} // namespace gui
+} // namespace eez
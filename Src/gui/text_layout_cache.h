@@ -0,0 +1,151 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "pixel_format.h"
+
+namespace eez {
+namespace gui {
+namespace text_layout_cache {
+
+// Line breaks and glyph positions of multiline texts (MultilineTextWidget,
+// toast messages), so text that didn't change is drawn by replaying the
+// glyph positions instead of measuring and word wrapping it again.
+//
+// Layouts are keyed by text hash, font data and wrap width. Text is stored
+// with the layout and compared on lookup, so a changed string (or a hash
+// collision) never gets the old layout, it is laid out again and the old
+// layout is evicted when it isn't used anymore. Text is kept only when it
+// is seen again, one which changes on every draw is laid out every time.
+// Call clear() when assets are reloaded.
+//
+// MultilineTextWidget and toasts are drawn by eez-framework, which has no
+// hook around the text drawing of a widget, so nothing in the firmware
+// draws through the cache, only tools/text_layout_bench.
+
+struct Glyph {
+    int dx;
+    int width;
+    int height;
+    int x;
+    int y;
+    const uint8_t *pixels; // A8, width * height
+};
+
+// Reads the glyph from the font in assets.
+typedef bool (*LoadGlyphFunc)(const void *fontData, int encoding, Glyph &glyph);
+
+struct Line {
+    uint16_t firstGlyph;
+    uint16_t numGlyphs;
+    int16_t width;
+    int16_t y; // top of the line, relative to the text top
+};
+
+struct PositionedGlyph {
+    int16_t x; // relative to the line start
+    uint16_t encoding;
+};
+
+struct Layout {
+    uint16_t numLines;
+    uint16_t numGlyphs;
+    int16_t width; // widest line
+    int16_t height;
+    const Line *lines;
+    const PositionedGlyph *glyphs;
+};
+
+// Text is UTF-8, wrapped at spaces to maxWidth, '\n' starts a new line, a
+// word wider than maxWidth is broken between glyphs. Returned layout stays valid until the next getLayout()
+// call, nullptr if the text doesn't fit into the cache.
+const Layout *getLayout(const void *fontData, LoadGlyphFunc loadGlyph,
+    const char *text, int textLength, int maxWidth, int lineHeight);
+
+void clear();
+
+// Decodes the UTF-8 character at text[i] like utf8codepoint() of
+// eez-framework and moves i past it. A byte which doesn't start a valid
+// sequence is returned as it is.
+int decodeUtf8(const char *text, int textLength, int &i);
+
+struct Stats {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t uncached; // too long to cache
+    uint32_t transient; // seen for the first time, laid out and not kept
+    uint32_t usedBytes;
+    uint32_t numLayouts;
+};
+
+extern Stats g_stats;
+
+// hits / (hits + misses) in percent, 0 before the first lookup
+float getHitRate();
+
+// Clears the counters, cached layouts stay.
+void resetStats();
+
+////////////////////////////////////////////////////////////////////////////////
+
+enum {
+    ALIGN_LEFT,
+    ALIGN_CENTER,
+    ALIGN_RIGHT
+};
+
+// Draws the layout with its top-left corner at (x, y), lines aligned within
+// alignWidth. Only the part inside the clip rect (inclusive) is drawn.
+template <typename Format>
+void drawLayout(typename Format::Pixel *buffer, int stride,
+    int clipX1, int clipY1, int clipX2, int clipY2,
+    const void *fontData, LoadGlyphFunc loadGlyph, int ascent,
+    const Layout &layout, int align, int alignWidth, int x, int y, uint16_t color, uint32_t opacity) {
+    for (int i = 0; i < layout.numLines; i++) {
+        const Line &line = layout.lines[i];
+
+        int xLine = x;
+        if (align == ALIGN_CENTER) {
+            xLine += (alignWidth - line.width) / 2;
+        } else if (align == ALIGN_RIGHT) {
+            xLine += alignWidth - line.width;
+        }
+        int yBaseline = y + line.y + ascent;
+
+        for (int j = 0; j < line.numGlyphs; j++) {
+            const PositionedGlyph &positioned = layout.glyphs[line.firstGlyph + j];
+
+            Glyph glyph;
+            if (!loadGlyph(fontData, positioned.encoding, glyph)) {
+                continue;
+            }
+
+            int xGlyph = xLine + positioned.x + glyph.x;
+            int yGlyph = yBaseline - (glyph.y + glyph.height);
+
+            int x1 = xGlyph > clipX1 ? xGlyph : clipX1;
+            int y1 = yGlyph > clipY1 ? yGlyph : clipY1;
+            int x2 = xGlyph + glyph.width - 1 < clipX2 ? xGlyph + glyph.width - 1 : clipX2;
+            int y2 = yGlyph + glyph.height - 1 < clipY2 ? yGlyph + glyph.height - 1 : clipY2;
+
+            if (x1 <= x2 && y1 <= y2) {
+                pixel_format::drawMask<Format>(buffer + y1 * stride + x1, stride,
+                    glyph.pixels + (y1 - yGlyph) * glyph.width + (x1 - xGlyph), glyph.width,
+                    x2 - x1 + 1, y2 - y1 + 1, color, opacity);
+            }
+        }
+    }
+}
+
+#if defined(EEZ_PLATFORM_STM32)
+// drawLayout<Rgb565> after DMA2D has finished drawing the background.
+void drawLayoutRgb565(uint16_t *buffer, int stride,
+    int clipX1, int clipY1, int clipX2, int clipY2,
+    const void *fontData, LoadGlyphFunc loadGlyph, int ascent,
+    const Layout &layout, int align, int alignWidth, int x, int y, uint16_t color, uint32_t opacity);
+#endif
+
+} // namespace text_layout_cache
+} // namespace gui
+} // namespace eez
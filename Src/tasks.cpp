@@ -27,6 +27,7 @@
 
 #include "tasks.h"
 #include "firmware.h"
+#include "gui/data_versions.h"
 
 #if defined(EEZ_PLATFORM_STM32)
 #include "adc.h"
@@ -193,9 +194,9 @@ void lowPriorityThreadOneIter() {
 
             uint16_t adcTempValue = HAL_ADC_GetValue(&hadc1);
 
-            g_temperature = (static_cast<float>(adcTempValue) - adcCalTemp30C)/(adcCalTemp110C - adcCalTemp30C) * (110.0F - 30.0F) + 30.0F;        
+            float temperature = (static_cast<float>(adcTempValue) - adcCalTemp30C)/(adcCalTemp110C - adcCalTemp30C) * (110.0F - 30.0F) + 30.0F;
 
-            g_temperature = roundf(g_temperature);
+            gui::data_versions::set(gui::data_versions::VERSION_TEMPERATURE, g_temperature, roundf(temperature));
 
             HAL_ADC_Stop(&hadc1);
         }
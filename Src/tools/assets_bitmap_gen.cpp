@@ -0,0 +1,85 @@
+// Generates gui/document_bitmaps.cpp with the assets[] arrays of
+// gui/document.cpp where bitmaps are converted to the STM32 frame buffer
+// formats (see gui/bitmap_format.h). Run it after EEZ Studio build when
+// OPTION_NATIVE_BITMAPS is enabled:
+//
+//   assets_bitmap_gen ../../gui/document.cpp ../../gui/document_bitmaps.cpp
+//
+// Simulator assets are converted the same way, so the simulator shows what
+// the target draws.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "assets_file.h"
+#include "bitmap_convert.h"
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <document.cpp> <document_bitmaps.cpp>\n", argv[0]);
+        return 1;
+    }
+
+    std::string out;
+    out += "// Generated by Src/tools/assets_bitmap_gen from document.cpp, do not edit.\n\n";
+    out += "#include <stdint.h>\n\n";
+    out += "#include \"eez-framework-conf.h\"\n\n";
+    out += "#if OPTION_NATIVE_BITMAPS\n\n";
+    out += "namespace eez {\nnamespace gui {\n\n";
+
+    assets_file::Platform platforms[] = { assets_file::PLATFORM_STM32, assets_file::PLATFORM_SIMULATOR };
+    for (int i = 0; i < 2; i++) {
+        std::vector<uint8_t> compressed;
+        if (!assets_file::readDocument(argv[1], platforms[i], compressed)) {
+            return 1;
+        }
+
+        assets_file::Header header;
+        std::vector<uint8_t> decompressed;
+        if (!assets_file::decompress(compressed, header, decompressed)) {
+            return 1;
+        }
+
+        std::vector<bitmap_convert::BitmapInfo> bitmaps;
+        bitmap_convert::convertBitmaps(decompressed, bitmaps);
+
+        // without any converted bitmap keep Studio compressed data, it is
+        // smaller than what assets_file::compress() makes
+        bool changed = false;
+        for (auto &bitmap : bitmaps) {
+            changed = changed || bitmap.newBpp != bitmap.oldBpp;
+        }
+        std::vector<uint8_t> converted = compressed;
+        if (changed) {
+            assets_file::compress(header, decompressed, converted);
+        }
+
+        printf("%-10s compressed: %7u, with native bitmaps: %7u bytes\n",
+            assets_file::getPlatformName(platforms[i]), (unsigned)compressed.size(), (unsigned)converted.size());
+        for (size_t j = 0; j < bitmaps.size(); j++) {
+            auto &bitmap = bitmaps[j];
+            printf("    bitmap %u: %dx%d, bpp %d -> %d, %u -> %u bytes\n", (unsigned)(j + 1), bitmap.width, bitmap.height,
+                bitmap.oldBpp, bitmap.newBpp, bitmap.oldSize, bitmap.newSize);
+        }
+
+        char line[128];
+        out += i == 0 ? "#if defined(EEZ_PLATFORM_STM32)\n\n" : "#elif defined(EEZ_PLATFORM_SIMULATOR)\n\n";
+        snprintf(line, sizeof(line), "extern const uint8_t native_bitmap_assets[%u];\n", (unsigned)converted.size());
+        out += line;
+        snprintf(line, sizeof(line), "extern const uint32_t native_bitmap_assets_size = %u;\n\n", (unsigned)converted.size());
+        out += line;
+        snprintf(line, sizeof(line), "const uint8_t native_bitmap_assets[%u] = {\n", (unsigned)converted.size());
+        out += line;
+        assets_file::writeArray(out, converted.data(), converted.size());
+        out += "};\n\n";
+    }
+
+    out += "#endif\n\n";
+    out += "} // namespace gui\n} // namespace eez\n\n";
+    out += "#endif // OPTION_NATIVE_BITMAPS\n";
+
+    return assets_file::writeFile(argv[2], out.data(), out.size()) ? 0 : 1;
+}
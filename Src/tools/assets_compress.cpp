@@ -0,0 +1,300 @@
+#include <string.h>
+
+#include "gui/assets_codec.h"
+
+#include "assets_compress.h"
+
+using namespace eez::gui::assets_codec;
+
+namespace assets_compress {
+
+static void writeLength(std::vector<uint8_t> &dst, uint32_t length) {
+    for (; length >= 255; length -= 255) {
+        dst.push_back(255);
+    }
+    dst.push_back((uint8_t)length);
+}
+
+static void writeSequence(std::vector<uint8_t> &dst, const uint8_t *literals, uint32_t literalLength, uint32_t offset, uint32_t matchLength) {
+    uint32_t token = (literalLength < 15 ? literalLength : 15) << 4;
+    if (matchLength) {
+        token |= matchLength - 4 < 15 ? matchLength - 4 : 15;
+    }
+    dst.push_back((uint8_t)token);
+
+    if (literalLength >= 15) {
+        writeLength(dst, literalLength - 15);
+    }
+    dst.insert(dst.end(), literals, literals + literalLength);
+
+    if (matchLength) {
+        dst.push_back((uint8_t)offset);
+        dst.push_back((uint8_t)(offset >> 8));
+        if (matchLength - 4 >= 15) {
+            writeLength(dst, matchLength - 4 - 15);
+        }
+    }
+}
+
+// Hash chains over 3 byte prefixes.
+struct MatchFinder {
+    static const int HASH_BITS = 15;
+    static const int MAX_CHAIN = 48;
+
+    const uint8_t *src;
+    int srcSize;
+    int minMatch;
+    int maxMatch;
+    uint32_t maxDistance;
+    std::vector<int> head;
+    std::vector<int> prev;
+
+    MatchFinder(const uint8_t *src_, int srcSize_, int minMatch_, int maxMatch_, uint32_t maxDistance_)
+        : src(src_), srcSize(srcSize_), minMatch(minMatch_), maxMatch(maxMatch_), maxDistance(maxDistance_),
+          head(1 << HASH_BITS, -1), prev(srcSize_ > 0 ? srcSize_ : 1, -1) {
+    }
+
+    uint32_t hash(int pos) {
+        uint32_t value = src[pos] | (src[pos + 1] << 8) | (src[pos + 2] << 16);
+        return (value * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    void insert(int pos) {
+        if (pos + 3 <= srcSize) {
+            uint32_t h = hash(pos);
+            prev[pos] = head[h];
+            head[h] = pos;
+        }
+    }
+
+    // match must end before matchEnd
+    int find(int pos, int matchEnd, uint32_t &distance) {
+        if (pos + minMatch > matchEnd || pos + 3 > srcSize) {
+            return 0;
+        }
+
+        int maxLength = matchEnd - pos < maxMatch ? matchEnd - pos : maxMatch;
+        int bestLength = 0;
+        int candidate = head[hash(pos)];
+        for (int depth = 0; candidate >= 0 && (uint32_t)(pos - candidate) <= maxDistance && depth < MAX_CHAIN; depth++) {
+            int length = 0;
+            while (length < maxLength && src[candidate + length] == src[pos + length]) {
+                length++;
+            }
+            if (length > bestLength) {
+                bestLength = length;
+                distance = pos - candidate;
+                if (length == maxLength) {
+                    break;
+                }
+            }
+            candidate = prev[candidate];
+        }
+
+        return bestLength >= minMatch ? bestLength : 0;
+    }
+};
+
+void lz4Compress(const uint8_t *src, int srcSize, std::vector<uint8_t> &dst) {
+    // LZ4 format: last match starts at least 12 bytes before the end and
+    // the last 5 bytes are literals
+    static const int MATCH_START_LIMIT = 12;
+    static const int LAST_LITERALS = 5;
+
+    MatchFinder matchFinder(src, srcSize, 4, 65535, 65535);
+
+    dst.clear();
+
+    int anchor = 0;
+    int ip = 0;
+    while (ip < srcSize - MATCH_START_LIMIT) {
+        uint32_t distance = 0;
+        int length = matchFinder.find(ip, srcSize - LAST_LITERALS, distance);
+        matchFinder.insert(ip);
+
+        uint32_t nextDistance = 0;
+        if (length == 0 || matchFinder.find(ip + 1, srcSize - LAST_LITERALS, nextDistance) > length) {
+            ip++;
+            continue;
+        }
+
+        writeSequence(dst, src + anchor, ip - anchor, distance, length);
+        for (int i = 1; i < length; i++) {
+            matchFinder.insert(ip + i);
+        }
+        ip += length;
+        anchor = ip;
+    }
+
+    writeSequence(dst, src + anchor, srcSize - anchor, 0, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+using namespace lzr;
+
+struct RangeEncoder {
+    std::vector<uint8_t> &dst;
+    uint64_t low = 0;
+    uint32_t range = 0xFFFFFFFF;
+    uint8_t cache = 0;
+    uint64_t cacheSize = 1;
+
+    explicit RangeEncoder(std::vector<uint8_t> &dst_) : dst(dst_) {
+    }
+
+    void shiftLow() {
+        if ((uint32_t)low < 0xFF000000 || (uint32_t)(low >> 32) != 0) {
+            uint8_t temp = cache;
+            do {
+                dst.push_back((uint8_t)(temp + (uint8_t)(low >> 32)));
+                temp = 0xFF;
+            } while (--cacheSize != 0);
+            cache = (uint8_t)((uint32_t)low >> 24);
+        }
+        cacheSize++;
+        low = (uint32_t)low << 8;
+    }
+
+    void encodeBit(uint16_t &prob, int bit) {
+        uint32_t bound = (range >> NUM_PROB_BITS) * prob;
+        if (bit == 0) {
+            range = bound;
+            prob += ((1 << NUM_PROB_BITS) - prob) >> NUM_MOVE_BITS;
+        } else {
+            low += bound;
+            range -= bound;
+            prob -= prob >> NUM_MOVE_BITS;
+        }
+        while (range < TOP_VALUE) {
+            range <<= 8;
+            shiftLow();
+        }
+    }
+
+    void encodeDirect(uint32_t value, int numBits) {
+        for (int i = numBits - 1; i >= 0; i--) {
+            range >>= 1;
+            if ((value >> i) & 1) {
+                low += range;
+            }
+            while (range < TOP_VALUE) {
+                range <<= 8;
+                shiftLow();
+            }
+        }
+    }
+
+    void encodeTree(uint16_t *probs, int numBits, uint32_t value) {
+        uint32_t m = 1;
+        for (int i = numBits - 1; i >= 0; i--) {
+            int bit = (value >> i) & 1;
+            encodeBit(probs[m], bit);
+            m = (m << 1) | bit;
+        }
+    }
+
+    void flush() {
+        for (int i = 0; i < 5; i++) {
+            shiftLow();
+        }
+    }
+};
+
+} // namespace
+
+void lzrCompress(const uint8_t *src, int srcSize, std::vector<uint8_t> &dst) {
+    dst.clear();
+
+    Model model;
+    initModel(model);
+
+    RangeEncoder rc(dst);
+    MatchFinder matchFinder(src, srcSize, MIN_MATCH, MAX_MATCH, MAX_DISTANCE);
+
+    int prevMatch = 0;
+
+    auto encodeLiteral = [&](int pos) {
+        rc.encodeBit(model.isMatch[prevMatch], 0);
+        int context = pos > 0 ? src[pos - 1] >> 5 : 0;
+        rc.encodeTree(model.literal[context], 8, src[pos]);
+        prevMatch = 0;
+    };
+
+    auto encodeMatch = [&](int length, uint32_t distance) {
+        rc.encodeBit(model.isMatch[prevMatch], 1);
+
+        uint32_t len = length - MIN_MATCH;
+        if (len < 8) {
+            rc.encodeBit(model.lengthChoice, 0);
+            rc.encodeTree(model.lengthLow, 3, len);
+        } else if (len < 16) {
+            rc.encodeBit(model.lengthChoice, 1);
+            rc.encodeBit(model.lengthChoice2, 0);
+            rc.encodeTree(model.lengthMid, 3, len - 8);
+        } else {
+            rc.encodeBit(model.lengthChoice, 1);
+            rc.encodeBit(model.lengthChoice2, 1);
+            rc.encodeTree(model.lengthHigh, 8, len - 16);
+        }
+
+        int lengthContext = len < NUM_LENGTH_CONTEXTS ? len : NUM_LENGTH_CONTEXTS - 1;
+        uint32_t dist = distance - 1;
+        int slot = getDistanceSlot(dist);
+        rc.encodeTree(model.distanceSlot[lengthContext], NUM_DISTANCE_SLOT_BITS, slot);
+        if (slot >= 4) {
+            int footerBits = (slot >> 1) - 1;
+            rc.encodeDirect(dist - ((2 | (slot & 1)) << footerBits), footerBits);
+        }
+
+        prevMatch = 1;
+    };
+
+    int pos = 0;
+    while (pos < srcSize) {
+        uint32_t distance = 0;
+        int length = matchFinder.find(pos, srcSize, distance);
+        matchFinder.insert(pos);
+
+        // short match far away costs more than the literals
+        if (length == MIN_MATCH && distance > 4096) {
+            length = 0;
+        }
+
+        if (length == 0) {
+            encodeLiteral(pos);
+            pos++;
+            continue;
+        }
+
+        // one step lazy matching: literal now if the next match is longer
+        uint32_t nextDistance = 0;
+        if (matchFinder.find(pos + 1, srcSize, nextDistance) > length) {
+            encodeLiteral(pos);
+            pos++;
+            continue;
+        }
+
+        encodeMatch(length, distance);
+        for (int i = 1; i < length; i++) {
+            matchFinder.insert(pos + i);
+        }
+        pos += length;
+    }
+
+    rc.flush();
+}
+
+void compress(int codec, const uint8_t *src, int srcSize, std::vector<uint8_t> &dst) {
+    if (codec == CODEC_LZ4) {
+        lz4Compress(src, srcSize, dst);
+    } else if (codec == CODEC_LZR) {
+        lzrCompress(src, srcSize, dst);
+    } else {
+        dst.assign(src, src + srcSize);
+    }
+}
+
+} // namespace assets_compress
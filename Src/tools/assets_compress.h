@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+// Host side compressors for the codecs in gui/assets_codec.h.
+
+namespace assets_compress {
+
+// LZ4 block format (greedy, one hash table entry per position).
+void lz4Compress(const uint8_t *src, int srcSize, std::vector<uint8_t> &dst);
+
+// LZR (hash chains, one step lazy matching).
+void lzrCompress(const uint8_t *src, int srcSize, std::vector<uint8_t> &dst);
+
+void compress(int codec, const uint8_t *src, int srcSize, std::vector<uint8_t> &dst);
+
+} // namespace assets_compress
@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "gui/assets_codec.h"
+#include "gui/lazy_assets.h"
+
+#include "assets_compress.h"
+
+#include "assets_file.h"
+
+using namespace eez::gui;
+
+namespace assets_file {
+
+const char *getPlatformName(Platform platform) {
+    return platform == PLATFORM_STM32 ? "STM32" : "SIMULATOR";
+}
+
+bool readFile(const char *path, std::vector<uint8_t> &data) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "can't open %s\n", path);
+        return false;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    data.resize(size);
+    bool ok = fread(data.data(), 1, size, fp) == (size_t)size;
+    fclose(fp);
+    return ok;
+}
+
+bool writeFile(const char *path, const void *data, size_t size) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        fprintf(stderr, "can't create %s\n", path);
+        return false;
+    }
+    bool ok = fwrite(data, 1, size, fp) == size;
+    fclose(fp);
+    return ok;
+}
+
+bool readDocument(const char *documentPath, Platform platform, std::vector<uint8_t> &compressed) {
+    std::vector<uint8_t> file;
+    if (!readFile(documentPath, file)) {
+        return false;
+    }
+    std::string text(file.begin(), file.end());
+
+    // "#if defined(EEZ_PLATFORM_STM32)" or "#elif defined(EEZ_PLATFORM_SIMULATOR)"
+    std::string platformBegin = std::string("defined(EEZ_PLATFORM_") + getPlatformName(platform) + ")";
+    size_t pos = text.find(platformBegin);
+    if (pos == std::string::npos) {
+        fprintf(stderr, "%s section not found in %s\n", getPlatformName(platform), documentPath);
+        return false;
+    }
+
+    pos = text.find("const uint8_t assets[", pos);
+    if (pos == std::string::npos) {
+        fprintf(stderr, "assets array not found in %s\n", documentPath);
+        return false;
+    }
+
+    size_t begin = text.find('{', pos);
+    size_t end = text.find("};", pos);
+    if (begin == std::string::npos || end == std::string::npos) {
+        return false;
+    }
+
+    compressed.clear();
+    for (size_t i = begin; i < end; i++) {
+        if (text[i] == '0' && (text[i + 1] == 'x' || text[i + 1] == 'X')) {
+            compressed.push_back((uint8_t)strtoul(text.c_str() + i, nullptr, 16));
+            i += 3;
+        }
+    }
+
+    return !compressed.empty();
+}
+
+bool decompress(const std::vector<uint8_t> &compressed, Header &header, std::vector<uint8_t> &decompressed) {
+    if (compressed.size() < sizeof(Header)) {
+        return false;
+    }
+
+    memcpy(&header, compressed.data(), sizeof(Header));
+    if (header.tag != HEADER_TAG) {
+        fprintf(stderr, "unknown assets header\n");
+        return false;
+    }
+
+    decompressed.resize(header.decompressedSize);
+    int result = assets_codec::lz4Decompress(compressed.data() + sizeof(Header), (int)(compressed.size() - sizeof(Header)),
+        decompressed.data(), (int)decompressed.size());
+    if (result != (int)header.decompressedSize) {
+        fprintf(stderr, "decompression failed\n");
+        return false;
+    }
+
+    return true;
+}
+
+void compress(const Header &header, const std::vector<uint8_t> &decompressed, std::vector<uint8_t> &compressed) {
+    Header newHeader = header;
+    newHeader.decompressedSize = (uint32_t)decompressed.size();
+
+    std::vector<uint8_t> data;
+    assets_compress::lz4Compress(decompressed.data(), (int)decompressed.size(), data);
+
+    compressed.resize(sizeof(Header));
+    memcpy(compressed.data(), &newHeader, sizeof(Header));
+    compressed.insert(compressed.end(), data.begin(), data.end());
+}
+
+static int selectCodec(const uint8_t *src, int srcSize, std::vector<uint8_t> &compressed) {
+    std::vector<uint8_t> lz4;
+    assets_compress::lz4Compress(src, srcSize, lz4);
+
+    std::vector<uint8_t> lzr;
+    assets_compress::lzrCompress(src, srcSize, lzr);
+
+    if (lzr.size() * 10 <= lz4.size() * 9) {
+        compressed.swap(lzr);
+        return assets_codec::CODEC_LZR;
+    }
+
+    if (lz4.size() < (size_t)srcSize) {
+        compressed.swap(lz4);
+        return assets_codec::CODEC_LZ4;
+    }
+
+    compressed.assign(src, src + srcSize);
+    return assets_codec::CODEC_STORED;
+}
+
+int parseCodec(const char *name) {
+    if (strcmp(name, "auto") == 0) {
+        return CODEC_AUTO;
+    }
+    for (int i = 0; i < assets_codec::NUM_CODECS; i++) {
+        if (strcmp(name, assets_codec::getCodecName(i)) == 0) {
+            return i;
+        }
+    }
+    return -2;
+}
+
+void buildLazyImage(const Header &header, const std::vector<uint8_t> &decompressed, uint32_t blockSize, int codec, std::vector<uint8_t> &image) {
+    lazy_assets::Header lazyHeader;
+    lazyHeader.tag = lazy_assets::HEADER_TAG;
+    lazyHeader.projectMajorVersion = header.projectMajorVersion;
+    lazyHeader.projectMinorVersion = header.projectMinorVersion;
+    lazyHeader.decompressedSize = (uint32_t)decompressed.size();
+    lazyHeader.blockSize = blockSize;
+    lazyHeader.numBlocks = (uint32_t)((decompressed.size() + blockSize - 1) / blockSize);
+
+    std::vector<lazy_assets::BlockEntry> blocks(lazyHeader.numBlocks);
+    std::vector<uint8_t> data;
+    uint32_t dataOffset = sizeof(lazyHeader) + lazyHeader.numBlocks * sizeof(lazy_assets::BlockEntry);
+
+    for (uint32_t i = 0; i < lazyHeader.numBlocks; i++) {
+        uint32_t offset = i * blockSize;
+        uint32_t size = (uint32_t)decompressed.size() - offset;
+        if (size > blockSize) {
+            size = blockSize;
+        }
+
+        std::vector<uint8_t> compressed;
+        int blockCodec = codec;
+        if (codec == CODEC_AUTO) {
+            blockCodec = selectCodec(decompressed.data() + offset, size, compressed);
+        } else {
+            assets_compress::compress(codec, decompressed.data() + offset, size, compressed);
+        }
+
+        memset(&blocks[i], 0, sizeof(lazy_assets::BlockEntry));
+        blocks[i].compressedOffset = dataOffset + (uint32_t)data.size();
+        blocks[i].compressedSize = (uint32_t)compressed.size();
+        blocks[i].codec = (uint8_t)blockCodec;
+        data.insert(data.end(), compressed.begin(), compressed.end());
+    }
+
+    image.resize(sizeof(lazyHeader));
+    memcpy(image.data(), &lazyHeader, sizeof(lazyHeader));
+    auto blocksBytes = (const uint8_t *)blocks.data();
+    image.insert(image.end(), blocksBytes, blocksBytes + blocks.size() * sizeof(lazy_assets::BlockEntry));
+    image.insert(image.end(), data.begin(), data.end());
+}
+
+void writeArray(std::string &out, const uint8_t *data, size_t size) {
+    char buffer[8];
+    for (size_t i = 0; i < size; i++) {
+        if (i % 16 == 0) {
+            out += "    ";
+        }
+        snprintf(buffer, sizeof(buffer), "0x%02X", data[i]);
+        out += buffer;
+        if (i + 1 < size) {
+            out += i % 16 == 15 ? ",\n" : ", ";
+        }
+    }
+    out += "\n";
+}
+
+} // namespace assets_file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// Reads the assets[] arrays generated by EEZ Studio into gui/document.cpp
+// and decompresses them. Shared by the asset tools.
+
+namespace assets_file {
+
+// "~eez" followed by the project version and the decompressed size
+static const uint32_t HEADER_TAG = 0x7A65657E;
+
+struct Header {
+    uint32_t tag;
+    uint16_t projectMajorVersion;
+    uint16_t projectMinorVersion;
+    uint32_t decompressedSize;
+};
+
+enum Platform {
+    PLATFORM_STM32,
+    PLATFORM_SIMULATOR
+};
+
+const char *getPlatformName(Platform platform);
+
+// Parse assets[] array for the given platform from document.cpp.
+bool readDocument(const char *documentPath, Platform platform, std::vector<uint8_t> &compressed);
+
+// Decompress "~eez" assets, decompressed data starts with settings.
+bool decompress(const std::vector<uint8_t> &compressed, Header &header, std::vector<uint8_t> &decompressed);
+
+// Inverse of decompress(), LZ4 compressed like assets[] in document.cpp.
+void compress(const Header &header, const std::vector<uint8_t> &decompressed, std::vector<uint8_t> &compressed);
+
+// Selects codec per block: LZR if it is at least 10% smaller than LZ4,
+// stored if LZ4 doesn't make it smaller, otherwise LZ4.
+static const int CODEC_AUTO = -1;
+
+// Block compressed image for gui/lazy_assets.h, codec is one of
+// assets_codec::Codec or CODEC_AUTO.
+void buildLazyImage(const Header &header, const std::vector<uint8_t> &decompressed, uint32_t blockSize, int codec, std::vector<uint8_t> &image);
+
+int parseCodec(const char *name);
+
+bool readFile(const char *path, std::vector<uint8_t> &data);
+bool writeFile(const char *path, const void *data, size_t size);
+
+// Write C array definition, 16 bytes per line like in document.cpp.
+void writeArray(std::string &out, const uint8_t *data, size_t size);
+
+} // namespace assets_file
@@ -0,0 +1,82 @@
+// Generates gui/document_lazy.cpp with block compressed assets image (see
+// gui/lazy_assets.h) from the assets[] arrays in gui/document.cpp. Run it
+// after EEZ Studio build when OPTION_LAZY_ASSETS is enabled:
+//
+//   assets_lazy_gen ../../gui/document.cpp ../../gui/document_lazy.cpp [blockSize] [codec]
+//
+// codec is stored, lz4 (default), lzr or auto (see assets_file.h)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "gui/assets_codec.h"
+
+#include "assets_file.h"
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <document.cpp> <document_lazy.cpp> [blockSize] [stored|lz4|lzr|auto]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t blockSize = argc > 3 ? (uint32_t)atoi(argv[3]) : 8192;
+    if (blockSize == 0 || blockSize % 4096 != 0) {
+        fprintf(stderr, "block size must be multiple of 4096\n");
+        return 1;
+    }
+
+    int codec = argc > 4 ? assets_file::parseCodec(argv[4]) : eez::gui::assets_codec::CODEC_LZ4;
+    if (codec < assets_file::CODEC_AUTO) {
+        fprintf(stderr, "unknown codec %s\n", argv[4]);
+        return 1;
+    }
+
+    std::string out;
+    out += "// Generated by Src/tools/assets_lazy_gen from document.cpp, do not edit.\n\n";
+    out += "#include <stdint.h>\n\n";
+    out += "#include \"eez-framework-conf.h\"\n\n";
+    out += "#if OPTION_LAZY_ASSETS\n\n";
+    out += "namespace eez {\nnamespace gui {\n\n";
+
+    assets_file::Platform platforms[] = { assets_file::PLATFORM_STM32, assets_file::PLATFORM_SIMULATOR };
+    for (int i = 0; i < 2; i++) {
+        std::vector<uint8_t> compressed;
+        if (!assets_file::readDocument(argv[1], platforms[i], compressed)) {
+            return 1;
+        }
+
+        assets_file::Header header;
+        std::vector<uint8_t> decompressed;
+        if (!assets_file::decompress(compressed, header, decompressed)) {
+            return 1;
+        }
+
+        std::vector<uint8_t> image;
+        assets_file::buildLazyImage(header, decompressed, blockSize, codec, image);
+
+        printf("%-10s compressed: %7u, block compressed: %7u bytes, %u blocks\n",
+            assets_file::getPlatformName(platforms[i]), (unsigned)compressed.size(), (unsigned)image.size(),
+            (unsigned)((decompressed.size() + blockSize - 1) / blockSize));
+
+        char line[128];
+        out += i == 0 ? "#if defined(EEZ_PLATFORM_STM32)\n\n" : "#elif defined(EEZ_PLATFORM_SIMULATOR)\n\n";
+        snprintf(line, sizeof(line), "extern const uint8_t block_assets[%u];\n", (unsigned)image.size());
+        out += line;
+        snprintf(line, sizeof(line), "extern const uint32_t block_assets_size = %u;\n\n", (unsigned)image.size());
+        out += line;
+        out += "alignas(4)\n";
+        snprintf(line, sizeof(line), "const uint8_t block_assets[%u] = {\n", (unsigned)image.size());
+        out += line;
+        assets_file::writeArray(out, image.data(), image.size());
+        out += "};\n\n";
+    }
+
+    out += "#endif\n\n";
+    out += "} // namespace gui\n} // namespace eez\n\n";
+    out += "#endif // OPTION_LAZY_ASSETS\n";
+
+    return assets_file::writeFile(argv[2], out.data(), out.size()) ? 0 : 1;
+}
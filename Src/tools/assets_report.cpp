@@ -0,0 +1,576 @@
+// Breakdown of the assets[] arrays in gui/document.cpp by section, page,
+// style, font, glyph range and bitmap, in decompressed and compressed
+// bytes. Compressed bytes are attributed exactly: while the LZ4 stream is
+// decoded each literal is charged to its output byte and the token, length
+// and offset bytes of a sequence are spread over the bytes it outputs.
+//
+//   assets_report ../../gui/document.cpp [stm32|simulator]
+//   assets_report --diff old/document.cpp new/document.cpp [stm32|simulator]
+//
+// Names come from the enums in document.h next to document.cpp. Widget
+// struct sizes are not in the assets, they are inferred per widget type
+// from the distance to the next widget. Flow definition and widget specific
+// data (strings, expressions, ...) are reported as not attributed.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "assets_file.h"
+
+struct Item {
+    std::string section;
+    std::string name; // items are matched by section and name in diff
+    std::string note;
+    uint32_t size;
+    double compressedSize;
+};
+
+struct Report {
+    uint32_t compressedSize;
+    uint32_t decompressedSize;
+    std::vector<Item> items;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool decompressWithCost(const uint8_t *src, uint32_t srcSize, std::vector<uint8_t> &dst, std::vector<double> &cost) {
+    uint32_t i = 0;
+    while (i < srcSize) {
+        uint32_t sequenceStart = i;
+        uint8_t token = src[i++];
+
+        uint32_t literalLength = token >> 4;
+        if (literalLength == 15) {
+            uint8_t b;
+            do {
+                if (i >= srcSize) return false;
+                b = src[i++];
+                literalLength += b;
+            } while (b == 255);
+        }
+        if (i + literalLength > srcSize) {
+            return false;
+        }
+        for (uint32_t j = 0; j < literalLength; j++) {
+            dst.push_back(src[i++]);
+            cost.push_back(1.0);
+        }
+
+        uint32_t literalsEnd = (uint32_t)dst.size();
+
+        if (i >= srcSize) {
+            // last sequence has only literals
+            if (literalLength > 0) {
+                double overhead = (double)(i - sequenceStart - literalLength) / literalLength;
+                for (uint32_t j = literalsEnd - literalLength; j < literalsEnd; j++) {
+                    cost[j] += overhead;
+                }
+            }
+            break;
+        }
+
+        if (i + 2 > srcSize) {
+            return false;
+        }
+        uint32_t offset = src[i] | (src[i + 1] << 8);
+        i += 2;
+
+        uint32_t matchLength = token & 15;
+        if (matchLength == 15) {
+            uint8_t b;
+            do {
+                if (i >= srcSize) return false;
+                b = src[i++];
+                matchLength += b;
+            } while (b == 255);
+        }
+        matchLength += 4;
+
+        if (offset == 0 || offset > dst.size()) {
+            return false;
+        }
+
+        double overhead = (double)(i - sequenceStart - literalLength) / matchLength;
+        for (uint32_t j = 0; j < matchLength; j++) {
+            dst.push_back(dst[dst.size() - offset]);
+            cost.push_back(overhead);
+        }
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// enum names from document.h for the platform, e.g. "FONT_ID_" -> text_m
+typedef std::map<std::string, std::map<uint32_t, std::string>> Names;
+
+static void readNames(const char *documentPath, assets_file::Platform platform, Names &names) {
+    std::string path = documentPath;
+    auto dot = path.rfind('.');
+    if (dot == std::string::npos) {
+        return;
+    }
+    path = path.substr(0, dot) + ".h";
+
+    std::vector<uint8_t> data;
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (!fp) {
+        return;
+    }
+    fclose(fp);
+    if (!assets_file::readFile(path.c_str(), data)) {
+        return;
+    }
+    std::string text(data.begin(), data.end());
+
+    std::string marker = std::string("defined(EEZ_PLATFORM_") + (platform == assets_file::PLATFORM_STM32 ? "STM32" : "SIMULATOR") + ")";
+    auto start = text.find(marker);
+    if (start == std::string::npos) {
+        return;
+    }
+    auto end = text.find("#endif", start);
+    auto elif = text.find("#elif", start);
+    if (elif < end) {
+        end = elif;
+    }
+
+    static const char *PREFIXES[] = { "PAGE_ID_", "STYLE_ID_", "FONT_ID_", "BITMAP_ID_" };
+    for (auto prefix : PREFIXES) {
+        for (auto pos = text.find(prefix, start); pos < end; pos = text.find(prefix, pos + 1)) {
+            auto nameStart = pos + strlen(prefix);
+            auto nameEnd = nameStart;
+            while (nameEnd < text.size() && (isalnum((uint8_t)text[nameEnd]) || text[nameEnd] == '_')) {
+                nameEnd++;
+            }
+            auto eq = text.find_first_not_of(' ', nameEnd);
+            if (eq == std::string::npos || text[eq] != '=') {
+                continue;
+            }
+            std::string name = text.substr(nameStart, nameEnd - nameStart);
+            for (auto &ch : name) {
+                ch = (char)tolower((uint8_t)ch);
+            }
+            names[prefix][(uint32_t)atoi(text.c_str() + eq + 1)] = name;
+        }
+    }
+}
+
+static std::string getName(Names &names, const char *prefix, uint32_t id, const char *fallback) {
+    auto &map = names[prefix];
+    auto it = map.find(id);
+    if (it != map.end()) {
+        return it->second;
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "%s #%u", fallback, id);
+    return name;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Decompressed assets layout, offsets are from the start of the data after
+// the 8-byte Assets prefix. Pointers are self-relative, lists are
+// { count, pointer to array of pointers }.
+struct Walker {
+    const std::vector<uint8_t> &data;
+    const std::vector<double> &cost;
+    std::vector<int> owner;
+    std::vector<Item> &items;
+
+    Walker(const std::vector<uint8_t> &data_, const std::vector<double> &cost_, std::vector<Item> &items_)
+        : data(data_), cost(cost_), owner(data_.size(), -1), items(items_) {
+    }
+
+    uint32_t u32(uint32_t offset) {
+        if (offset + 4 > data.size()) {
+            return 0;
+        }
+        uint32_t value;
+        memcpy(&value, data.data() + offset, 4);
+        return value;
+    }
+
+    uint16_t u16(uint32_t offset) {
+        return offset + 2 <= data.size() ? (uint16_t)(data[offset] | (data[offset + 1] << 8)) : 0;
+    }
+
+    uint32_t ptr(uint32_t offset) {
+        uint32_t value = u32(offset);
+        return value ? offset + value : 0;
+    }
+
+    uint32_t listCount(uint32_t offset) {
+        return u32(offset);
+    }
+
+    uint32_t listItem(uint32_t offset, uint32_t index) {
+        return ptr(ptr(offset + 4) + 4 * index);
+    }
+
+    int addItem(const char *section, const std::string &name) {
+        items.push_back(Item{ section, name, "", 0, 0.0 });
+        return (int)items.size() - 1;
+    }
+
+    // objects are 4 byte aligned, offset 0 is null pointer except for the
+    // root object
+    void claim(int item, uint32_t offset, uint32_t size, bool isRoot = false) {
+        if (offset == 0 && !isRoot) {
+            return;
+        }
+        size = (size + 3) & ~3;
+        for (uint32_t i = offset; i < offset + size && i < data.size(); i++) {
+            if (owner[i] == -1) {
+                owner[i] = item;
+            }
+        }
+    }
+
+    void claimListArray(int item, uint32_t list) {
+        claim(item, ptr(list + 4), 4 * listCount(list));
+    }
+
+    void finish() {
+        int rest = addItem("other", "flow definition and widget data (not attributed)");
+        for (uint32_t i = 0; i < data.size(); i++) {
+            if (owner[i] == -1) {
+                owner[i] = rest;
+            }
+            items[owner[i]].size++;
+            items[owner[i]].compressedSize += cost[i];
+        }
+    }
+};
+
+static void collectWidgets(Walker &walker, uint32_t widget, std::vector<uint32_t> &widgets) {
+    widgets.push_back(widget);
+    if (walker.u16(widget) == 1) {
+        // container, widgets list at +28
+        uint32_t n = walker.listCount(widget + 28);
+        for (uint32_t i = 0; i < n; i++) {
+            collectWidgets(walker, walker.listItem(widget + 28, i), widgets);
+        }
+    }
+}
+
+static void buildReport(const std::vector<uint8_t> &data, const std::vector<double> &cost, Names &names, std::vector<Item> &items) {
+    Walker walker(data, cost, items);
+
+    // Assets: settings, pages, styles, fonts, bitmaps, colors, action names,
+    // variable names, flow definition, languages
+    int header = walker.addItem("header", "root and settings");
+    walker.claim(header, 0, 68, true);
+    walker.claim(header, walker.ptr(0), 4);
+
+    // pages
+
+    uint32_t numPages = walker.listCount(4);
+    std::vector<std::vector<uint32_t>> pageWidgets(numPages);
+    std::vector<uint32_t> allWidgets;
+    for (uint32_t i = 0; i < numPages; i++) {
+        collectWidgets(walker, walker.listItem(4, i), pageWidgets[i]);
+        allWidgets.insert(allWidgets.end(), pageWidgets[i].begin(), pageWidgets[i].end());
+    }
+
+    // widget struct size per type: most common distance to the next widget
+    std::sort(allWidgets.begin(), allWidgets.end());
+    std::map<uint16_t, std::map<uint32_t, uint32_t>> distances;
+    for (size_t i = 0; i + 1 < allWidgets.size(); i++) {
+        uint32_t distance = allWidgets[i + 1] - allWidgets[i];
+        if (distance <= 256) {
+            distances[walker.u16(allWidgets[i])][distance]++;
+        }
+    }
+    std::map<uint16_t, uint32_t> widgetSizes;
+    for (auto &it : distances) {
+        uint32_t best = 0;
+        for (auto &d : it.second) {
+            if (best == 0 || d.second > it.second[best]) {
+                best = d.first;
+            }
+        }
+        widgetSizes[it.first] = best;
+    }
+
+    int pageTable = walker.addItem("pages", "(page list)");
+    walker.claimListArray(pageTable, 4);
+
+    for (uint32_t i = 0; i < numPages; i++) {
+        int item = walker.addItem("pages", getName(names, "PAGE_ID_", i + 1, "page"));
+        items[item].note = std::to_string(pageWidgets[i].size()) + " widgets";
+        for (auto widget : pageWidgets[i]) {
+            auto it = widgetSizes.find(walker.u16(widget));
+            // Widget: type, data, visible, action, x, y, w, h, style, flags, timeline
+            walker.claim(item, widget, it != widgetSizes.end() ? it->second : 28);
+            walker.claimListArray(item, widget + 20);
+            if (walker.u16(widget) == 1) {
+                walker.claimListArray(item, widget + 28);
+            }
+        }
+    }
+
+    // styles
+
+    int styleTable = walker.addItem("styles", "(style list)");
+    walker.claimListArray(styleTable, 12);
+    int localStyles = -1;
+    uint32_t numLocalStyles = 0;
+    for (uint32_t i = 0; i < walker.listCount(12); i++) {
+        int item;
+        if (names["STYLE_ID_"].count(i + 1)) {
+            item = walker.addItem("styles", names["STYLE_ID_"][i + 1]);
+        } else {
+            // styles set in the widget properties
+            if (localStyles == -1) {
+                localStyles = walker.addItem("styles", "(widget local styles)");
+            }
+            item = localStyles;
+            numLocalStyles++;
+        }
+        walker.claim(item, walker.listItem(12, i), 36);
+    }
+    if (localStyles != -1) {
+        items[localStyles].note = std::to_string(numLocalStyles) + " styles";
+    }
+
+    // fonts
+
+    int fontTable = walker.addItem("fonts", "(font list)");
+    walker.claimListArray(fontTable, 20);
+    for (uint32_t i = 0; i < walker.listCount(20); i++) {
+        uint32_t font = walker.listItem(20, i);
+        auto name = getName(names, "FONT_ID_", i + 1, "font");
+
+        // FontData: ascent, descent, reserved[2], encodingStart,
+        // encodingEnd, groups, glyphs
+        int item = walker.addItem("fonts", name);
+        walker.claim(item, font, 28);
+        walker.claimListArray(item, font + 12);
+        walker.claimListArray(item, font + 20);
+
+        for (uint32_t g = 0; g < walker.listCount(font + 12); g++) {
+            // GlyphsGroup: encoding, glyphIndex, length
+            uint32_t group = walker.listItem(font + 12, g);
+            walker.claim(item, group, 12);
+
+            uint32_t encoding = walker.u32(group);
+            uint32_t glyphIndex = walker.u32(group + 4);
+            uint32_t length = walker.u32(group + 8);
+
+            char rangeName[64];
+            snprintf(rangeName, sizeof(rangeName), "%s U+%04X-U+%04X", name.c_str(), encoding, encoding + length - 1);
+            int rangeItem = walker.addItem("glyphs", rangeName);
+            items[rangeItem].note = std::to_string(length) + " glyphs";
+            for (uint32_t j = glyphIndex; j < glyphIndex + length && j < walker.listCount(font + 20); j++) {
+                // GlyphData: dx, width, height, x, y, reserved[3], A8 pixels
+                uint32_t glyph = walker.listItem(font + 20, j);
+                if (glyph) {
+                    walker.claim(rangeItem, glyph, 8 + data[glyph + 1] * data[glyph + 2]);
+                }
+            }
+        }
+    }
+
+    // bitmaps
+
+    int bitmapTable = walker.addItem("bitmaps", "(bitmap list)");
+    walker.claimListArray(bitmapTable, 28);
+    for (uint32_t i = 0; i < walker.listCount(28); i++) {
+        // Bitmap: w, h, bpp, reserved, pixels
+        uint32_t bitmap = walker.listItem(28, i);
+        uint32_t w = walker.u16(bitmap);
+        uint32_t h = walker.u16(bitmap + 2);
+        uint32_t bpp = walker.u16(bitmap + 4);
+        char note[64];
+        snprintf(note, sizeof(note), "%ux%u, %u bpp", w, h, bpp);
+        int item = walker.addItem("bitmaps", getName(names, "BITMAP_ID_", i + 1, "bitmap"));
+        items[item].note = note;
+        walker.claim(item, bitmap, 8 + w * h * bpp / 8);
+    }
+
+    // colors: themes, colors; Theme: name, colors
+
+    int colors = walker.addItem("colors", "themes and colors");
+    uint32_t colorsDefinition = walker.ptr(36);
+    if (colorsDefinition) {
+        walker.claim(colors, colorsDefinition, 16);
+        walker.claimListArray(colors, colorsDefinition);
+        for (uint32_t i = 0; i < walker.listCount(colorsDefinition); i++) {
+            uint32_t theme = walker.listItem(colorsDefinition, i);
+            walker.claim(colors, theme, 12);
+            uint32_t name = walker.ptr(theme);
+            if (name) {
+                walker.claim(colors, name, (uint32_t)strnlen((const char *)data.data() + name, data.size() - name) + 1);
+            }
+            walker.claim(colors, walker.ptr(theme + 8), 2 * walker.listCount(theme + 4));
+        }
+        walker.claim(colors, walker.ptr(colorsDefinition + 12), 2 * walker.listCount(colorsDefinition + 8));
+    }
+
+    walker.finish();
+}
+
+static bool report(const char *documentPath, assets_file::Platform platform, Report &result) {
+    std::vector<uint8_t> compressed;
+    if (!assets_file::readDocument(documentPath, platform, compressed)) {
+        return false;
+    }
+
+    assets_file::Header header;
+    if (compressed.size() < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, compressed.data(), sizeof(header));
+
+    std::vector<uint8_t> data;
+    std::vector<double> cost;
+    if (header.tag != assets_file::HEADER_TAG ||
+        !decompressWithCost(compressed.data() + sizeof(header), (uint32_t)(compressed.size() - sizeof(header)), data, cost) ||
+        data.size() != header.decompressedSize) {
+        fprintf(stderr, "%s: assets are not valid\n", assets_file::getPlatformName(platform));
+        return false;
+    }
+
+    Names names;
+    readNames(documentPath, platform, names);
+
+    result.compressedSize = (uint32_t)compressed.size();
+    result.decompressedSize = (uint32_t)data.size();
+    buildReport(data, cost, names, result.items);
+
+    // section totals first
+    std::vector<Item> sections;
+    for (auto &item : result.items) {
+        auto it = std::find_if(sections.begin(), sections.end(), [&](const Item &section) {
+            return section.section == item.section;
+        });
+        if (it == sections.end()) {
+            sections.push_back(Item{ item.section, "", "", 0, 0.0 });
+            it = sections.end() - 1;
+        }
+        it->size += item.size;
+        it->compressedSize += item.compressedSize;
+    }
+    for (auto &section : sections) {
+        section.name = "(total)";
+    }
+    result.items.insert(result.items.begin(), sections.begin(), sections.end());
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static std::string getLabel(const Item &item) {
+    return item.note.empty() ? item.name : item.name + " (" + item.note + ")";
+}
+
+static void printReport(assets_file::Platform platform, const Report &report) {
+    printf("%s: %u bytes compressed, %u bytes decompressed\n\n", assets_file::getPlatformName(platform),
+        report.compressedSize, report.decompressedSize);
+    printf("%-8s %-56s %10s %10s %6s\n", "section", "item", "bytes", "compressed", "%");
+
+    // section totals are first, then the items in the order they were added
+    for (auto &total : report.items) {
+        if (total.name != "(total)") {
+            continue;
+        }
+        printf("%-8s %-56s %10u %10.0f %5.1f%%\n", total.section.c_str(), "", total.size, total.compressedSize,
+            100.0 * total.compressedSize / report.compressedSize);
+        for (auto &item : report.items) {
+            if (item.section == total.section && item.name != "(total)") {
+                printf("%-8s   %-54s %10u %10.0f %5.1f%%\n", "", getLabel(item).c_str(), item.size, item.compressedSize,
+                    100.0 * item.compressedSize / report.compressedSize);
+            }
+        }
+    }
+    printf("\n");
+}
+
+static void printDiff(assets_file::Platform platform, const Report &oldReport, const Report &newReport) {
+    printf("%s: %u -> %u bytes compressed (%+d), %u -> %u bytes decompressed (%+d)\n\n", assets_file::getPlatformName(platform),
+        oldReport.compressedSize, newReport.compressedSize, (int)(newReport.compressedSize - oldReport.compressedSize),
+        oldReport.decompressedSize, newReport.decompressedSize, (int)(newReport.decompressedSize - oldReport.decompressedSize));
+    printf("%-8s %-50s %10s %10s %10s %10s\n", "section", "item", "bytes", "delta", "compressed", "delta");
+
+    auto key = [](const Item &item) {
+        return item.section + "\t" + item.name;
+    };
+
+    std::map<std::string, const Item *> oldItems;
+    for (auto &item : oldReport.items) {
+        oldItems[key(item)] = &item;
+    }
+
+    std::vector<std::string> seen;
+    auto printRow = [&](const Item *oldItem, const Item *newItem) {
+        uint32_t oldSize = oldItem ? oldItem->size : 0;
+        uint32_t newSize = newItem ? newItem->size : 0;
+        double oldCompressed = oldItem ? oldItem->compressedSize : 0.0;
+        double newCompressed = newItem ? newItem->compressedSize : 0.0;
+        if (oldSize == newSize && (int)(oldCompressed + 0.5) == (int)(newCompressed + 0.5)) {
+            return;
+        }
+        auto &item = newItem ? *newItem : *oldItem;
+        printf("%-8s %-50s %10u %+10d %10.0f %+10.0f%s\n", item.section.c_str(), getLabel(item).c_str(),
+            newSize, (int)(newSize - oldSize), newCompressed, newCompressed - oldCompressed,
+            !oldItem ? "  added" : !newItem ? "  removed" : "");
+    };
+
+    for (auto &item : newReport.items) {
+        auto it = oldItems.find(key(item));
+        printRow(it != oldItems.end() ? it->second : nullptr, &item);
+        if (it != oldItems.end()) {
+            oldItems.erase(it);
+        }
+    }
+    for (auto &item : oldReport.items) {
+        if (oldItems.count(key(item))) {
+            printRow(&item, nullptr);
+        }
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    bool diff = argc > 1 && strcmp(argv[1], "--diff") == 0;
+    int numDocuments = diff ? 2 : 1;
+    int firstDocument = diff ? 2 : 1;
+
+    if (argc < firstDocument + numDocuments) {
+        fprintf(stderr, "usage: %s <document.cpp> [stm32|simulator]\n", argv[0]);
+        fprintf(stderr, "       %s --diff <old document.cpp> <new document.cpp> [stm32|simulator]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<assets_file::Platform> platforms = { assets_file::PLATFORM_STM32, assets_file::PLATFORM_SIMULATOR };
+    if (argc > firstDocument + numDocuments) {
+        const char *platformName = argv[firstDocument + numDocuments];
+        platforms = { strcmp(platformName, "simulator") == 0 ? assets_file::PLATFORM_SIMULATOR : assets_file::PLATFORM_STM32 };
+    }
+
+    for (auto platform : platforms) {
+        Report reports[2];
+        for (int i = 0; i < numDocuments; i++) {
+            if (!report(argv[firstDocument + i], platform, reports[i])) {
+                return 1;
+            }
+        }
+
+        if (diff) {
+            printDiff(platform, reports[0], reports[1]);
+        } else {
+            printReport(platform, reports[0]);
+        }
+    }
+
+    return 0;
+}
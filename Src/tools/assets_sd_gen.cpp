@@ -0,0 +1,143 @@
+// Generates assets file for the SD card (see gui/sd_assets.h) from the
+// assets[] array for one platform in gui/document.cpp. Copy it to the root
+// of the card as ASSETS.BIN, it is used instead of the built-in assets when
+// OPTION_SD_ASSETS is enabled:
+//
+//   assets_sd_gen ../../gui/document.cpp ASSETS.BIN [stm32|simulator] [blockSize] [codec]
+//
+// codec is stored, lz4 (default), lzr or auto (see assets_file.h). Written
+// file is loaded back with gui/sd_assets.cpp and compared with the original
+// assets, also after switching to a copy with stored blocks.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "eez-framework-conf.h"
+
+#undef OPTION_SD_ASSETS
+#define OPTION_SD_ASSETS 1
+
+#include "gui/assets_codec.h"
+#include "gui/lazy_assets.h"
+#include "gui/sd_assets.cpp"
+
+#include "assets_file.h"
+
+using namespace eez::gui;
+
+// CRC trailer, computed on 32-bit words like the STM32 CRC unit
+static uint32_t appendCrc(std::vector<uint8_t> &image) {
+    image.resize((image.size() + 3) & ~3);
+    uint32_t crc = sd_assets::crc32(0xFFFFFFFF, (const uint32_t *)image.data(), image.size() / 4);
+    image.insert(image.end(), (const uint8_t *)&crc, (const uint8_t *)&crc + 4);
+    return crc;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <document.cpp> <ASSETS.BIN> [stm32|simulator] [blockSize] [stored|lz4|lzr|auto]\n", argv[0]);
+        return 1;
+    }
+
+    auto platform = argc > 3 && strcmp(argv[3], "simulator") == 0 ? assets_file::PLATFORM_SIMULATOR : assets_file::PLATFORM_STM32;
+
+    uint32_t blockSize = argc > 4 ? (uint32_t)atoi(argv[4]) : 8192;
+    if (blockSize == 0 || blockSize % 4096 != 0) {
+        fprintf(stderr, "block size must be multiple of 4096\n");
+        return 1;
+    }
+
+    int codec = argc > 5 ? assets_file::parseCodec(argv[5]) : assets_codec::CODEC_LZ4;
+    if (codec < assets_file::CODEC_AUTO) {
+        fprintf(stderr, "unknown codec %s\n", argv[5]);
+        return 1;
+    }
+
+    std::vector<uint8_t> compressed;
+    if (!assets_file::readDocument(argv[1], platform, compressed)) {
+        return 1;
+    }
+
+    assets_file::Header header;
+    std::vector<uint8_t> decompressed;
+    if (!assets_file::decompress(compressed, header, decompressed)) {
+        return 1;
+    }
+
+    std::vector<uint8_t> image;
+    assets_file::buildLazyImage(header, decompressed, blockSize, codec, image);
+
+    lazy_assets::Header lazyHeader;
+    memcpy(&lazyHeader, image.data(), sizeof(lazyHeader));
+    auto blocks = (const lazy_assets::BlockEntry *)(image.data() + sizeof(lazy_assets::Header));
+    uint32_t maxBlockSize = 0;
+    for (uint32_t i = 0; i < lazyHeader.numBlocks; i++) {
+        if (blocks[i].compressedSize > maxBlockSize) {
+            maxBlockSize = blocks[i].compressedSize;
+        }
+    }
+
+    uint32_t crc = appendCrc(image);
+
+    printf("%s: %u bytes, %u blocks of %u, largest compressed block %u, CRC 0x%08X\n",
+        assets_file::getPlatformName(platform), (unsigned)image.size(), lazyHeader.numBlocks,
+        blockSize, maxBlockSize, crc);
+
+    // STM32 values from eez-framework-conf.h, tools are built for the simulator
+    if (platform == assets_file::PLATFORM_STM32 && (maxBlockSize > 9 * 1024 || lazyHeader.numBlocks > 64)) {
+        fprintf(stderr, "warning: increase SD_ASSETS_BLOCK_BUFFER_SIZE or SD_ASSETS_MAX_BLOCKS for STM32\n");
+    }
+
+    if (!assets_file::writeFile(argv[2], image.data(), image.size())) {
+        return 1;
+    }
+
+    // load it back
+    std::vector<uint8_t> region(lazy_assets::ASSETS_PREFIX_SIZE + decompressed.size());
+    auto assets = (const uint8_t *)sd_assets::load(argv[2], region.data(), (uint32_t)region.size());
+    if (!assets) {
+        fprintf(stderr, "written file is not valid\n");
+        return 1;
+    }
+
+    bool identical = memcmp(assets + lazy_assets::ASSETS_PREFIX_SIZE, decompressed.data(), decompressed.size()) == 0;
+
+    printf("loaded back: %s, demand paging: %s, sectors hit %u, missed %u, read direct %u\n",
+        identical ? "identical" : "MISMATCH", lazy_assets::isDemandPaging() ? "yes" : "no",
+        sd_assets::g_stats.sectorHits, sd_assets::g_stats.sectorMisses, sd_assets::g_stats.sectorsReadDirect);
+
+    // switch to a file with another layout before the loaded assets are
+    // read, their blocks must still come from their own file
+    std::vector<uint8_t> storedImage;
+    assets_file::buildLazyImage(header, decompressed, blockSize, assets_codec::CODEC_STORED, storedImage);
+    appendCrc(storedImage);
+    std::string storedPath = std::string(argv[2]) + ".stored";
+    assets_file::writeFile(storedPath.c_str(), storedImage.data(), storedImage.size());
+    auto previous = (const uint8_t *)sd_assets::load(argv[2], region.data(), (uint32_t)region.size());
+    assets = (const uint8_t *)sd_assets::load(storedPath.c_str(), region.data(), (uint32_t)region.size());
+    remove(storedPath.c_str());
+    bool switched = previous && assets &&
+        memcmp(previous + lazy_assets::ASSETS_PREFIX_SIZE, decompressed.data(), decompressed.size()) == 0 &&
+        memcmp(assets + lazy_assets::ASSETS_PREFIX_SIZE, decompressed.data(), decompressed.size()) == 0;
+    lazy_assets::releaseRetired();
+    lazy_assets::releaseRetired();
+    printf("switched to stored blocks: %s\n", switched ? "identical" : "MISMATCH");
+    if (!assets) {
+        return 1;
+    }
+
+    // corrupted copy must be rejected
+    image[image.size() / 2] ^= 1;
+    std::string corruptedPath = std::string(argv[2]) + ".bad";
+    assets_file::writeFile(corruptedPath.c_str(), image.data(), image.size());
+    bool rejected = sd_assets::load(corruptedPath.c_str(), region.data(), (uint32_t)region.size()) == nullptr;
+    remove(corruptedPath.c_str());
+    bool untouched = memcmp(assets + lazy_assets::ASSETS_PREFIX_SIZE, decompressed.data(), decompressed.size()) == 0;
+    printf("corrupted file: %s, current assets: %s\n", rejected ? "rejected" : "ACCEPTED", untouched ? "untouched" : "DAMAGED");
+
+    return identical && switched && rejected && untouched ? 0 : 1;
+}
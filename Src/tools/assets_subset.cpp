@@ -0,0 +1,408 @@
+// Strips glyphs, styles and fonts that can't be reached from the pages of an
+// EEZ Studio project and reports how much it saves. Run it before the
+// Studio build and build the written project instead of the original one:
+//
+//   assets_subset ../../stm32f469i-disco-eez-flow-demo.eez-project ../../glyph_allowlist.txt
+//       ../../stm32f469i-disco-eez-flow-demo.subset.eez-project
+//
+// Characters are taken from the string literals in the widget properties
+// (text, data, label, options, ... expressions) and go to the font of the
+// widget style. Literals outside of widgets (flow components, variable
+// default values) and enum member names go to every font. Text created at
+// runtime (numbers, user input, framework strings) must be listed in the
+// allowlist:
+//
+//   # comment
+//   <font name or *> <characters or U+XXXX or U+XXXX-U+YYYY> ...
+//
+// Fonts and styles marked "Always build" in Studio are used by the
+// framework and kept with all glyphs. Styles with an id can be referenced
+// from native code as STYLE_ID_*, they are reported but not removed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "assets_file.h"
+#include "json.h"
+
+typedef std::set<uint32_t> CharSet;
+
+struct Style {
+    std::string parent;
+    std::string font;
+    bool alwaysBuild;
+    bool hasId;
+    bool used; // by a widget or page
+    bool kept; // used, always build, has id or parent of such style
+};
+
+static std::map<std::string, Style> g_styles;
+static std::vector<std::string> g_styleOrder;
+
+static std::map<std::string, CharSet> g_fontChars;
+static CharSet g_globalChars;
+static std::set<std::string> g_widgetFonts; // set in the local style of a widget
+
+static void addText(CharSet &chars, const std::string &text) {
+    for (size_t i = 0; i < text.size();) {
+        uint32_t codePoint = json::decodeUtf8(text, i);
+        if (codePoint >= 32) {
+            chars.insert(codePoint);
+        }
+    }
+}
+
+// string literals in expression, e.g. temperature + " oC"
+static void addLiterals(CharSet &chars, const std::string &expression) {
+    for (size_t i = 0; i < expression.size(); i++) {
+        char quote = expression[i];
+        if (quote != '"' && quote != '\'') {
+            continue;
+        }
+        std::string literal;
+        for (i++; i < expression.size() && expression[i] != quote; i++) {
+            if (expression[i] == '\\' && i + 1 < expression.size()) {
+                i++;
+            }
+            literal += expression[i];
+        }
+        addText(chars, literal);
+    }
+}
+
+static void collectStyles(const json::Value &list, const std::string &parent) {
+    for (auto &item : list.items) {
+        auto name = item.get("name")->str();
+        Style style;
+        style.parent = parent;
+        style.font = item.get("font") ? item.get("font")->str() : "";
+        style.alwaysBuild = item.get("alwaysBuild") && item.get("alwaysBuild")->isTrue();
+        style.hasId = item.get("id") != nullptr;
+        style.used = false;
+        style.kept = false;
+        g_styles[name] = style;
+        g_styleOrder.push_back(name);
+
+        if (auto childStyles = item.get("childStyles")) {
+            collectStyles(*childStyles, name);
+        }
+    }
+}
+
+static void keepStyle(const std::string &name) {
+    for (auto it = g_styles.find(name); it != g_styles.end(); it = g_styles.find(it->second.parent)) {
+        it->second.kept = true;
+    }
+}
+
+static void useStyle(const std::string &name) {
+    auto it = g_styles.find(name);
+    if (it != g_styles.end()) {
+        it->second.used = true;
+        keepStyle(name);
+    }
+}
+
+static std::string getFont(const std::string &styleName) {
+    for (auto it = g_styles.find(styleName); it != g_styles.end(); it = g_styles.find(it->second.parent)) {
+        if (!it->second.font.empty()) {
+            return it->second.font;
+        }
+    }
+    return "";
+}
+
+static bool isComponent(const json::Value &value) {
+    return value.isObject() && value.get("type") && value.get("type")->isString();
+}
+
+// string properties of the component, nested components are not included
+static void addComponentTexts(CharSet &chars, const json::Value &value) {
+    for (auto &member : value.members) {
+        auto &child = member.second;
+        if (child.isString()) {
+            addLiterals(chars, child.str());
+            if (member.first == "text" || member.first == "label" || member.first == "title" || member.first == "placeholder") {
+                // static text, or expression, then more than needed is added
+                addText(chars, child.str());
+            }
+        } else if (child.isArray() || child.isObject()) {
+            if (!isComponent(child)) {
+                addComponentTexts(chars, child);
+            }
+        }
+    }
+}
+
+// font of the widget style object (style, disabledStyle, selectedValueStyle, ...)
+static std::string useWidgetStyle(const json::Value &style) {
+    std::string styleName = style.get("useStyle") ? style.get("useStyle")->str() : "";
+    if (styleName.empty()) {
+        styleName = "default";
+    }
+    useStyle(styleName);
+
+    if (style.get("font")) {
+        auto font = style.get("font")->str();
+        g_widgetFonts.insert(font);
+        return font;
+    }
+    return getFont(styleName);
+}
+
+static void walkComponents(const json::Value &value) {
+    if (isComponent(value)) {
+        auto style = value.get("style");
+        if (style && style->isObject()) {
+            // widget, text can be drawn with any of its styles
+            std::set<std::string> fonts;
+            for (auto &member : value.members) {
+                if (member.second.isObject() && member.second.get("useStyle")) {
+                    fonts.insert(useWidgetStyle(member.second));
+                }
+            }
+            for (auto &font : fonts) {
+                addComponentTexts(g_fontChars[font], value);
+            }
+        } else {
+            addComponentTexts(g_globalChars, value);
+        }
+    } else if (value.isObject() && value.get("style") && value.get("style")->isString()) {
+        // page
+        useStyle(value.get("style")->str());
+    }
+
+    for (auto &member : value.members) {
+        if (member.second.isArray() || member.second.isObject()) {
+            walkComponents(member.second);
+        }
+    }
+    for (auto &item : value.items) {
+        walkComponents(item);
+    }
+}
+
+static bool readAllowlist(const char *path) {
+    std::vector<uint8_t> data;
+    if (!assets_file::readFile(path, data)) {
+        return false;
+    }
+    std::string text(data.begin(), data.end());
+
+    size_t lineStart = 0;
+    while (lineStart < text.size()) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string::npos) {
+            lineEnd = text.size();
+        }
+        std::string line = text.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::vector<std::string> tokens;
+        size_t pos = 0;
+        while (pos < line.size()) {
+            size_t end = line.find(' ', pos);
+            if (end == std::string::npos) {
+                end = line.size();
+            }
+            if (end > pos) {
+                tokens.push_back(line.substr(pos, end - pos));
+            }
+            pos = end + 1;
+        }
+
+        CharSet &chars = tokens[0] == "*" ? g_globalChars : g_fontChars[tokens[0]];
+        for (size_t i = 1; i < tokens.size(); i++) {
+            auto &token = tokens[i];
+            if (token.compare(0, 2, "U+") == 0) {
+                uint32_t from = (uint32_t)strtoul(token.c_str() + 2, nullptr, 16);
+                auto dash = token.find("-U+");
+                uint32_t to = dash != std::string::npos ? (uint32_t)strtoul(token.c_str() + dash + 3, nullptr, 16) : from;
+                for (uint32_t codePoint = from; codePoint <= to; codePoint++) {
+                    chars.insert(codePoint);
+                }
+            } else {
+                addText(chars, token);
+            }
+        }
+    }
+
+    return true;
+}
+
+static uint32_t getGlyphSize(const json::Value &glyph, int bpp) {
+    uint32_t width = (uint32_t)atoi(glyph.get("width")->raw.c_str());
+    uint32_t height = (uint32_t)atoi(glyph.get("height")->raw.c_str());
+    uint32_t pixels = bpp == 8 ? width * height : (width + 7) / 8 * height;
+    // GlyphData header and the pointer in the list of glyphs
+    return 8 + pixels + 4;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <project.eez-project> <allowlist.txt> [output.eez-project]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<uint8_t> data;
+    if (!assets_file::readFile(argv[1], data)) {
+        return 1;
+    }
+    std::string text(data.begin(), data.end());
+
+    json::Value project;
+    if (!json::parse(text, project)) {
+        return 1;
+    }
+
+    if (json::write(project) != text) {
+        fprintf(stderr, "project is not in JSON.stringify(project, null, 2) format\n");
+        return 1;
+    }
+
+    collectStyles(*project.get("styles"), "");
+
+    for (const char *key : { "userPages", "userWidgets", "actions" }) {
+        if (auto value = project.get(key)) {
+            walkComponents(*value);
+        }
+    }
+
+    if (auto variables = project.get("variables")) {
+        if (auto globalVariables = variables->get("globalVariables")) {
+            for (auto &variable : globalVariables->items) {
+                if (auto defaultValue = variable.get("defaultValue")) {
+                    addLiterals(g_globalChars, defaultValue->str());
+                }
+            }
+        }
+        if (auto enums = variables->get("enums")) {
+            for (auto &enumDef : enums->items) {
+                if (auto members = enumDef.get("members")) {
+                    for (auto &member : members->items) {
+                        addText(g_globalChars, member.get("name")->str());
+                    }
+                }
+            }
+        }
+    }
+
+    if (!readAllowlist(argv[2])) {
+        return 1;
+    }
+
+    // styles
+
+    for (auto &name : g_styleOrder) {
+        auto &style = g_styles[name];
+        if (style.alwaysBuild || style.hasId) {
+            keepStyle(name);
+        }
+    }
+
+    std::set<std::string> fontsUsed = g_widgetFonts;
+    std::set<std::string> stylesRemoved;
+    uint32_t numStylesKept = 0;
+    for (auto &name : g_styleOrder) {
+        auto &style = g_styles[name];
+        if (style.kept) {
+            numStylesKept++;
+            if (!style.font.empty()) {
+                fontsUsed.insert(style.font);
+            }
+            if (!style.used && !style.alwaysBuild) {
+                printf("style %-40s unused, kept because %s\n", name.c_str(), style.hasId ? "it has id" : "of child styles");
+            }
+        } else {
+            printf("style %-40s unused, removed\n", name.c_str());
+            stylesRemoved.insert(name);
+        }
+    }
+    printf("styles: %u of %u kept\n\n", numStylesKept, (unsigned)g_styleOrder.size());
+
+    // fonts and glyphs
+
+    printf("%-12s %8s %8s %10s %10s\n", "font", "glyphs", "kept", "bytes", "kept");
+
+    uint32_t totalSize = 0;
+    uint32_t totalKeptSize = 0;
+
+    auto fonts = project.get("fonts");
+    std::vector<json::Value> keptFonts;
+    for (auto &font : fonts->items) {
+        auto name = font.get("name")->str();
+        bool alwaysBuild = font.get("alwaysBuild") && font.get("alwaysBuild")->isTrue();
+        int bpp = atoi(font.get("bpp")->raw.c_str());
+        bool isUsed = alwaysBuild || fontsUsed.count(name);
+
+        auto &chars = g_fontChars[name];
+
+        auto glyphs = font.get("glyphs");
+        std::vector<json::Value> keptGlyphs;
+        uint32_t size = 0;
+        uint32_t keptSize = 0;
+        for (auto &glyph : glyphs->items) {
+            uint32_t encoding = (uint32_t)atoi(glyph.get("encoding")->raw.c_str());
+            uint32_t glyphSize = getGlyphSize(glyph, bpp);
+            size += glyphSize;
+            if (isUsed && (alwaysBuild || chars.count(encoding) || g_globalChars.count(encoding))) {
+                keptGlyphs.push_back(glyph);
+                keptSize += glyphSize;
+            }
+        }
+
+        printf("%-12s %8u %8u %10u %10u%s\n", name.c_str(), (unsigned)glyphs->items.size(), (unsigned)keptGlyphs.size(),
+            size, keptSize, isUsed ? (alwaysBuild ? "  always build" : "") : "  unused, removed");
+
+        totalSize += size;
+        totalKeptSize += keptSize;
+
+        if (isUsed) {
+            glyphs->items = keptGlyphs;
+            keptFonts.push_back(font);
+        }
+    }
+    fonts->items = keptFonts;
+
+    printf("%-12s %8s %8s %10u %10u\n\n", "total", "", "", totalSize, totalKeptSize);
+    printf("glyph data: %u bytes less to store and decompress (%.1f%%)\n",
+        totalSize - totalKeptSize, totalSize ? 100.0 * (totalSize - totalKeptSize) / totalSize : 0.0);
+
+    if (argc < 4) {
+        return 0;
+    }
+
+    // removed style has no kept child styles
+    std::vector<json::Value *> lists = { project.get("styles") };
+    for (size_t i = 0; i < lists.size(); i++) {
+        auto &items = lists[i]->items;
+        std::vector<json::Value> kept;
+        for (auto &item : items) {
+            if (!stylesRemoved.count(item.get("name")->str())) {
+                kept.push_back(item);
+            }
+        }
+        items = kept;
+        for (auto &item : items) {
+            if (auto childStyles = item.get("childStyles")) {
+                lists.push_back(childStyles);
+            }
+        }
+    }
+
+    std::string out = json::write(project);
+    return assets_file::writeFile(argv[3], out.data(), out.size()) ? 0 : 1;
+}
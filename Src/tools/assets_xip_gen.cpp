@@ -0,0 +1,99 @@
+// Generates gui/document_xip.cpp with uncompressed execute-in-place assets
+// image (see gui/assets_xip.h) from the compressed assets[] arrays in
+// gui/document.cpp. Run it after EEZ Studio build when OPTION_ASSETS_XIP is
+// enabled:
+//
+//   assets_xip_gen ../../gui/document.cpp ../../gui/document_xip.cpp
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "assets_file.h"
+#include "gui/assets_xip.h"
+
+using namespace eez::gui;
+
+static bool buildImage(const char *documentPath, assets_file::Platform platform, std::vector<uint8_t> &image, size_t &compressedSize) {
+    std::vector<uint8_t> compressed;
+    if (!assets_file::readDocument(documentPath, platform, compressed)) {
+        return false;
+    }
+    compressedSize = compressed.size();
+
+    assets_file::Header header;
+    std::vector<uint8_t> decompressed;
+    if (!assets_file::decompress(compressed, header, decompressed)) {
+        return false;
+    }
+
+    assets_xip::Header xipHeader;
+    xipHeader.tag = assets_xip::HEADER_TAG;
+    xipHeader.projectMajorVersion = header.projectMajorVersion;
+    xipHeader.projectMinorVersion = header.projectMinorVersion;
+    xipHeader.assetsSize = assets_xip::ASSETS_PREFIX_SIZE + (uint32_t)decompressed.size();
+    xipHeader.reserved = 0;
+
+    // Assets: projectMajorVersion (u8), projectMinorVersion (u8),
+    // reserved[2], external (u32), then settings ...
+    uint8_t prefix[assets_xip::ASSETS_PREFIX_SIZE] = {
+        (uint8_t)header.projectMajorVersion,
+        (uint8_t)header.projectMinorVersion
+    };
+
+    image.resize(sizeof(xipHeader));
+    memcpy(image.data(), &xipHeader, sizeof(xipHeader));
+    image.insert(image.end(), prefix, prefix + sizeof(prefix));
+    image.insert(image.end(), decompressed.begin(), decompressed.end());
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <document.cpp> <document_xip.cpp>\n", argv[0]);
+        return 1;
+    }
+
+    std::string out;
+    out += "// Generated by Src/tools/assets_xip_gen from document.cpp, do not edit.\n\n";
+    out += "#include <stdint.h>\n\n";
+    out += "#include \"eez-framework-conf.h\"\n\n";
+    out += "#if OPTION_ASSETS_XIP\n\n";
+    out += "namespace eez {\nnamespace gui {\n\n";
+
+    assets_file::Platform platforms[] = { assets_file::PLATFORM_STM32, assets_file::PLATFORM_SIMULATOR };
+    for (int i = 0; i < 2; i++) {
+        std::vector<uint8_t> image;
+        size_t compressedSize;
+        if (!buildImage(argv[1], platforms[i], image, compressedSize)) {
+            return 1;
+        }
+
+        printf("%-10s compressed: %7u, XIP image: %8u bytes\n",
+            assets_file::getPlatformName(platforms[i]), (unsigned)compressedSize, (unsigned)image.size());
+
+        char line[128];
+        out += i == 0 ? "#if defined(EEZ_PLATFORM_STM32)\n\n" : "#elif defined(EEZ_PLATFORM_SIMULATOR)\n\n";
+        snprintf(line, sizeof(line), "extern const uint8_t xip_assets[%u];\n\n", (unsigned)image.size());
+        out += line;
+        if (platforms[i] == assets_file::PLATFORM_STM32) {
+            out += "// memory-mapped QSPI flash\n";
+            out += "__attribute__((section(\".qspi_assets\"), aligned(4)))\n";
+        } else {
+            out += "alignas(4)\n";
+        }
+        snprintf(line, sizeof(line), "const uint8_t xip_assets[%u] = {\n", (unsigned)image.size());
+        out += line;
+        assets_file::writeArray(out, image.data(), image.size());
+        out += "};\n\n";
+    }
+
+    out += "#endif\n\n";
+    out += "} // namespace gui\n} // namespace eez\n\n";
+    out += "#endif // OPTION_ASSETS_XIP\n";
+
+    return assets_file::writeFile(argv[2], out.data(), out.size()) ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+#include <string.h>
+
+#include "gui/bitmap_format.h"
+#include "gui/pixel_format.h"
+
+#include "bitmap_convert.h"
+
+using namespace eez::gui;
+
+namespace bitmap_convert {
+
+static uint16_t getColor(const Source &source, int i) {
+    if (source.bpp == 16) {
+        return (uint16_t)(source.pixels[2 * i] | (source.pixels[2 * i + 1] << 8));
+    }
+    auto p = source.pixels + 4 * i;
+    return pixel_format::Rgb565::fromArgb8888(p[0] | (p[1] << 8) | (p[2] << 16));
+}
+
+static uint8_t getAlpha(const Source &source, int i) {
+    return source.bpp == 16 ? 255 : source.pixels[4 * i + 3];
+}
+
+bool isOpaque(const Source &source) {
+    for (int i = 0; i < source.width * source.height; i++) {
+        if (getAlpha(source, i) != 255) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void append16(std::vector<uint8_t> &out, uint16_t value) {
+    out.push_back((uint8_t)value);
+    out.push_back((uint8_t)(value >> 8));
+}
+
+static void encodeRle(const Source &source, std::vector<uint8_t> &out) {
+    uint32_t tableSize = 4 * (source.height + 1);
+    out.assign(tableSize, 0);
+
+    for (int y = 0; y < source.height; y++) {
+        uint32_t offset = (uint32_t)out.size();
+        memcpy(out.data() + 4 * y, &offset, 4);
+
+        int row = y * source.width;
+        int x = 0;
+        while (x < source.width) {
+            // run of at least 3 same pixels, shorter ones are cheaper as literals
+            uint16_t color = getColor(source, row + x);
+            int run = 1;
+            while (x + run < source.width && run < bitmap_format::RLE_MAX_COUNT && getColor(source, row + x + run) == color) {
+                run++;
+            }
+            if (run >= 3) {
+                append16(out, (uint16_t)(bitmap_format::RLE_RUN | (run - 1)));
+                append16(out, color);
+                x += run;
+                continue;
+            }
+
+            int count = 0;
+            while (x + count < source.width && count < bitmap_format::RLE_MAX_COUNT) {
+                int same = 1;
+                uint16_t next = getColor(source, row + x + count);
+                while (same < 3 && x + count + same < source.width && getColor(source, row + x + count + same) == next) {
+                    same++;
+                }
+                if (same >= 3) {
+                    break;
+                }
+                count++;
+            }
+            append16(out, (uint16_t)(count - 1));
+            for (int i = 0; i < count; i++) {
+                append16(out, getColor(source, row + x + i));
+            }
+            x += count;
+        }
+    }
+
+    uint32_t end = (uint32_t)out.size();
+    memcpy(out.data() + 4 * source.height, &end, 4);
+}
+
+void encode(const Source &source, int bpp, std::vector<uint8_t> &out) {
+    int n = source.width * source.height;
+    out.clear();
+
+    if (bpp == bitmap_format::BPP_RLE_RGB565) {
+        encodeRle(source, out);
+    } else if (bpp == bitmap_format::BPP_ARGB8888) {
+        for (int i = 0; i < n; i++) {
+            uint32_t argb = pixel_format::Rgb565::toArgb8888(getColor(source, i));
+            if (source.bpp == 32) {
+                auto p = source.pixels + 4 * i;
+                argb = p[0] | (p[1] << 8) | (p[2] << 16);
+            }
+            out.push_back((uint8_t)argb);
+            out.push_back((uint8_t)(argb >> 8));
+            out.push_back((uint8_t)(argb >> 16));
+            out.push_back(getAlpha(source, i));
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            append16(out, getColor(source, i));
+        }
+        if (bpp == bitmap_format::BPP_RGB565_A8) {
+            for (int i = 0; i < n; i++) {
+                out.push_back(getAlpha(source, i));
+            }
+        }
+    }
+}
+
+int selectFormat(const Source &source) {
+    if (!isOpaque(source)) {
+        return bitmap_format::BPP_RGB565_A8;
+    }
+
+    std::vector<uint8_t> rle;
+    encodeRle(source, rle);
+    if (rle.size() * 2 <= (size_t)source.width * source.height * 2) {
+        return bitmap_format::BPP_RLE_RGB565;
+    }
+
+    return bitmap_format::BPP_RGB565;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t u32(const std::vector<uint8_t> &data, uint32_t offset) {
+    uint32_t value;
+    memcpy(&value, data.data() + offset, 4);
+    return value;
+}
+
+static uint32_t ptr(const std::vector<uint8_t> &data, uint32_t offset) {
+    uint32_t value = u32(data, offset);
+    return value ? offset + value : 0;
+}
+
+void convertBitmaps(std::vector<uint8_t> &data, std::vector<BitmapInfo> &bitmaps) {
+    // bitmaps list at +28 of the assets root, { count, pointer to array of
+    // pointers }; Bitmap: w, h, bpp, reserved (uint16_t), pixels
+    uint32_t numBitmaps = u32(data, 28);
+    uint32_t array = ptr(data, 32);
+
+    for (uint32_t i = 0; i < numBitmaps; i++) {
+        uint32_t bitmap = ptr(data, array + 4 * i);
+
+        Source source;
+        source.width = data[bitmap] | (data[bitmap + 1] << 8);
+        source.height = data[bitmap + 2] | (data[bitmap + 3] << 8);
+        source.bpp = data[bitmap + 4] | (data[bitmap + 5] << 8);
+        source.pixels = data.data() + bitmap + 8;
+
+        BitmapInfo info;
+        info.width = source.width;
+        info.height = source.height;
+        info.oldBpp = source.bpp;
+        info.oldSize = source.width * source.height * source.bpp / 8;
+
+        if (source.bpp != 16 && source.bpp != 32) {
+            // already converted
+            info.newBpp = info.oldBpp;
+            info.newSize = info.oldSize;
+            bitmaps.push_back(info);
+            continue;
+        }
+
+        int bpp = selectFormat(source);
+        std::vector<uint8_t> pixels;
+        encode(source, bpp, pixels);
+        if (pixels.size() > info.oldSize) {
+            bpp = source.bpp;
+            pixels.assign(source.pixels, source.pixels + info.oldSize);
+        }
+
+        memset(data.data() + bitmap + 8, 0, info.oldSize);
+        memcpy(data.data() + bitmap + 8, pixels.data(), pixels.size());
+        data[bitmap + 4] = (uint8_t)bpp;
+        data[bitmap + 5] = (uint8_t)(bpp >> 8);
+
+        info.newBpp = bpp;
+        info.newSize = (uint32_t)pixels.size();
+        bitmaps.push_back(info);
+    }
+}
+
+} // namespace bitmap_convert
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+// Host side encoders for the bitmap formats in gui/bitmap_format.h.
+
+namespace bitmap_convert {
+
+// Source pixels are RGB565 (bpp 16) or B, G, R, A bytes (bpp 32) as
+// written by EEZ Studio.
+struct Source {
+    int width;
+    int height;
+    int bpp;
+    const uint8_t *pixels;
+};
+
+bool isOpaque(const Source &source);
+
+// bpp is one of bitmap_format::BPP_...
+void encode(const Source &source, int bpp, std::vector<uint8_t> &pixels);
+
+// Format for the RGB565 frame buffer: RLE if it is at most half of RGB565,
+// otherwise RGB565 for opaque bitmaps and RGB565_A8 for bitmaps with alpha.
+int selectFormat(const Source &source);
+
+struct BitmapInfo {
+    int width;
+    int height;
+    int oldBpp;
+    int newBpp;
+    uint32_t oldSize;
+    uint32_t newSize;
+};
+
+// Converts all bitmaps in decompressed assets in place with selectFormat().
+// Pixels never grow (format is kept otherwise), the rest of the old pixel
+// data is zeroed, so nothing else in assets moves.
+void convertBitmaps(std::vector<uint8_t> &decompressed, std::vector<BitmapInfo> &bitmaps);
+
+} // namespace bitmap_convert
@@ -0,0 +1,203 @@
+// Draw time and size of each bitmap format in gui/bitmap_format.h when
+// drawn to the RGB565 frame buffer, for the bitmaps in gui/document.cpp and
+// for two synthetic ones (icon with alpha, flat panel):
+//
+//   bitmap_format_bench ../../gui/document.cpp [simulator|stm32] [iterations]
+//
+// Output of every format is compared with ARGB8888 drawn by blitBlend, also
+// with the bitmap partially clipped on every side.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "eez-framework-conf.h"
+#include "gui/bitmap_format.h"
+
+#include "assets_file.h"
+#include "bitmap_convert.h"
+
+using namespace eez::gui;
+
+static const int WIDTH = 800;
+static const int HEIGHT = 480;
+
+struct TestBitmap {
+    std::string name;
+    int width;
+    int height;
+    std::vector<uint8_t> argb; // B, G, R, A
+};
+
+static const char *getFormatName(int bpp) {
+    switch (bpp) {
+    case bitmap_format::BPP_RGB565: return "RGB565";
+    case bitmap_format::BPP_RGB565_A8: return "RGB565_A8";
+    case bitmap_format::BPP_ARGB8888: return "ARGB8888";
+    case bitmap_format::BPP_RLE_RGB565: return "RLE_RGB565";
+    }
+    return "?";
+}
+
+static void readAssetBitmaps(const std::vector<uint8_t> &data, std::vector<TestBitmap> &bitmaps) {
+    uint32_t numBitmaps, arrayPtr;
+    memcpy(&numBitmaps, data.data() + 28, 4);
+    memcpy(&arrayPtr, data.data() + 32, 4);
+    for (uint32_t i = 0; i < numBitmaps; i++) {
+        uint32_t bitmapPtr;
+        memcpy(&bitmapPtr, data.data() + 32 + arrayPtr + 4 * i, 4);
+        uint32_t bitmap = 32 + arrayPtr + 4 * i + bitmapPtr;
+
+        bitmap_convert::Source source;
+        source.width = data[bitmap] | (data[bitmap + 1] << 8);
+        source.height = data[bitmap + 2] | (data[bitmap + 3] << 8);
+        source.bpp = data[bitmap + 4] | (data[bitmap + 5] << 8);
+        source.pixels = data.data() + bitmap + 8;
+
+        TestBitmap test;
+        test.name = "bitmap " + std::to_string(i + 1);
+        test.width = source.width;
+        test.height = source.height;
+        bitmap_convert::encode(source, bitmap_format::BPP_ARGB8888, test.argb);
+        bitmaps.push_back(test);
+    }
+}
+
+static void addSyntheticBitmaps(std::vector<TestBitmap> &bitmaps) {
+    // anti-aliased disc with gradient, transparent outside
+    TestBitmap icon{ "icon 64x64, alpha", 64, 64, {} };
+    for (int y = 0; y < icon.height; y++) {
+        for (int x = 0; x < icon.width; x++) {
+            float d = sqrtf((x - 31.5f) * (x - 31.5f) + (y - 31.5f) * (y - 31.5f));
+            float coverage = d < 29.5f ? 1.0f : d > 30.5f ? 0.0f : 30.5f - d;
+            icon.argb.push_back((uint8_t)(4 * x));
+            icon.argb.push_back((uint8_t)(4 * y));
+            icon.argb.push_back(200);
+            icon.argb.push_back((uint8_t)(coverage * 255 + 0.5f));
+        }
+    }
+    bitmaps.push_back(icon);
+
+    // panel background: flat areas, frame and a few labels worth of noise
+    TestBitmap panel{ "panel 400x240, flat", 400, 240, {} };
+    srand(1);
+    for (int y = 0; y < panel.height; y++) {
+        for (int x = 0; x < panel.width; x++) {
+            uint32_t color = 0x303840;
+            if (x < 4 || y < 4 || x >= panel.width - 4 || y >= panel.height - 4) {
+                color = 0xA0A0A0;
+            } else if (y >= 20 && y < 60 && x >= 20 && x < 380) {
+                color = 0x1060C0;
+            } else if (y >= 100 && y < 116 && x >= 30 && x < 200 && rand() % 3 == 0) {
+                color = 0xFFFFFF;
+            }
+            panel.argb.push_back((uint8_t)color);
+            panel.argb.push_back((uint8_t)(color >> 8));
+            panel.argb.push_back((uint8_t)(color >> 16));
+            panel.argb.push_back(255);
+        }
+    }
+    bitmaps.push_back(panel);
+}
+
+static void draw(std::vector<uint16_t> &buffer, int bpp, const TestBitmap &bitmap, const uint8_t *pixels, int x, int y) {
+    bitmap_format::Rect clip = { 0, 0, WIDTH - 1, HEIGHT - 1 };
+    bitmap_format::drawBitmap<pixel_format::Rgb565>(buffer.data(), WIDTH, clip,
+        bpp, bitmap.width, bitmap.height, 0, pixels, x, y);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <document.cpp> [simulator|stm32] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    auto platform = argc > 2 && strcmp(argv[2], "stm32") == 0 ? assets_file::PLATFORM_STM32 : assets_file::PLATFORM_SIMULATOR;
+    int iterations = argc > 3 ? atoi(argv[3]) : 20;
+
+    std::vector<uint8_t> compressed;
+    if (!assets_file::readDocument(argv[1], platform, compressed)) {
+        return 1;
+    }
+    assets_file::Header header;
+    std::vector<uint8_t> decompressed;
+    if (!assets_file::decompress(compressed, header, decompressed)) {
+        return 1;
+    }
+
+    std::vector<TestBitmap> bitmaps;
+    readAssetBitmaps(decompressed, bitmaps);
+    addSyntheticBitmaps(bitmaps);
+
+    // background pattern, so blending errors show up
+    std::vector<uint16_t> background(WIDTH * HEIGHT);
+    for (int i = 0; i < WIDTH * HEIGHT; i++) {
+        background[i] = (uint16_t)(i * 2654435761u >> 16);
+    }
+
+    int formats[] = { bitmap_format::BPP_ARGB8888, bitmap_format::BPP_RGB565, bitmap_format::BPP_RGB565_A8, bitmap_format::BPP_RLE_RGB565 };
+
+    // top-left, partially clipped on each side, centered
+    struct Position { int x; int y; };
+
+    bool ok = true;
+
+    printf("%-20s %-11s %10s %10s %10s\n", "bitmap", "format", "bytes", "us/draw", "Mpx/s");
+    for (auto &bitmap : bitmaps) {
+        bitmap_convert::Source source = { bitmap.width, bitmap.height, 32, bitmap.argb.data() };
+        bool opaque = bitmap_convert::isOpaque(source);
+        int selected = bitmap_convert::selectFormat(source);
+
+        Position positions[] = {
+            { 0, 0 },
+            { -bitmap.width / 3, -bitmap.height / 4 },
+            { WIDTH - bitmap.width * 2 / 3, HEIGHT - bitmap.height / 2 },
+            { (WIDTH - bitmap.width) / 2, (HEIGHT - bitmap.height) / 2 }
+        };
+
+        std::vector<std::vector<uint16_t>> references;
+        for (auto &position : positions) {
+            std::vector<uint16_t> reference = background;
+            draw(reference, bitmap_format::BPP_ARGB8888, bitmap, bitmap.argb.data(), position.x, position.y);
+            references.push_back(reference);
+        }
+
+        for (int bpp : formats) {
+            if (!opaque && (bpp == bitmap_format::BPP_RGB565 || bpp == bitmap_format::BPP_RLE_RGB565)) {
+                // no alpha in these formats
+                continue;
+            }
+
+            std::vector<uint8_t> pixels;
+            bitmap_convert::encode(source, bpp, pixels);
+
+            bool identical = true;
+            std::vector<uint16_t> buffer;
+            for (size_t i = 0; i < references.size(); i++) {
+                buffer = background;
+                draw(buffer, bpp, bitmap, pixels.data(), positions[i].x, positions[i].y);
+                identical = identical && buffer == references[i];
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++) {
+                draw(buffer, bpp, bitmap, pixels.data(), positions[3].x, positions[3].y);
+            }
+            double time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+
+            int drawnWidth = bitmap.width < WIDTH ? bitmap.width : WIDTH;
+            int drawnHeight = bitmap.height < HEIGHT ? bitmap.height : HEIGHT;
+            printf("%-20s %-11s %10u %10.1f %10.1f%s%s\n", bitmap.name.c_str(), getFormatName(bpp), (unsigned)pixels.size(),
+                time, drawnWidth * drawnHeight / time, bpp == selected ? "  (selected)" : "", identical ? "" : "  DIFFERENT");
+            ok = ok && identical;
+        }
+    }
+
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
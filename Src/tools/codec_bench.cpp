@@ -0,0 +1,118 @@
+// Reports compression ratio and decompression speed of the asset codecs
+// (gui/assets_codec.h) on the real demo assets from gui/document.cpp, for
+// the whole blob and for the blocks of the block compressed assets.
+//
+//   codec_bench ../../gui/document.cpp [blockSize]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "assets_compress.h"
+#include "assets_file.h"
+#include "gui/assets_codec.h"
+
+using namespace eez::gui;
+
+static const double MIN_MEASURE_TIME = 0.2; // seconds
+
+// Returns decompression speed in MB/s of decompressed data, or 0 if output
+// doesn't match.
+template <typename Func>
+static double measure(const std::vector<uint8_t> &expected, Func decompress) {
+    std::vector<uint8_t> output(expected.size());
+
+    if (!decompress(output.data()) || output != expected) {
+        return 0;
+    }
+
+    int numIterations = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    double seconds;
+    do {
+        decompress(output.data());
+        numIterations++;
+        seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    } while (seconds < MIN_MEASURE_TIME);
+
+    return expected.size() * (double)numIterations / seconds / 1e6;
+}
+
+static void printRow(const char *name, size_t compressedSize, size_t decompressedSize, double speed, bool &ok) {
+    if (speed == 0) {
+        printf("  %-26s %9u  MISMATCH\n", name, (unsigned)compressedSize);
+        ok = false;
+        return;
+    }
+    printf("  %-26s %9u %7.2f %10.1f\n", name, (unsigned)compressedSize, (double)decompressedSize / compressedSize, speed);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <document.cpp> [blockSize]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t blockSize = argc > 2 ? (uint32_t)atoi(argv[2]) : 8192;
+    bool ok = true;
+
+    assets_file::Platform platforms[] = { assets_file::PLATFORM_STM32, assets_file::PLATFORM_SIMULATOR };
+    for (auto platform : platforms) {
+        std::vector<uint8_t> studio;
+        assets_file::Header header;
+        std::vector<uint8_t> decompressed;
+        if (!assets_file::readDocument(argv[1], platform, studio) || !assets_file::decompress(studio, header, decompressed)) {
+            return 1;
+        }
+
+        printf("%s, %u bytes decompressed\n", assets_file::getPlatformName(platform), (unsigned)decompressed.size());
+        printf("  %-26s %9s %7s %10s\n", "", "size", "ratio", "MB/s");
+
+        // current assets from EEZ Studio
+        const uint8_t *studioData = studio.data() + sizeof(header);
+        int studioSize = (int)(studio.size() - sizeof(header));
+        int decompressedSize = (int)decompressed.size();
+        printRow("studio lz4, reference", studioSize, decompressed.size(), measure(decompressed, [&](uint8_t *dst) {
+            return assets_codec::lz4Decompress(studioData, studioSize, dst, decompressedSize) == decompressedSize;
+        }), ok);
+        printRow("studio lz4, fast decoder", studioSize, decompressed.size(), measure(decompressed, [&](uint8_t *dst) {
+            return assets_codec::lz4DecompressFast(studioData, studioSize, dst, decompressedSize) == decompressedSize;
+        }), ok);
+
+        for (int codec = 0; codec < assets_codec::NUM_CODECS; codec++) {
+            char name[64];
+
+            std::vector<uint8_t> compressed;
+            assets_compress::compress(codec, decompressed.data(), decompressedSize, compressed);
+            snprintf(name, sizeof(name), "%s, whole blob", assets_codec::getCodecName(codec));
+            printRow(name, compressed.size(), decompressed.size(), measure(decompressed, [&](uint8_t *dst) {
+                return assets_codec::decompress(codec, compressed.data(), (int)compressed.size(), dst, decompressedSize);
+            }), ok);
+
+            std::vector<std::vector<uint8_t>> blocks;
+            size_t blocksSize = 0;
+            for (uint32_t offset = 0; offset < decompressed.size(); offset += blockSize) {
+                int size = decompressedSize - (int)offset < (int)blockSize ? decompressedSize - (int)offset : (int)blockSize;
+                blocks.emplace_back();
+                assets_compress::compress(codec, decompressed.data() + offset, size, blocks.back());
+                blocksSize += blocks.back().size();
+            }
+            snprintf(name, sizeof(name), "%s, %u byte blocks", assets_codec::getCodecName(codec), blockSize);
+            printRow(name, blocksSize, decompressed.size(), measure(decompressed, [&](uint8_t *dst) {
+                for (size_t i = 0; i < blocks.size(); i++) {
+                    uint32_t offset = (uint32_t)i * blockSize;
+                    int size = decompressedSize - (int)offset < (int)blockSize ? decompressedSize - (int)offset : (int)blockSize;
+                    if (!assets_codec::decompress(codec, blocks[i].data(), (int)blocks[i].size(), dst + offset, size)) {
+                        return false;
+                    }
+                }
+                return true;
+            }), ok);
+        }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,354 @@
+// Per-frame data evaluation cost of the main page in gui/document.cpp:
+// polling every bound widget, checking gui/data_versions.h first, and
+// evaluating each distinct data once per frame as gui/data_batch.cpp:
+//
+//   data_binding_bench ../../gui/document.cpp [stm32|simulator] [frames]
+//
+// Bound widgets (data != 0) are counted on the main page in the assets.
+// Their data functions are modeled on gui/data.cpp: each one builds a
+// 16-byte Value, as eez::gui::Value, from date, time or temperature, and
+// the widget is redrawn when it differs from the previous one. Widgets are
+// assigned to the data functions round-robin, the framework isn't linked.
+// Polled and versioned widgets call the data function through a table
+// with their own WidgetCursor, as g_dataOperationsFunctions[]. All ways
+// must redraw the same widgets in the same frames.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "gui/data_versions.h"
+
+#include "assets_file.h"
+
+using namespace eez::gui;
+
+static std::vector<uint8_t> g_data;
+
+static uint32_t u32(uint32_t offset) {
+    uint32_t value;
+    memcpy(&value, g_data.data() + offset, 4);
+    return value;
+}
+
+static int16_t s16(uint32_t offset) {
+    int16_t value;
+    memcpy(&value, g_data.data() + offset, 2);
+    return value;
+}
+
+static uint32_t ptr(uint32_t offset) {
+    uint32_t value = u32(offset);
+    return value ? offset + value : 0;
+}
+
+static uint32_t listItem(uint32_t offset, uint32_t index) {
+    return ptr(ptr(offset + 4) + 4 * index);
+}
+
+// Widget: type, data, visible, action, ...; container widgets list at +28
+static void countBoundWidgets(uint32_t widget, uint32_t &numWidgets, uint32_t &numBound) {
+    numWidgets++;
+    if (s16(widget + 2) != 0) {
+        numBound++;
+    }
+    if (s16(widget) == 1) {
+        for (uint32_t i = 0; i < u32(widget + 28); i++) {
+            countBoundWidgets(listItem(widget + 28, i), numWidgets, numBound);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct Value {
+    uint8_t type;
+    uint8_t unit;
+    uint16_t options;
+    uint32_t reserved;
+    union {
+        int32_t int32Value;
+        float floatValue;
+        double doubleValue;
+    };
+
+    bool operator!=(const Value &other) const {
+        return type != other.type || unit != other.unit || memcmp(&doubleValue, &other.doubleValue, 8) != 0;
+    }
+};
+
+static const uint8_t VALUE_TYPE_INT32 = 5;
+static const uint8_t VALUE_TYPE_FLOAT = 9;
+
+struct DateTime {
+    uint8_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+    uint8_t subSecond;
+};
+
+static DateTime g_dateTime;
+static float g_temperature;
+
+static Value makeInt(int32_t value) {
+    Value result;
+    memset(&result, 0, sizeof(result));
+    result.type = VALUE_TYPE_INT32;
+    result.int32Value = value;
+    return result;
+}
+
+// as eez::gui::WidgetCursor: app context, widget, flow state, iterators,
+// position
+struct WidgetCursor {
+    const void *appContext;
+    const void *widget;
+    const void *flowState;
+    int32_t iterators[4];
+    int16_t x;
+    int16_t y;
+    bool hasPreviousState;
+};
+
+typedef void (*DataFunc)(int operation, const WidgetCursor &widgetCursor, Value &value);
+
+static const int DATA_OPERATION_GET = 0;
+
+static void data_date_year(int, const WidgetCursor &, Value &value) { value = makeInt(g_dateTime.year + 2000); }
+static void data_date_month(int, const WidgetCursor &, Value &value) { value = makeInt(g_dateTime.month); }
+static void data_date_day(int, const WidgetCursor &, Value &value) { value = makeInt(g_dateTime.day); }
+static void data_time_hour(int, const WidgetCursor &, Value &value) { value = makeInt(g_dateTime.hour); }
+static void data_time_minute(int, const WidgetCursor &, Value &value) { value = makeInt(g_dateTime.minute); }
+static void data_time_second(int, const WidgetCursor &, Value &value) { value = makeInt(g_dateTime.second); }
+static void data_time_sub_second(int, const WidgetCursor &, Value &value) { value = makeInt(g_dateTime.subSecond); }
+
+static void data_temperature(int, const WidgetCursor &, Value &value) {
+    memset(&value, 0, sizeof(value));
+    value.type = VALUE_TYPE_FLOAT;
+    value.floatValue = g_temperature;
+}
+
+struct DataSource {
+    DataFunc func;
+    data_versions::VersionId versionId;
+};
+
+static const DataSource DATA_SOURCES[] = {
+    { data_temperature, data_versions::VERSION_TEMPERATURE },
+    { data_time_hour, data_versions::VERSION_TIME },
+    { data_time_minute, data_versions::VERSION_TIME },
+    { data_time_second, data_versions::VERSION_TIME },
+    { data_time_sub_second, data_versions::VERSION_SUB_SECOND },
+    { data_date_year, data_versions::VERSION_DATE },
+    { data_date_month, data_versions::VERSION_DATE },
+    { data_date_day, data_versions::VERSION_DATE },
+};
+static const uint32_t NUM_DATA_SOURCES = sizeof(DATA_SOURCES) / sizeof(DATA_SOURCES[0]);
+
+// Producers as date_time::tick() and temperature reading in tasks.cpp at
+// 60 frames per second: time changes every second, sub second every frame
+// when sub second widgets are present, temperature is read every second
+// and rounded, so it rarely changes.
+static void produce(uint32_t frame, bool subSecond) {
+    uint32_t seconds = 23 * 3600 + 59 * 60 + 30 + frame / 60;
+    DateTime dateTime = g_dateTime;
+    dateTime.year = (uint8_t)(24 + seconds / 86400 / 365);
+    dateTime.month = (uint8_t)(1 + seconds / 86400 / 31 % 12);
+    dateTime.day = (uint8_t)(1 + seconds / 86400 % 31);
+    dateTime.hour = (uint8_t)(seconds / 3600 % 24);
+    dateTime.minute = (uint8_t)(seconds / 60 % 60);
+    dateTime.second = (uint8_t)(seconds % 60);
+    dateTime.subSecond = subSecond ? (uint8_t)(frame % 60 * 255 / 59) : 0;
+
+    if (dateTime.year != g_dateTime.year || dateTime.month != g_dateTime.month || dateTime.day != g_dateTime.day) {
+        g_dateTime.year = dateTime.year;
+        g_dateTime.month = dateTime.month;
+        g_dateTime.day = dateTime.day;
+        data_versions::bumpVersion(data_versions::VERSION_DATE);
+    }
+    if (dateTime.hour != g_dateTime.hour || dateTime.minute != g_dateTime.minute || dateTime.second != g_dateTime.second) {
+        g_dateTime.hour = dateTime.hour;
+        g_dateTime.minute = dateTime.minute;
+        g_dateTime.second = dateTime.second;
+        data_versions::bumpVersion(data_versions::VERSION_TIME);
+    }
+    data_versions::set(data_versions::VERSION_SUB_SECOND, g_dateTime.subSecond, dateTime.subSecond);
+
+    if (frame % 60 == 0) {
+        float temperature = 24.0f + 0.6f * sinf(frame / 3600.0f);
+        data_versions::set(data_versions::VERSION_TEMPERATURE, g_temperature, roundf(temperature));
+    }
+}
+
+struct Result {
+    double time; // us, producers and evaluation in all frames
+    uint32_t evaluations;
+    uint32_t redraws;
+    uint32_t redrawHash;
+};
+
+enum Mode {
+    MODE_POLLED,
+    MODE_VERSIONED,
+    MODE_BATCHED
+};
+
+// Last seen version of one bound value, kept per widget.
+struct Binding {
+    uint32_t seenVersion; // version + 1, so a zeroed Binding reports a change
+
+    bool hasChanged(data_versions::VersionId versionId) {
+        uint32_t version = data_versions::getVersion(versionId) + 1;
+        if (version == seenVersion) {
+            return false;
+        }
+        seenVersion = version;
+        return true;
+    }
+};
+
+static void run(uint32_t numBound, uint32_t numFrames, bool subSecond, Mode mode, Result &result) {
+    memset(&g_dateTime, 0, sizeof(g_dateTime));
+    g_temperature = 0;
+    for (int i = 0; i < data_versions::NUM_VERSIONS; i++) {
+        data_versions::g_versions[i] = 0;
+    }
+
+    std::vector<Value> previous(numBound);
+    std::vector<Binding> bindings(numBound);
+    std::vector<bool> drawn(numBound, false);
+
+    // batch: distinct data collected once, values side by side
+    std::vector<uint8_t> slots(numBound);
+    std::vector<uint8_t> batchSources;
+    for (uint32_t i = 0; i < numBound; i++) {
+        uint8_t source = (uint8_t)(i % NUM_DATA_SOURCES);
+        auto it = std::find(batchSources.begin(), batchSources.end(), source);
+        slots[i] = (uint8_t)(it - batchSources.begin());
+        if (it == batchSources.end()) {
+            batchSources.push_back(source);
+        }
+    }
+    std::vector<Value> batchValues(batchSources.size());
+    std::vector<Binding> batchBindings(batchSources.size());
+    std::vector<uint8_t> batchChanged(batchSources.size());
+
+    result.evaluations = 0;
+    result.redraws = 0;
+    result.redrawHash = 2166136261u;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < numFrames; frame++) {
+        produce(frame, subSecond);
+
+        if (mode == MODE_BATCHED) {
+            WidgetCursor widgetCursor;
+            memset(&widgetCursor, 0, sizeof(widgetCursor));
+            for (size_t slot = 0; slot < batchSources.size(); slot++) {
+                auto &source = DATA_SOURCES[batchSources[slot]];
+                batchChanged[slot] = batchBindings[slot].hasChanged(source.versionId);
+                if (batchChanged[slot]) {
+                    source.func(DATA_OPERATION_GET, widgetCursor, batchValues[slot]);
+                    result.evaluations++;
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < numBound; i++) {
+            Value value;
+            if (mode == MODE_BATCHED) {
+                // data_batch::hasChanged(), then data_batch::get()
+                if (!batchChanged[slots[i]]) {
+                    continue;
+                }
+                value = batchValues[slots[i]];
+            } else {
+                auto &source = DATA_SOURCES[i % NUM_DATA_SOURCES];
+                if (mode == MODE_VERSIONED && !bindings[i].hasChanged(source.versionId)) {
+                    continue;
+                }
+
+                WidgetCursor widgetCursor;
+                memset(&widgetCursor, 0, sizeof(widgetCursor));
+                widgetCursor.widget = &previous[i];
+                widgetCursor.x = (int16_t)i;
+                source.func(DATA_OPERATION_GET, widgetCursor, value);
+                result.evaluations++;
+            }
+
+            if (!drawn[i] || value != previous[i]) {
+                drawn[i] = true;
+                previous[i] = value;
+                result.redraws++;
+                result.redrawHash = (result.redrawHash ^ (frame * 31 + i)) * 16777619u;
+            }
+        }
+    }
+    result.time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <document.cpp> [stm32|simulator] [frames]\n", argv[0]);
+        return 1;
+    }
+
+    auto platform = argc > 2 && strcmp(argv[2], "simulator") == 0 ? assets_file::PLATFORM_SIMULATOR : assets_file::PLATFORM_STM32;
+    uint32_t numFrames = argc > 3 ? (uint32_t)atoi(argv[3]) : 36000;
+
+    std::vector<uint8_t> compressed;
+    if (!assets_file::readDocument(argv[1], platform, compressed)) {
+        return 1;
+    }
+    assets_file::Header header;
+    if (!assets_file::decompress(compressed, header, g_data)) {
+        return 1;
+    }
+
+    // main page is the first one in the pages list at +4 of the assets root
+    uint32_t numWidgets = 0;
+    uint32_t numBound = 0;
+    countBoundWidgets(listItem(4, 0), numWidgets, numBound);
+    printf("%s main page: %u widgets, %u bound to data\n", assets_file::getPlatformName(platform), numWidgets, numBound);
+
+    bool ok = true;
+
+    // main page as is, then a page with a bound widget per data function
+    uint32_t pageSizes[2] = { numBound, NUM_DATA_SOURCES * 4 };
+    for (int page = 0; page < 2; page++) {
+        for (int subSecond = 0; subSecond < 2; subSecond++) {
+            // producers alone, subtracted from the rest
+            Result producers;
+            Result polled;
+            Result versioned;
+            Result batched;
+            run(0, numFrames, subSecond, MODE_VERSIONED, producers);
+            run(pageSizes[page], numFrames, subSecond, MODE_POLLED, polled);
+            run(pageSizes[page], numFrames, subSecond, MODE_VERSIONED, versioned);
+            run(pageSizes[page], numFrames, subSecond, MODE_BATCHED, batched);
+
+            bool same = polled.redraws == versioned.redraws && polled.redrawHash == versioned.redrawHash &&
+                polled.redraws == batched.redraws && polled.redrawHash == batched.redrawHash;
+            printf("%u bound widgets%s, %u frames:\n", pageSizes[page], subSecond ? ", sub second changes every frame" : "", numFrames);
+            printf("    polled:    %8u evaluations, %6.1f ns/frame\n",
+                polled.evaluations, 1000.0 * (polled.time - producers.time) / numFrames);
+            printf("    versioned: %8u evaluations, %6.1f ns/frame\n",
+                versioned.evaluations, 1000.0 * (versioned.time - producers.time) / numFrames);
+            printf("    batched:   %8u evaluations, %6.1f ns/frame, producers %.1f ns/frame\n",
+                batched.evaluations, 1000.0 * (batched.time - producers.time) / numFrames, 1000.0 * producers.time / numFrames);
+            printf("    %u redraws, %s\n", polled.redraws, same ? "same widgets redrawn" : "DIFFERENT widgets redrawn");
+            ok = ok && same;
+        }
+    }
+
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+// Calendar conversions in date_time.cpp against the loop implementations
+// they replaced and the C library:
+//
+//   date_time_bench
+//
+// Every day from 1970-01-01 to 2106-02-07 (the uint32_t seconds range) is
+// converted both ways and compared with the old makeTime/breakTime and
+// with gmtime, then random seconds over the whole range. Timings are per
+// breakTime/makeTime call over random times.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "date_time.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// date_time.cpp before the constant time conversions
+
+#define LEAP_YEAR(Y) \
+    (((1970 + Y) > 0) && !((1970 + Y) % 4) && (((1970 + Y) % 100) || !((1970 + Y) % 400)))
+
+static const uint8_t monthDays[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+static uint32_t legacyMakeTime(int year, int month, int day, int hour, int minute, int second) {
+    year -= 1970;
+
+    uint32_t seconds = year * 365 * 86400UL;
+    for (int i = 0; i < year; i++) {
+        if (LEAP_YEAR(i)) {
+            seconds += 86400UL;
+        }
+    }
+
+    for (int i = 1; i < month; i++) {
+        if ((i == 2) && LEAP_YEAR(year)) {
+            seconds += 86400UL * 29;
+        } else {
+            seconds += 86400UL * monthDays[i - 1];
+        }
+    }
+    seconds += (day - 1) * 86400UL;
+    seconds += hour * 3600UL;
+    seconds += minute * 60UL;
+    seconds += second;
+
+    return seconds;
+}
+
+static void legacyBreakTime(uint32_t time, int &resultYear, int &resultMonth, int &resultDay,
+    int &resultHour, int &resultMinute, int &resultSecond) {
+    uint8_t year;
+    uint8_t month, monthLength;
+    uint32_t days;
+
+    resultSecond = time % 60;
+    time /= 60;
+    resultMinute = time % 60;
+    time /= 60;
+    resultHour = time % 24;
+    time /= 24;
+
+    year = 0;
+    days = 0;
+    while ((unsigned)(days += (LEAP_YEAR(year) ? 366 : 365)) <= time) {
+        year++;
+    }
+    resultYear = year + 1970;
+
+    days -= LEAP_YEAR(year) ? 366 : 365;
+    time -= days;
+
+    for (month = 0; month < 12; ++month) {
+        if (month == 1) {
+            monthLength = LEAP_YEAR(year) ? 29 : 28;
+        } else {
+            monthLength = monthDays[month];
+        }
+
+        if (time >= monthLength) {
+            time -= monthLength;
+        } else {
+            break;
+        }
+    }
+
+    resultMonth = month + 1;
+    resultDay = time + 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static int g_errors;
+
+// keeps the measured calls from being optimized away
+static volatile uint32_t g_sink;
+
+static void error(const char *what, uint32_t time) {
+    if (++g_errors <= 10) {
+        printf("  %s mismatch at %u\n", what, (unsigned)time);
+    }
+}
+
+static bool isLeapYear(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static int daysInMonth(int year, int month) {
+    return month == 2 && isLeapYear(year) ? 29 : monthDays[month - 1];
+}
+
+static void checkTime(uint32_t time) {
+    int year, month, day, hour, minute, second;
+    date_time::breakTime(time, year, month, day, hour, minute, second);
+
+    if (date_time::makeTime(year, month, day, hour, minute, second) != time) {
+        error("round trip", time);
+    }
+
+    int legacyYear, legacyMonth, legacyDay, legacyHour, legacyMinute, legacySecond;
+    legacyBreakTime(time, legacyYear, legacyMonth, legacyDay, legacyHour, legacyMinute, legacySecond);
+    if (year != legacyYear || month != legacyMonth || day != legacyDay ||
+        hour != legacyHour || minute != legacyMinute || second != legacySecond) {
+        error("legacy breakTime", time);
+    }
+
+    time_t t = (time_t)time;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    if (year != tm.tm_year + 1900 || month != tm.tm_mon + 1 || day != tm.tm_mday ||
+        hour != tm.tm_hour || minute != tm.tm_min || second != tm.tm_sec) {
+        error("gmtime", time);
+    }
+}
+
+// Walks the calendar day by day independently of both implementations.
+static uint32_t checkAllDays() {
+    int year = 1970, month = 1, day = 1;
+    uint32_t numDays = 0;
+
+    for (int32_t days = 0;; days++) {
+        if (date_time::daysFromCivil(year, month, day) != days) {
+            error("daysFromCivil", days);
+        }
+
+        int y, m, d;
+        date_time::civilFromDays(days, y, m, d);
+        if (y != year || m != month || d != day) {
+            error("civilFromDays", days);
+        }
+
+        // seconds of the last day are cut at 2106-02-07 06:28:15
+        uint32_t midnight = (uint32_t)days * 86400;
+        checkTime(midnight);
+        uint32_t last = days == 49710 ? 0xFFFFFFFF : midnight + 86399;
+        checkTime(last);
+
+        if (date_time::makeTime(year, month, day, 12, 34, 56) != legacyMakeTime(year, month, day, 12, 34, 56) &&
+            days != 49710) {
+            error("legacy makeTime", midnight);
+        }
+
+        numDays++;
+        if (days == 49710) {
+            break;
+        }
+
+        if (++day > daysInMonth(year, month)) {
+            day = 1;
+            if (++month > 12) {
+                month = 1;
+                year++;
+            }
+        }
+    }
+
+    if (year != 2106 || month != 2 || day != 7) {
+        error("last day", 0);
+    }
+
+    return numDays;
+}
+
+template <typename Func>
+static double measure(const std::vector<uint32_t> &times, Func func) {
+    auto start = std::chrono::high_resolution_clock::now();
+    uint32_t sum = 0;
+    for (uint32_t time : times) {
+        sum += func(time);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    g_sink = sum;
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / times.size();
+}
+
+int main() {
+    printf("days 1970-01-01 .. 2106-02-07: ");
+    uint32_t numDays = checkAllDays();
+    printf("%u checked\n", (unsigned)numDays);
+
+    std::mt19937 random(1);
+    std::vector<uint32_t> times(1000000);
+    for (auto &time : times) {
+        time = random();
+    }
+
+    printf("random seconds: ");
+    for (uint32_t time : times) {
+        checkTime(time);
+    }
+    printf("%u checked\n", (unsigned)times.size());
+
+    double legacyBreak = measure(times, [](uint32_t time) {
+        int year, month, day, hour, minute, second;
+        legacyBreakTime(time, year, month, day, hour, minute, second);
+        return (uint32_t)(year + month + day + hour + minute + second);
+    });
+    double newBreak = measure(times, [](uint32_t time) {
+        int year, month, day, hour, minute, second;
+        date_time::breakTime(time, year, month, day, hour, minute, second);
+        return (uint32_t)(year + month + day + hour + minute + second);
+    });
+
+    double legacyMake = measure(times, [](uint32_t time) {
+        return legacyMakeTime(1970 + time % 136, 1 + time % 12, 1 + time % 28, time % 24, time % 60, time % 59);
+    });
+    double newMake = measure(times, [](uint32_t time) {
+        return date_time::makeTime(1970 + time % 136, 1 + time % 12, 1 + time % 28, time % 24, time % 60, time % 59);
+    });
+
+    printf("\n%-10s %10s %10s\n", "", "loops", "constant");
+    printf("%-10s %8.1fns %8.1fns\n", "breakTime", legacyBreak, newBreak);
+    printf("%-10s %8.1fns %8.1fns\n", "makeTime", legacyMake, newMake);
+
+    printf("\n%s\n", g_errors == 0 ? "OK" : "FAILED");
+    return g_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,272 @@
+// Damage limited redraw of gui/display_list.cpp against drawing every
+// widget on every frame:
+//
+//   display_list_bench [frames]
+//
+// The modeled page has a background, panels with rounded corners and
+// lines, and values which change at different rates. One widget moves, one
+// comes and goes, one key is used by two widgets, every 100 frames the page
+// is invalidated and one frame doesn't fit into the display list. Frames
+// are drawn into two buffers in turn, as with double buffering, and each
+// must be identical to a full redraw of the same frame.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "eez-framework-conf.h"
+#include "gui/display_list.h"
+#include "gui/pixel_format.h"
+#include "gui/shape_mask_cache.h"
+
+using namespace eez::gui;
+
+typedef pixel_format::Argb8888 Format;
+
+static const uint32_t NUM_PANELS = 48;
+static const uint32_t NUM_VALUES = 8;
+static const uint32_t OVERFLOW_WIDGETS = 1200;
+
+static uint32_t *g_target;
+static bool g_isReference;
+static uint32_t g_numErrors;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void fill(uint16_t color, uint8_t opacity, int x1, int y1, int x2, int y2, int radius, const display_list::Rect &clip) {
+    int cx1 = x1 > clip.x1 ? x1 : clip.x1;
+    int cy1 = y1 > clip.y1 ? y1 : clip.y1;
+    int cx2 = x2 < clip.x2 ? x2 : clip.x2;
+    int cy2 = y2 < clip.y2 ? y2 : clip.y2;
+    if (cx1 > cx2 || cy1 > cy2) {
+        return;
+    }
+
+    if (radius == 0) {
+        pixel_format::fillRect<Format>(g_target, DISPLAY_WIDTH, cx1, cy1, cx2, cy2, color, opacity);
+    } else {
+        shape_mask_cache::Rect maskClip = { cx1, cy1, cx2, cy2 };
+        shape_mask_cache::drawRoundedRect<Format>(g_target, DISPLAY_WIDTH, maskClip,
+            x1, y1, x2, y2, radius, 0, color, color, opacity);
+    }
+}
+
+namespace eez {
+namespace gui {
+namespace display_list {
+
+void executeCommand(const Command &command, const Rect &clip) {
+    switch (command.type) {
+    case COMMAND_FILL_RECT:
+        fill(command.color, command.opacity, command.x1, command.y1, command.x2, command.y2, command.radius, clip);
+        break;
+    case COMMAND_HLINE:
+        fill(command.color, command.opacity, command.x1, command.y1, command.x1 + command.x2, command.y1, 0, clip);
+        break;
+    case COMMAND_VLINE:
+        fill(command.color, command.opacity, command.x1, command.y1, command.x1, command.y1 + command.x2, 0, clip);
+        break;
+    }
+}
+
+} // namespace display_list
+} // namespace gui
+} // namespace eez
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The page is drawn through these, either recorded into the display list or,
+// for the reference, drawn right away.
+
+static const display_list::Rect DISPLAY_RECT = { 0, 0, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1 };
+
+static bool beginWidget(uint32_t widgetKey, uint32_t dependencyHash) {
+    return !g_isReference && display_list::beginWidget(widgetKey, dependencyHash);
+}
+
+static void endWidget() {
+    if (!g_isReference) {
+        display_list::endWidget();
+    }
+}
+
+static void fillRect(uint16_t color, uint8_t opacity, int x1, int y1, int x2, int y2, int radius = 0) {
+    if (g_isReference) {
+        fill(color, opacity, x1, y1, x2, y2, radius, DISPLAY_RECT);
+    } else {
+        display_list::fillRect(color, opacity, x1, y1, x2, y2, radius);
+    }
+}
+
+static void drawHLine(uint16_t color, int x, int y, int length) {
+    if (g_isReference) {
+        fill(color, 255, x, y, x + length, y, 0, DISPLAY_RECT);
+    } else {
+        display_list::drawHLine(color, 255, x, y, length);
+    }
+}
+
+static void drawVLine(uint16_t color, int x, int y, int length) {
+    if (g_isReference) {
+        fill(color, 255, x, y, x, y + length, 0, DISPLAY_RECT);
+    } else {
+        display_list::drawVLine(color, 255, x, y, length);
+    }
+}
+
+// value shown as a bar of digit wide blocks, its width changes with the value
+static void drawValue(uint32_t key, int x, int y, uint32_t value) {
+    if (beginWidget(key, display_list::hashUint32(value))) {
+        return;
+    }
+    fillRect(0x18E3, 255, x, y, x + 159, y + 29);
+    for (uint32_t digit = 0; digit <= value % 7; digit++) {
+        int dx = x + 4 + (int)digit * 22;
+        fillRect((uint16_t)(0x07E0 + value * 31), 255, dx, y + 4, dx + 17, y + 25, 3);
+    }
+    endWidget();
+}
+
+static void drawPage(uint32_t frame) {
+    if (!beginWidget(1, 0)) {
+        fillRect(0x0000, 255, 0, 0, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1);
+        endWidget();
+    }
+
+    for (uint32_t i = 0; i < NUM_PANELS; i++) {
+        int x = 10 + (int)(i % 8) * (DISPLAY_WIDTH / 8);
+        int y = 10 + (int)(i / 8) * 70;
+        int w = DISPLAY_WIDTH / 8 - 20;
+        if (!beginWidget(100 + i, 0)) {
+            fillRect((uint16_t)(0x2104 * (i % 4 + 1)), 255, x, y, x + w - 1, y + 59, 8);
+            drawHLine(0xFFFF, x + 8, y + 20, w - 17);
+            drawVLine(0xFFFF, x + w / 2, y + 24, 30);
+            endWidget();
+        }
+    }
+
+    // value i changes every (i + 1) frames
+    for (uint32_t i = 0; i < NUM_VALUES; i++) {
+        int x = 20 + (int)(i % 4) * (DISPLAY_WIDTH / 4);
+        int y = DISPLAY_HEIGHT - 80 + (int)(i / 4) * 36;
+        drawValue(200 + i, x, y, frame / (i + 1));
+    }
+
+    // moved every 30 frames
+    int x = 300 + (int)(frame / 30 % 5) * 40;
+    if (!beginWidget(300, display_list::hashUint32(x))) {
+        fillRect(0xF800, 160, x, 200, x + 79, 259, 12);
+        endWidget();
+    }
+
+    // shown for 25 frames out of 50
+    if (frame % 50 < 25 && !beginWidget(301, 0)) {
+        fillRect(0x001F, 255, 600, 120, 699, 179, 6);
+        endWidget();
+    }
+
+    // second widget with the same key, changes every frame
+    if (!beginWidget(302, 0)) {
+        fillRect(0xFFE0, 255, 40, 300, 99, 319);
+        endWidget();
+    }
+    if (!beginWidget(302, display_list::hashUint32(frame))) {
+        fillRect((uint16_t)(frame * 97), 255, 110, 300, 169, 319, 4);
+        endWidget();
+    }
+
+    // more than the display list can hold
+    if (frame % 100 == 77) {
+        for (uint32_t i = 0; i < OVERFLOW_WIDGETS; i++) {
+            if (!beginWidget(1000 + i, 0)) {
+                int wx = (int)(i * 37 % (DISPLAY_WIDTH - 10));
+                int wy = (int)(i * 53 % (DISPLAY_HEIGHT - 10));
+                fillRect((uint16_t)(i * 1013), 255, wx, wy, wx + 7, wy + 7);
+                drawHLine(0xFFFF, wx, wy + 8, 8);
+                drawVLine(0xFFFF, wx + 8, wy, 8);
+                fillRect(0x0000, 128, wx + 2, wy + 2, wx + 5, wy + 5);
+                endWidget();
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv) {
+    uint32_t numFrames = argc > 1 ? (uint32_t)atoi(argv[1]) : 500;
+    if (numFrames == 0) {
+        numFrames = 500;
+    }
+
+    size_t numPixels = DISPLAY_WIDTH * DISPLAY_HEIGHT;
+    std::vector<uint32_t> buffers[DISPLAY_LIST_BUFFER_AGE];
+    for (auto &buffer : buffers) {
+        buffer.resize(numPixels);
+    }
+    std::vector<uint32_t> reference(numPixels);
+
+    typedef std::chrono::high_resolution_clock Clock;
+    double damageTime = 0;
+    double fullTime = 0;
+    uint64_t damagedPixels = 0;
+    uint32_t numOverflowFrames = 0;
+    uint32_t numCommands = 0;
+    uint32_t numExecuted = 0;
+
+    for (uint32_t frame = 0; frame < numFrames; frame++) {
+        if (frame % 100 == 50) {
+            display_list::invalidateAll();
+        }
+
+        display_list::g_stats = display_list::Stats();
+
+        g_isReference = false;
+        auto buffer = buffers[frame % DISPLAY_LIST_BUFFER_AGE].data();
+        g_target = buffer;
+        auto start = Clock::now();
+        display_list::beginFrame();
+        drawPage(frame);
+        display_list::endFrame();
+        damageTime += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        g_isReference = true;
+        g_target = reference.data();
+        start = Clock::now();
+        drawPage(frame);
+        fullTime += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        auto &stats = display_list::g_stats;
+        if (stats.overflows) {
+            numOverflowFrames++;
+        } else {
+            damagedPixels += stats.damagedPixels;
+            numCommands += stats.commandsRecorded + stats.commandsReplayed;
+            numExecuted += stats.commandsExecuted;
+        }
+
+        if (memcmp(reference.data(), buffer, numPixels * sizeof(uint32_t)) != 0) {
+            if (g_numErrors++ < 10) {
+                printf("frame %u differs from full redraw\n", frame);
+            }
+        }
+    }
+
+    if (numOverflowFrames == 0) {
+        g_numErrors++;
+        printf("display list never overflowed\n");
+    }
+
+    uint32_t numNormalFrames = numFrames - numOverflowFrames;
+    printf("%u frames %ux%u, %u buffers, %u of them didn't fit into the display list\n",
+        numFrames, DISPLAY_WIDTH, DISPLAY_HEIGHT, DISPLAY_LIST_BUFFER_AGE, numOverflowFrames);
+    printf("  damaged: %5.1f%% of the pixels, %u of %u commands executed\n",
+        numNormalFrames ? 100.0 * damagedPixels / numNormalFrames / numPixels : 0.0, numExecuted, numCommands);
+    printf("  per frame: %.3f ms with damage, %.3f ms full redraw\n", damageTime / numFrames, fullTime / numFrames);
+
+    printf("\n%s\n", g_numErrors == 0 ? "OK" : "FAILED");
+    return g_numErrors == 0 ? 0 : 1;
+}
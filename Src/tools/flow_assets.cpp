@@ -0,0 +1,220 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+
+#include "flow_assets.h"
+#include "json.h"
+
+namespace flow_assets {
+
+std::string getOperationName(int operation) {
+    static const char *NAMES[NUM_OPERATIONS] = {
+        "+", "-", "*", "/", "%", "<<", ">>", "&", "|", "^",
+        "==", "!=", "<", ">", "<=", ">=", "&&", "||", "unary +", "unary -",
+        "~", "!", "?:", "System.getTick", "Flow.index", "Flow.isPageActive",
+        "Flow.pageTimelinePosition", "Flow.makeValue", "Flow.makeArrayValue", "Flow.languages",
+        "Flow.translate", "Flow.parseInteger", "Flow.parseFloat", "Flow.parseDouble",
+        "Date.now", "Date.toString", "Date.fromString", "Math.sin", "Math.cos", "Math.log",
+        "Math.log10", "Math.abs", "Math.floor", "Math.ceil", "Math.round", "Math.min", "Math.max",
+        "String.length", "String.substring", "String.find", "String.padStart", "String.split"
+    };
+
+    if (operation >= 0 && operation < NUM_OPERATIONS) {
+        return NAMES[operation];
+    }
+    return "operation " + std::to_string(operation);
+}
+
+// Root: settings, pages, styles, fonts, bitmaps, colors, action names,
+// variable names, flow definition at +56, languages. Pointers are
+// self-relative, lists are { count, pointer to array of pointers }.
+struct Reader {
+    const std::vector<uint8_t> &data;
+
+    uint32_t u32(uint32_t offset) const {
+        if (offset + 4 > data.size()) {
+            return 0;
+        }
+        uint32_t value;
+        memcpy(&value, data.data() + offset, 4);
+        return value;
+    }
+
+    uint16_t u16(uint32_t offset) const {
+        return offset + 2 <= data.size() ? (uint16_t)(data[offset] | (data[offset + 1] << 8)) : 0;
+    }
+
+    uint32_t ptr(uint32_t offset) const {
+        uint32_t value = u32(offset);
+        return value ? offset + value : 0;
+    }
+
+    uint32_t listCount(uint32_t offset) const {
+        return u32(offset);
+    }
+
+    uint32_t listItem(uint32_t offset, uint32_t index) const {
+        return ptr(ptr(offset + 4) + 4 * index);
+    }
+
+    AssetValue value(uint32_t offset) const {
+        AssetValue value;
+        value.type = offset < data.size() ? (uint8_t)data[offset] : (uint8_t)TYPE_UNDEFINED;
+        value.int32Value = (int32_t)u32(offset + 8);
+        memcpy(&value.floatValue, data.data() + offset + 8, 4);
+        memcpy(&value.doubleValue, data.data() + offset + 8, 8);
+        if (value.type == TYPE_STRING_ASSET) {
+            uint32_t str = ptr(offset + 8);
+            for (uint32_t i = str; i < data.size() && data[i]; i++) {
+                value.stringValue += (char)data[i];
+            }
+        }
+        return value;
+    }
+};
+
+bool read(const std::vector<uint8_t> &assets, FlowDefinition &flowDefinition) {
+    Reader reader{ assets };
+
+    // FlowDefinition: flows, constants, global variables, ...
+    uint32_t definition = reader.ptr(56);
+    if (!definition) {
+        fprintf(stderr, "no flow definition in the assets\n");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < reader.listCount(definition + 8); i++) {
+        flowDefinition.constants.push_back(reader.value(reader.listItem(definition + 8, i)));
+    }
+
+    for (uint32_t i = 0; i < reader.listCount(definition + 16); i++) {
+        flowDefinition.globalVariables.push_back(reader.value(reader.listItem(definition + 16, i)));
+    }
+
+    // Flow: components, local variables, component inputs, widget data
+    // items, widget actions
+    uint32_t numFlows = reader.listCount(definition);
+    flowDefinition.localVariables.resize(numFlows);
+    for (uint32_t flowIndex = 0; flowIndex < numFlows; flowIndex++) {
+        uint32_t flow = reader.listItem(definition, flowIndex);
+
+        for (uint32_t i = 0; i < reader.listCount(flow + 8); i++) {
+            flowDefinition.localVariables[flowIndex].push_back(reader.value(reader.listItem(flow + 8, i)));
+        }
+
+        // Component: type, reserved, inputs, properties, outputs, error
+        // catch output. Property is the instructions itself.
+        for (uint32_t componentIndex = 0; componentIndex < reader.listCount(flow); componentIndex++) {
+            uint32_t component = reader.listItem(flow, componentIndex);
+
+            for (uint32_t propertyIndex = 0; propertyIndex < reader.listCount(component + 12); propertyIndex++) {
+                Property property;
+                property.flowIndex = (int)flowIndex;
+                property.componentIndex = (int)componentIndex;
+                property.propertyIndex = (int)propertyIndex;
+                property.componentType = reader.u16(component);
+
+                uint32_t offset = reader.listItem(component + 12, propertyIndex);
+                while (offset + 2 <= assets.size()) {
+                    uint16_t instruction = reader.u16(offset);
+                    property.instructions.push_back(instruction);
+                    offset += 2;
+                    if (getInstructionType(instruction) == INSTRUCTION_END) {
+                        break;
+                    }
+                }
+
+                flowDefinition.properties.push_back(property);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool readDataIds(const char *documentPath, std::map<std::string, int16_t> &dataIds) {
+    std::string path = documentPath;
+    size_t dot = path.rfind('.');
+    std::vector<uint8_t> data;
+    if (dot == std::string::npos || !assets_file::readFile((path.substr(0, dot) + ".h").c_str(), data)) {
+        return false;
+    }
+    std::string text(data.begin(), data.end());
+
+    for (size_t pos = text.find("DATA_ID_"); pos != std::string::npos; pos = text.find("DATA_ID_", pos + 1)) {
+        size_t nameEnd = text.find_first_of(" =", pos);
+        size_t equals = text.find('=', pos);
+        if (nameEnd == std::string::npos || equals == std::string::npos) {
+            break;
+        }
+
+        int16_t dataId = (int16_t)atoi(text.c_str() + equals + 1);
+        if (dataId != 0) {
+            dataIds[text.substr(pos + 8, nameEnd - pos - 8)] = dataId;
+        }
+    }
+
+    return true;
+}
+
+bool readNativeVariableTypes(const char *projectPath, const char *documentPath, std::vector<uint8_t> &types) {
+    std::vector<uint8_t> data;
+    if (!assets_file::readFile(projectPath, data)) {
+        return false;
+    }
+
+    json::Value project;
+    if (!json::parse(std::string(data.begin(), data.end()), project)) {
+        fprintf(stderr, "can't parse %s\n", projectPath);
+        return false;
+    }
+
+    std::map<std::string, uint8_t> typesByName;
+    auto variables = project.get("variables");
+    auto globalVariables = variables ? variables->get("globalVariables") : nullptr;
+    if (globalVariables) {
+        for (auto &variable : globalVariables->items) {
+            auto native = variable.get("native");
+            auto name = variable.get("name");
+            auto type = variable.get("type");
+            if (!native || !native->isTrue() || !name || !type) {
+                continue;
+            }
+
+            std::string typeName = type->str();
+            uint8_t valueType = typeName == "integer" ? TYPE_INT32 :
+                typeName == "float" ? TYPE_FLOAT :
+                typeName == "double" ? TYPE_DOUBLE :
+                typeName == "boolean" ? TYPE_BOOLEAN : TYPE_UNDEFINED;
+
+            std::string upperName;
+            for (char ch : name->str()) {
+                upperName += (char)toupper((unsigned char)ch);
+            }
+            typesByName[upperName] = valueType;
+        }
+    }
+
+    std::map<std::string, int16_t> dataIds;
+    if (!readDataIds(documentPath, dataIds)) {
+        return false;
+    }
+
+    for (auto &it : dataIds) {
+        auto type = typesByName.find(it.first);
+        if (type == typesByName.end()) {
+            continue;
+        }
+        if (types.size() <= (size_t)it.second) {
+            types.resize(it.second + 1, TYPE_UNDEFINED);
+        }
+        types[it.second] = type->second;
+    }
+
+    return true;
+}
+
+} // namespace flow_assets
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "assets_file.h"
+
+// Flow definition in the decompressed assets, for the tools that work with
+// flow expressions. Expressions are kept as eez-flow evaluates them: a
+// sequence of 16-bit instructions, 3 bit type and 13 bit argument, run on
+// a value stack. Operands of a binary operation are pushed left first,
+// function arguments last first followed by their count if the function
+// takes a variable number of them.
+
+namespace flow_assets {
+
+enum Instruction {
+    INSTRUCTION_PUSH_CONSTANT,
+    INSTRUCTION_PUSH_INPUT,
+    INSTRUCTION_PUSH_LOCAL_VAR,
+    INSTRUCTION_PUSH_GLOBAL_VAR,
+    INSTRUCTION_PUSH_OUTPUT,
+    INSTRUCTION_ARRAY_ELEMENT,
+    INSTRUCTION_OPERATION,
+    INSTRUCTION_END
+};
+
+inline int getInstructionType(uint16_t instruction) {
+    return instruction >> 13;
+}
+
+inline int getInstructionArg(uint16_t instruction) {
+    return instruction & 0x1FFF;
+}
+
+// index into g_evalOperations[] of eez-flow
+enum Operation {
+    OPERATION_ADD,
+    OPERATION_SUB,
+    OPERATION_MUL,
+    OPERATION_DIV,
+    OPERATION_MOD,
+    OPERATION_LEFT_SHIFT,
+    OPERATION_RIGHT_SHIFT,
+    OPERATION_BINARY_AND,
+    OPERATION_BINARY_OR,
+    OPERATION_BINARY_XOR,
+    OPERATION_EQUAL,
+    OPERATION_NOT_EQUAL,
+    OPERATION_LESS,
+    OPERATION_GREATER,
+    OPERATION_LESS_OR_EQUAL,
+    OPERATION_GREATER_OR_EQUAL,
+    OPERATION_LOGICAL_AND,
+    OPERATION_LOGICAL_OR,
+    OPERATION_UNARY_PLUS,
+    OPERATION_UNARY_MINUS,
+    OPERATION_BINARY_ONE_COMPLEMENT,
+    OPERATION_NOT,
+    OPERATION_CONDITIONAL,
+    OPERATION_SYSTEM_GET_TICK,
+    OPERATION_FLOW_INDEX,
+    OPERATION_FLOW_IS_PAGE_ACTIVE,
+    OPERATION_FLOW_PAGE_TIMELINE_POSITION,
+    OPERATION_FLOW_MAKE_VALUE,
+    OPERATION_FLOW_MAKE_ARRAY_VALUE,
+    OPERATION_FLOW_LANGUAGES,
+    OPERATION_FLOW_TRANSLATE,
+    OPERATION_FLOW_PARSE_INTEGER,
+    OPERATION_FLOW_PARSE_FLOAT,
+    OPERATION_FLOW_PARSE_DOUBLE,
+    OPERATION_DATE_NOW,
+    OPERATION_DATE_TO_STRING,
+    OPERATION_DATE_FROM_STRING,
+    OPERATION_MATH_SIN,
+    OPERATION_MATH_COS,
+    OPERATION_MATH_LOG,
+    OPERATION_MATH_LOG10,
+    OPERATION_MATH_ABS,
+    OPERATION_MATH_FLOOR,
+    OPERATION_MATH_CEIL,
+    OPERATION_MATH_ROUND,
+    OPERATION_MATH_MIN,
+    OPERATION_MATH_MAX,
+    OPERATION_STRING_LENGTH,
+    OPERATION_STRING_SUBSTRING,
+    OPERATION_STRING_FIND,
+    OPERATION_STRING_PAD_START,
+    OPERATION_STRING_SPLIT,
+    NUM_OPERATIONS
+};
+
+// "Math.round", "+", ... or "operation <n>"
+std::string getOperationName(int operation);
+
+// eez::ValueType of the values in the assets
+enum ValueType {
+    TYPE_UNDEFINED,
+    TYPE_NULL,
+    TYPE_BOOLEAN,
+    TYPE_INT8,
+    TYPE_UINT8,
+    TYPE_INT16,
+    TYPE_UINT16,
+    TYPE_INT32,
+    TYPE_UINT32,
+    TYPE_INT64,
+    TYPE_UINT64,
+    TYPE_FLOAT,
+    TYPE_DOUBLE,
+    TYPE_STRING,
+    TYPE_STRING_ASSET
+};
+
+// Value in the assets: type, unit, options, reserved, 8 byte union
+struct AssetValue {
+    uint8_t type;
+    int32_t int32Value;
+    float floatValue;
+    double doubleValue;
+    std::string stringValue; // TYPE_STRING_ASSET
+};
+
+struct Property {
+    int flowIndex;
+    int componentIndex;
+    int propertyIndex;
+    uint16_t componentType;
+    std::vector<uint16_t> instructions; // up to and including END
+};
+
+struct FlowDefinition {
+    std::vector<AssetValue> constants;
+    std::vector<AssetValue> globalVariables; // flow variables, default values
+    std::vector<std::vector<AssetValue>> localVariables; // per flow, default values
+    std::vector<Property> properties;
+
+    // global variable index from numGlobalVariables on is native variable
+    // with data ID index - numGlobalVariables + 1
+    uint32_t getNumGlobalVariables() const {
+        return (uint32_t)globalVariables.size();
+    }
+};
+
+// Flows, constants, variables and component properties from the assets.
+bool read(const std::vector<uint8_t> &assets, FlowDefinition &flowDefinition);
+
+// DATA_ID_ names without the prefix, e.g. TEMPERATURE, from document.h
+// next to document.cpp.
+bool readDataIds(const char *documentPath, std::map<std::string, int16_t> &dataIds);
+
+// Native variable types by data ID, integer, float, double and boolean
+// variables of the project file, TYPE_UNDEFINED for the rest. Data IDs
+// are taken from document.h next to document.cpp.
+bool readNativeVariableTypes(const char *projectPath, const char *documentPath, std::vector<uint8_t> &types);
+
+} // namespace flow_assets
@@ -0,0 +1,215 @@
+// Flow expressions of gui/document.cpp evaluated by the interpreter and by
+// the code tools/flow_expr_gen generated from them:
+//
+//   flow_expr_bench ../../gui/document.cpp ../../<project>.eez-project [iterations]
+//
+// The simulator part of the generated document_expressions.cpp is built
+// into this benchmark from the build directory, see CMakeLists.txt.
+// eez::Value is modeled by tools/flow_value_model.h and the interpreter by
+// tools/flow_interpreter.cpp, which is faster than the real one, so the
+// measured gain is the lower bound.
+//
+// Variables get random values, mostly of their declared type and
+// sometimes of another one. Whenever the generated code evaluates an
+// expression, the interpreter must give the same value.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "eez-framework-conf.h"
+
+#undef OPTION_COMPILED_EXPRESSIONS
+#define OPTION_COMPILED_EXPRESSIONS 1
+
+#include "flow_interpreter.h"
+
+#include "flow/compiled_expressions.cpp"
+#include "document_expressions.cpp"
+
+using namespace eez;
+using namespace eez::flow::compiled_expressions;
+
+static std::vector<Value> g_constants;
+static std::vector<Value> g_nativeVariables;
+
+namespace eez {
+namespace flow {
+namespace compiled_expressions {
+
+const Value &getConstant(const Context &context, uint16_t constantIndex) {
+    return (*(const std::vector<Value> *)context.flowDefinition)[constantIndex];
+}
+
+void getNativeVariable(int16_t dataId, Value &value) {
+    value = g_nativeVariables[dataId];
+}
+
+} // namespace compiled_expressions
+} // namespace flow
+} // namespace eez
+
+static std::mt19937 g_random(1);
+
+// declared type, one in ten of another type if mismatches
+static Value randomValue(uint8_t type, bool mismatches) {
+    static const uint8_t TYPES[] = { VALUE_TYPE_INT32, VALUE_TYPE_FLOAT, VALUE_TYPE_DOUBLE, VALUE_TYPE_BOOLEAN, VALUE_TYPE_UNDEFINED };
+    if (mismatches && g_random() % 10 == 0) {
+        type = TYPES[g_random() % 5];
+    }
+
+    bool special = g_random() % 8 == 0;
+    switch (type) {
+    case VALUE_TYPE_INT32: {
+        static const int32_t SPECIAL[] = { 0, -1, 1, INT32_MIN, INT32_MAX };
+        return Value((int)(special ? SPECIAL[g_random() % 5] : (int32_t)(g_random() % 201) - 100), VALUE_TYPE_INT32);
+    }
+    case VALUE_TYPE_FLOAT:
+        return Value(special ? 0.0f : (float)(g_random() % 200001) / 100.0f - 1000.0f, UNIT_UNKNOWN);
+    case VALUE_TYPE_DOUBLE:
+        return Value(special ? 0.0 : (double)(g_random() % 2000001) / 1000.0 - 1000.0, VALUE_TYPE_DOUBLE);
+    case VALUE_TYPE_BOOLEAN:
+        return Value((int)(g_random() & 1), VALUE_TYPE_BOOLEAN);
+    case VALUE_TYPE_STRING_ASSET: {
+        Value value;
+        value.type = VALUE_TYPE_STRING_ASSET;
+        value.strValue = "text";
+        return value;
+    }
+    default:
+        return Value();
+    }
+}
+
+struct Variables {
+    std::vector<std::vector<Value>> localVariables;
+    std::vector<Value> globalVariables;
+};
+
+static void randomize(const flow_assets::FlowDefinition &flowDefinition, const std::vector<uint8_t> &nativeVariableTypes,
+    Variables &variables, bool mismatches) {
+    variables.localVariables.resize(flowDefinition.localVariables.size());
+    for (size_t flowIndex = 0; flowIndex < flowDefinition.localVariables.size(); flowIndex++) {
+        auto &declared = flowDefinition.localVariables[flowIndex];
+        variables.localVariables[flowIndex].resize(declared.size());
+        for (size_t i = 0; i < declared.size(); i++) {
+            variables.localVariables[flowIndex][i] = randomValue(declared[i].type, mismatches);
+        }
+    }
+
+    variables.globalVariables.resize(flowDefinition.globalVariables.size());
+    for (size_t i = 0; i < flowDefinition.globalVariables.size(); i++) {
+        variables.globalVariables[i] = randomValue(flowDefinition.globalVariables[i].type, mismatches);
+    }
+
+    g_nativeVariables.resize(nativeVariableTypes.size() > 256 ? nativeVariableTypes.size() : 256);
+    for (size_t i = 0; i < g_nativeVariables.size(); i++) {
+        g_nativeVariables[i] = randomValue(i < nativeVariableTypes.size() ? (uint8_t)nativeVariableTypes[i] : (uint8_t)VALUE_TYPE_UNDEFINED, mismatches);
+    }
+}
+
+static Context getContext(Variables &variables, int flowIndex) {
+    Context context;
+    context.localVariables = variables.localVariables[flowIndex].data();
+    context.globalVariables = variables.globalVariables.data();
+    context.flowDefinition = &g_constants;
+    return context;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <document.cpp> <project.eez-project> [iterations]\n", argv[0]);
+        return 1;
+    }
+    uint32_t numIterations = argc > 3 ? (uint32_t)atoi(argv[3]) : 1000000;
+
+    std::vector<uint8_t> compressed;
+    std::vector<uint8_t> assets;
+    assets_file::Header header;
+    flow_assets::FlowDefinition flowDefinition;
+    std::vector<uint8_t> nativeVariableTypes;
+    if (!assets_file::readDocument(argv[1], assets_file::PLATFORM_SIMULATOR, compressed) ||
+        !assets_file::decompress(compressed, header, assets) ||
+        !flow_assets::read(assets, flowDefinition) ||
+        !flow_assets::readNativeVariableTypes(argv[2], argv[1], nativeVariableTypes)) {
+        return 1;
+    }
+
+    for (auto &constant : flowDefinition.constants) {
+        g_constants.push_back(flow_interpreter::toValue(constant));
+    }
+
+    std::vector<const flow_assets::Property *> compiled;
+    for (auto &property : flowDefinition.properties) {
+        uint32_t key = makeKey(property.flowIndex, property.componentIndex, property.propertyIndex);
+        for (uint32_t i = 0; i < g_numExpressions; i++) {
+            if (g_expressions[i].key == key) {
+                compiled.push_back(&property);
+            }
+        }
+    }
+    printf("%u properties, %u compiled expressions\n", (unsigned)flowDefinition.properties.size(), (unsigned)compiled.size());
+
+    // same values from both, for every property
+    Variables variables;
+    uint32_t numChecks = 0;
+    uint32_t numErrors = 0;
+    uint32_t numFallbacks = 0;
+    for (uint32_t i = 0; i < 100000; i++) {
+        randomize(flowDefinition, nativeVariableTypes, variables, true);
+        for (auto property : compiled) {
+            Context context = getContext(variables, property->flowIndex);
+            Value compiledResult;
+            if (!evaluate(property->flowIndex, property->componentIndex, property->propertyIndex, context, compiledResult)) {
+                numFallbacks++;
+                continue;
+            }
+            numChecks++;
+            Value interpretedResult;
+            if (!flow_interpreter::interpret(property->instructions, context, flowDefinition.getNumGlobalVariables(), interpretedResult) ||
+                !flow_interpreter::isSameValue(compiledResult, interpretedResult)) {
+                if (numErrors++ < 10) {
+                    printf("flow %d, component %d, property %d: results differ\n",
+                        property->flowIndex, property->componentIndex, property->propertyIndex);
+                }
+            }
+        }
+    }
+    printf("%u compiled evaluations checked, %u left to the interpreter on type mismatch or error\n", numChecks, numFallbacks);
+
+    // declared types only
+    randomize(flowDefinition, nativeVariableTypes, variables, false);
+    double sink = 0;
+    double times[2];
+    for (int compiledCode = 0; compiledCode < 2; compiledCode++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < numIterations; i++) {
+            for (auto property : compiled) {
+                Context context = getContext(variables, property->flowIndex);
+                Value result;
+                if (compiledCode) {
+                    evaluate(property->flowIndex, property->componentIndex, property->propertyIndex, context, result);
+                } else {
+                    flow_interpreter::interpret(property->instructions, context, flowDefinition.getNumGlobalVariables(), result);
+                }
+                sink += result.int32Value;
+            }
+        }
+        times[compiledCode] = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    double numEvaluations = (double)numIterations * (compiled.size() ? compiled.size() : 1);
+    printf("interpreted: %6.1f ns per expression\n", times[0] * 1e9 / numEvaluations);
+    printf("compiled:    %6.1f ns per expression, %.1fx\n", times[1] * 1e9 / numEvaluations, times[0] / times[1]);
+    if (sink == 0.5) {
+        printf("\n");
+    }
+
+    printf("\n%s\n", numErrors == 0 ? "OK" : "FAILED");
+    return numErrors == 0 ? 0 : 1;
+}
@@ -0,0 +1,590 @@
+// Generates document_expressions.cpp with the flow expressions of
+// gui/document.cpp translated to C++ functions (see
+// flow/compiled_expressions.h). The build runs it for flow_expr_bench:
+//
+//   flow_expr_gen ../../gui/document.cpp document_expressions.cpp [../../<project>.eez-project]
+//
+// Native variable types come from the project file. Without it an
+// expression which reads a native variable is only compiled if it passes
+// the value through, e.g. as a branch of ?:. Expressions without any
+// operation are left to the interpreter, there is nothing to gain.
+//
+// Reports the compiled expressions and the operations that kept the others
+// from being compiled.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "flow_assets.h"
+
+using namespace flow_assets;
+
+enum Kind {
+    KIND_INT32,
+    KIND_FLOAT,
+    KIND_DOUBLE,
+    KIND_BOOLEAN,
+    KIND_VALUE // any type, passed through as Value
+};
+
+static const char *KIND_TYPES[] = { "int32_t", "float", "double", "bool" };
+static const char *KIND_VALUE_TYPES[] = { "VALUE_TYPE_INT32", "VALUE_TYPE_FLOAT", "VALUE_TYPE_DOUBLE", "VALUE_TYPE_BOOLEAN" };
+
+static Kind getKind(uint8_t valueType) {
+    return valueType == TYPE_INT32 ? KIND_INT32 :
+        valueType == TYPE_FLOAT ? KIND_FLOAT :
+        valueType == TYPE_DOUBLE ? KIND_DOUBLE :
+        valueType == TYPE_BOOLEAN ? KIND_BOOLEAN : KIND_VALUE;
+}
+
+static bool isNumber(Kind kind) {
+    return kind == KIND_INT32 || kind == KIND_FLOAT || kind == KIND_DOUBLE;
+}
+
+struct Operand {
+    Kind kind;
+    std::string code;
+    std::string text; // for the comment
+    bool isConstant;
+    int32_t constant; // if isConstant and KIND_INT32
+};
+
+static std::string formatFloat(double value, bool isFloat) {
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), isFloat ? "%.9g" : "%.17g", value);
+    std::string text = buffer;
+    if (text.find_first_of(".e") == std::string::npos) {
+        text += ".0";
+    }
+    return isFloat ? text + "f" : text;
+}
+
+class Compiler {
+public:
+    Compiler(const FlowDefinition &flowDefinition, const std::vector<uint8_t> &nativeVariableTypes, int flowIndex)
+        : m_flowDefinition(flowDefinition), m_nativeVariableTypes(nativeVariableTypes), m_flowIndex(flowIndex) {
+    }
+
+    // Function body, or false with the reason in error.
+    bool compile(const std::vector<uint16_t> &instructions, std::string &body, std::string &text) {
+        bool hasOperation = false;
+
+        for (uint16_t instruction : instructions) {
+            int arg = getInstructionArg(instruction);
+
+            switch (getInstructionType(instruction)) {
+            case INSTRUCTION_PUSH_CONSTANT:
+                if (!pushConstant(arg)) {
+                    return false;
+                }
+                break;
+
+            case INSTRUCTION_PUSH_LOCAL_VAR:
+                if (!pushLocalVariable(arg)) {
+                    return false;
+                }
+                break;
+
+            case INSTRUCTION_PUSH_GLOBAL_VAR:
+                pushGlobalVariable(arg);
+                break;
+
+            case INSTRUCTION_OPERATION:
+                hasOperation = true;
+                if (!operation(arg)) {
+                    return false;
+                }
+                break;
+
+            case INSTRUCTION_END:
+                if (!hasOperation) {
+                    error = "no operation";
+                    return false;
+                }
+                if (m_stack.size() != 1) {
+                    error = "stack";
+                    return false;
+                }
+                for (auto &statement : m_statements) {
+                    body += "    " + statement + "\n";
+                }
+                body += "    result = " + box(m_stack[0]) + ";\n";
+                body += "    return true;\n";
+                text = m_stack[0].text;
+                return true;
+
+            case INSTRUCTION_PUSH_INPUT:
+                error = "component input";
+                return false;
+
+            default:
+                error = "output or array element";
+                return false;
+            }
+        }
+
+        error = "no END";
+        return false;
+    }
+
+    std::string error;
+
+private:
+    const FlowDefinition &m_flowDefinition;
+    const std::vector<uint8_t> &m_nativeVariableTypes;
+    int m_flowIndex;
+
+    std::vector<std::string> m_statements;
+    std::vector<Operand> m_stack;
+    std::set<std::string> m_loaded;
+    int m_numTemps = 0;
+
+    void push(Kind kind, const std::string &code, const std::string &text) {
+        m_stack.push_back(Operand{ kind, code, text, false, 0 });
+    }
+
+    Operand pop() {
+        Operand operand = m_stack.back();
+        m_stack.pop_back();
+        return operand;
+    }
+
+    bool pushConstant(int index) {
+        if (index >= (int)m_flowDefinition.constants.size()) {
+            error = "constant index";
+            return false;
+        }
+
+        const AssetValue &value = m_flowDefinition.constants[index];
+        Kind kind = getKind(value.type);
+
+        if (kind == KIND_INT32) {
+            std::string code = value.int32Value == INT32_MIN ? "(-2147483647 - 1)" : std::to_string(value.int32Value);
+            m_stack.push_back(Operand{ KIND_INT32, code, std::to_string(value.int32Value), true, value.int32Value });
+        } else if (kind == KIND_FLOAT && value.floatValue == value.floatValue) {
+            std::string code = formatFloat(value.floatValue, true);
+            push(KIND_FLOAT, code, code);
+        } else if (kind == KIND_DOUBLE && value.doubleValue == value.doubleValue) {
+            std::string code = formatFloat(value.doubleValue, false);
+            push(KIND_DOUBLE, code, code);
+        } else if (kind == KIND_BOOLEAN) {
+            push(KIND_BOOLEAN, value.int32Value ? "true" : "false", value.int32Value ? "true" : "false");
+        } else {
+            std::string text = value.type == TYPE_STRING_ASSET ? "\"" + value.stringValue + "\"" : "constant " + std::to_string(index);
+            // keep the comment on one line and closed
+            for (auto &ch : text) {
+                if (ch == '\n' || ch == '\r' || ch == '*') {
+                    ch = ' ';
+                }
+            }
+            push(KIND_VALUE, "getConstant(context, " + std::to_string(index) + ")", text);
+        }
+
+        return true;
+    }
+
+    // Reads the value once and checks that it has the declared type.
+    void load(Kind kind, const std::string &name, const std::string &source, bool isReference, const std::string &text) {
+        if (!m_loaded.count(name)) {
+            m_loaded.insert(name);
+            if (isReference) {
+                m_statements.push_back("const Value &" + name + " = " + source + ";");
+            } else {
+                m_statements.push_back("Value " + name + ";");
+                m_statements.push_back(source + ";");
+            }
+            if (kind != KIND_VALUE) {
+                m_statements.push_back("if (" + name + ".type != " + KIND_VALUE_TYPES[kind] + ") {");
+                m_statements.push_back("    return false;");
+                m_statements.push_back("}");
+            }
+        }
+
+        std::string code = kind == KIND_INT32 ? name + ".int32Value" :
+            kind == KIND_FLOAT ? name + ".floatValue" :
+            kind == KIND_DOUBLE ? name + ".doubleValue" :
+            kind == KIND_BOOLEAN ? "(" + name + ".int32Value != 0)" : name;
+        push(kind, code, text);
+    }
+
+    bool pushLocalVariable(int index) {
+        auto &localVariables = m_flowDefinition.localVariables[m_flowIndex];
+        if (index >= (int)localVariables.size()) {
+            error = "local variable index";
+            return false;
+        }
+
+        std::string name = "l" + std::to_string(index);
+        load(getKind(localVariables[index].type), name,
+            "context.localVariables[" + std::to_string(index) + "]", true, "local" + std::to_string(index));
+        return true;
+    }
+
+    void pushGlobalVariable(int index) {
+        uint32_t numGlobalVariables = m_flowDefinition.getNumGlobalVariables();
+
+        if ((uint32_t)index < numGlobalVariables) {
+            std::string name = "g" + std::to_string(index);
+            load(getKind(m_flowDefinition.globalVariables[index].type), name,
+                "context.globalVariables[" + std::to_string(index) + "]", true, "global" + std::to_string(index));
+        } else {
+            uint32_t dataId = index - numGlobalVariables + 1;
+            uint8_t type = dataId < m_nativeVariableTypes.size() ? (uint8_t)m_nativeVariableTypes[dataId] : (uint8_t)TYPE_UNDEFINED;
+            std::string name = "n" + std::to_string(dataId);
+            load(getKind(type), name,
+                "getNativeVariable(" + std::to_string(dataId) + ", " + name + ")", false, "native" + std::to_string(dataId));
+        }
+    }
+
+    // declared with the checked value, so the check and the use see the same
+    std::string temp(Kind kind, const std::string &code) {
+        std::string name = "t" + std::to_string(m_numTemps++);
+        m_statements.push_back(std::string("const ") + KIND_TYPES[kind] + " " + name + " = " + code + ";");
+        return name;
+    }
+
+    static std::string cast(const Operand &operand, Kind kind) {
+        if (operand.kind == kind) {
+            return operand.code;
+        }
+        return std::string("(") + KIND_TYPES[kind] + ")" + operand.code;
+    }
+
+    // int32 < float < double, as the interpreter promotes
+    bool promote(const Operand &a, const Operand &b, Kind &kind) {
+        if (!isNumber(a.kind) || !isNumber(b.kind)) {
+            return false;
+        }
+        kind = a.kind > b.kind ? a.kind : b.kind;
+        return true;
+    }
+
+    static std::string box(const Operand &operand) {
+        switch (operand.kind) {
+        case KIND_INT32: return "Value((int)" + operand.code + ", VALUE_TYPE_INT32)";
+        case KIND_FLOAT: return "Value((float)" + operand.code + ", UNIT_UNKNOWN)";
+        case KIND_DOUBLE: return "Value((double)" + operand.code + ", VALUE_TYPE_DOUBLE)";
+        case KIND_BOOLEAN: return "Value(" + operand.code + " ? 1 : 0, VALUE_TYPE_BOOLEAN)";
+        default: return operand.code;
+        }
+    }
+
+    bool unsupported(int op) {
+        error = getOperationName(op);
+        return false;
+    }
+
+    bool operation(int op) {
+        static const char *BINARY_OPERATORS[] = { "+", "-", "*", "/", "%" };
+        static const char *COMPARE_OPERATORS[] = { "==", "!=", "<", ">", "<=", ">=" };
+
+        bool isSupported = op <= OPERATION_MOD || (op >= OPERATION_EQUAL && op <= OPERATION_UNARY_MINUS) ||
+            op == OPERATION_NOT || op == OPERATION_CONDITIONAL || (op >= OPERATION_MATH_ABS && op <= OPERATION_MATH_ROUND);
+        if (!isSupported) {
+            return unsupported(op);
+        }
+
+        size_t numOperands = op == OPERATION_CONDITIONAL ? 3 :
+            op <= OPERATION_LOGICAL_OR ? 2 :
+            op == OPERATION_MATH_ROUND ? 2 : 1;
+        if (m_stack.size() < numOperands) {
+            error = "stack";
+            return false;
+        }
+
+        if (op == OPERATION_ADD || op == OPERATION_SUB || op == OPERATION_MUL) {
+            Operand b = pop();
+            Operand a = pop();
+            Kind kind;
+            if (!promote(a, b, kind)) {
+                return unsupported(op);
+            }
+            std::string code = kind == KIND_INT32 ?
+                "(int32_t)((uint32_t)" + a.code + " " + BINARY_OPERATORS[op] + " (uint32_t)" + b.code + ")" :
+                "(" + cast(a, kind) + " " + BINARY_OPERATORS[op] + " " + cast(b, kind) + ")";
+            push(kind, code, "(" + a.text + " " + BINARY_OPERATORS[op] + " " + b.text + ")");
+            return true;
+        }
+
+        if (op == OPERATION_DIV) {
+            Operand b = pop();
+            Operand a = pop();
+            Kind kind;
+            // integer division is left to the interpreter
+            if (!promote(a, b, kind) || kind == KIND_INT32) {
+                return unsupported(op);
+            }
+            std::string divisor = temp(kind, cast(b, kind));
+            m_statements.push_back("if (" + divisor + " == 0) {");
+            m_statements.push_back("    return false;");
+            m_statements.push_back("}");
+            push(kind, "(" + cast(a, kind) + " / " + divisor + ")", "(" + a.text + " / " + b.text + ")");
+            return true;
+        }
+
+        if (op == OPERATION_MOD) {
+            Operand b = pop();
+            Operand a = pop();
+            if (a.kind != KIND_INT32 || b.kind != KIND_INT32) {
+                return unsupported(op);
+            }
+            std::string divisor = temp(KIND_INT32, b.code);
+            m_statements.push_back("if (" + divisor + " == 0 || " + divisor + " == -1) {");
+            m_statements.push_back("    return false;");
+            m_statements.push_back("}");
+            push(KIND_INT32, "(" + a.code + " % " + divisor + ")", "(" + a.text + " % " + b.text + ")");
+            return true;
+        }
+
+        if (op >= OPERATION_EQUAL && op <= OPERATION_GREATER_OR_EQUAL) {
+            Operand b = pop();
+            Operand a = pop();
+            const char *compare = COMPARE_OPERATORS[op - OPERATION_EQUAL];
+            Kind kind;
+            if (promote(a, b, kind)) {
+                push(KIND_BOOLEAN, "(" + cast(a, kind) + " " + compare + " " + cast(b, kind) + ")",
+                    "(" + a.text + " " + compare + " " + b.text + ")");
+                return true;
+            }
+            if (a.kind == KIND_BOOLEAN && b.kind == KIND_BOOLEAN && op <= OPERATION_NOT_EQUAL) {
+                push(KIND_BOOLEAN, "(" + a.code + " " + compare + " " + b.code + ")",
+                    "(" + a.text + " " + compare + " " + b.text + ")");
+                return true;
+            }
+            return unsupported(op);
+        }
+
+        if (op == OPERATION_LOGICAL_AND || op == OPERATION_LOGICAL_OR) {
+            Operand b = pop();
+            Operand a = pop();
+            if (a.kind != KIND_BOOLEAN || b.kind != KIND_BOOLEAN) {
+                return unsupported(op);
+            }
+            const char *logical = op == OPERATION_LOGICAL_AND ? "&&" : "||";
+            push(KIND_BOOLEAN, "(" + a.code + " " + logical + " " + b.code + ")",
+                "(" + a.text + " " + logical + " " + b.text + ")");
+            return true;
+        }
+
+        if (op == OPERATION_UNARY_PLUS || op == OPERATION_UNARY_MINUS) {
+            Operand a = pop();
+            if (!isNumber(a.kind)) {
+                return unsupported(op);
+            }
+            if (op == OPERATION_UNARY_PLUS) {
+                push(a.kind, a.code, "+" + a.text);
+            } else if (a.kind == KIND_INT32) {
+                push(KIND_INT32, "(int32_t)(0u - (uint32_t)" + a.code + ")", "-" + a.text);
+            } else {
+                push(a.kind, "(-" + a.code + ")", "-" + a.text);
+            }
+            return true;
+        }
+
+        if (op == OPERATION_NOT) {
+            Operand a = pop();
+            if (a.kind != KIND_BOOLEAN) {
+                return unsupported(op);
+            }
+            push(KIND_BOOLEAN, "(!" + a.code + ")", "!" + a.text);
+            return true;
+        }
+
+        if (op == OPERATION_CONDITIONAL) {
+            Operand b = pop();
+            Operand a = pop();
+            Operand condition = pop();
+            if (condition.kind != KIND_BOOLEAN) {
+                return unsupported(op);
+            }
+            std::string text = "(" + condition.text + " ? " + a.text + " : " + b.text + ")";
+            if (a.kind == b.kind && a.kind != KIND_VALUE) {
+                push(a.kind, "(" + condition.code + " ? " + a.code + " : " + b.code + ")", text);
+            } else {
+                push(KIND_VALUE, "(" + condition.code + " ? " + box(a) + " : " + box(b) + ")", text);
+            }
+            return true;
+        }
+
+        if (op == OPERATION_MATH_ABS) {
+            Operand a = pop();
+            std::string text = "Math.abs(" + a.text + ")";
+            if (a.kind == KIND_INT32) {
+                std::string value = temp(KIND_INT32, a.code);
+                push(KIND_INT32, "(" + value + " < 0 ? (int32_t)(0u - (uint32_t)" + value + ") : " + value + ")", text);
+            } else if (a.kind == KIND_FLOAT) {
+                push(KIND_FLOAT, "fabsf(" + a.code + ")", text);
+            } else if (a.kind == KIND_DOUBLE) {
+                push(KIND_DOUBLE, "fabs(" + a.code + ")", text);
+            } else {
+                return unsupported(op);
+            }
+            return true;
+        }
+
+        if (op == OPERATION_MATH_FLOOR || op == OPERATION_MATH_CEIL) {
+            Operand a = pop();
+            const char *func = op == OPERATION_MATH_FLOOR ? "floor" : "ceil";
+            std::string text = std::string("Math.") + func + "(" + a.text + ")";
+            if (a.kind == KIND_FLOAT) {
+                push(KIND_FLOAT, std::string(func) + "f(" + a.code + ")", text);
+            } else if (a.kind == KIND_DOUBLE) {
+                push(KIND_DOUBLE, std::string(func) + "(" + a.code + ")", text);
+            } else {
+                return unsupported(op);
+            }
+            return true;
+        }
+
+        if (op == OPERATION_MATH_ROUND) {
+            // number of arguments, value, number of decimal digits
+            Operand numArgs = pop();
+            if (!numArgs.isConstant || numArgs.constant < 1 || numArgs.constant > 2 ||
+                m_stack.size() < (size_t)numArgs.constant) {
+                return unsupported(op);
+            }
+            Operand a = pop();
+            int32_t digits = 0;
+            if (numArgs.constant == 2) {
+                Operand b = pop();
+                if (!b.isConstant || b.constant < 0 || b.constant > 9) {
+                    return unsupported(op);
+                }
+                digits = b.constant;
+            }
+
+            std::string text = "Math.round(" + a.text + (numArgs.constant == 2 ? ", " + std::to_string(digits) : "") + ")";
+            double scale = 1;
+            for (int32_t i = 0; i < digits; i++) {
+                scale *= 10;
+            }
+
+            if (a.kind == KIND_INT32) {
+                push(KIND_INT32, a.code, text);
+            } else if (a.kind == KIND_FLOAT) {
+                push(KIND_FLOAT, digits == 0 ? "roundf(" + a.code + ")" :
+                    "(roundf(" + a.code + " * " + formatFloat(scale, true) + ") / " + formatFloat(scale, true) + ")", text);
+            } else if (a.kind == KIND_DOUBLE) {
+                push(KIND_DOUBLE, digits == 0 ? "round(" + a.code + ")" :
+                    "(round(" + a.code + " * " + formatFloat(scale, false) + ") / " + formatFloat(scale, false) + ")", text);
+            } else {
+                return unsupported(op);
+            }
+            return true;
+        }
+
+        return unsupported(op);
+    }
+};
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <document.cpp> <document_expressions.cpp> [project.eez-project]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<uint8_t> nativeVariableTypes;
+    if (argc > 3 && !readNativeVariableTypes(argv[3], argv[1], nativeVariableTypes)) {
+        return 1;
+    }
+
+    std::string out;
+    out += "// Generated by Src/tools/flow_expr_gen from document.cpp, do not edit.\n\n";
+    out += "#include <math.h>\n#include <stdint.h>\n\n";
+    out += "#include \"eez-framework-conf.h\"\n\n";
+    out += "#if OPTION_COMPILED_EXPRESSIONS\n\n";
+    out += "#include \"flow/compiled_expressions.h\"\n\n";
+    out += "namespace eez {\nnamespace flow {\nnamespace compiled_expressions {\n\n";
+
+    // flows, and so indexes, aren't the same on both platforms
+    assets_file::Platform platforms[] = { assets_file::PLATFORM_STM32, assets_file::PLATFORM_SIMULATOR };
+    for (int i = 0; i < 2; i++) {
+        auto platform = platforms[i];
+
+        std::vector<uint8_t> compressed;
+        if (!assets_file::readDocument(argv[1], platform, compressed)) {
+            return 1;
+        }
+
+        std::vector<uint8_t> assets;
+        assets_file::Header header;
+        FlowDefinition flowDefinition;
+        if (!assets_file::decompress(compressed, header, assets) || !flow_assets::read(assets, flowDefinition)) {
+            return 1;
+        }
+
+        std::string functions;
+        std::string table;
+        std::map<std::string, std::string> functionsByBody; // same expression in several components
+        std::map<std::string, uint32_t> reasons;
+        uint32_t numCompiled = 0;
+        uint32_t numFunctions = 0;
+        uint32_t numWithOperations = 0;
+
+        printf("%s\n", assets_file::getPlatformName(platform));
+
+        for (auto &property : flowDefinition.properties) {
+            Compiler compiler(flowDefinition, nativeVariableTypes, property.flowIndex);
+            std::string body;
+            std::string text;
+            if (!compiler.compile(property.instructions, body, text)) {
+                if (compiler.error != "no operation") {
+                    numWithOperations++;
+                    reasons[compiler.error]++;
+                }
+                continue;
+            }
+            numWithOperations++;
+            numCompiled++;
+
+            char name[64];
+            auto it = functionsByBody.find(body);
+            if (it == functionsByBody.end()) {
+                snprintf(name, sizeof(name), "expression_%d_%d_%d", property.flowIndex, property.componentIndex, property.propertyIndex);
+                functionsByBody[body] = name;
+                numFunctions++;
+
+                functions += "// " + text + "\n";
+                functions += std::string("static bool ") + name + "(const Context &context, Value &result) {\n";
+                functions += body;
+                functions += "}\n\n";
+            } else {
+                snprintf(name, sizeof(name), "%s", it->second.c_str());
+            }
+
+            char line[160];
+            snprintf(line, sizeof(line), "    { 0x%08X, %s }, // flow %d, component %d, property %d\n",
+                // compiled_expressions::makeKey()
+                ((uint32_t)property.flowIndex << 24) | ((uint32_t)property.componentIndex << 8) | (uint32_t)property.propertyIndex,
+                name, property.flowIndex, property.componentIndex, property.propertyIndex);
+            table += line;
+
+            printf("  flow %d, component %d (type %u), property %d: %s\n", property.flowIndex, property.componentIndex,
+                property.componentType, property.propertyIndex, text.c_str());
+        }
+
+        printf("  %u of %u expressions with operations compiled, %u functions\n", numCompiled, numWithOperations, numFunctions);
+        for (auto &it : reasons) {
+            printf("  not compiled, %s: %u\n", it.first.c_str(), it.second);
+        }
+
+        out += i == 0 ? "#if defined(EEZ_PLATFORM_STM32)\n\n" : "#elif defined(EEZ_PLATFORM_SIMULATOR)\n\n";
+        out += functions;
+        out += "extern const uint32_t g_numExpressions = " + std::to_string(numCompiled) + ";\n\n";
+        out += "extern const Expression g_expressions[] = {\n";
+        out += numCompiled > 0 ? table : "    { 0xFFFFFFFF, nullptr }\n";
+        out += "};\n\n";
+    }
+
+    out += "#endif\n\n";
+    out += "} // namespace compiled_expressions\n} // namespace flow\n} // namespace eez\n\n";
+    out += "#endif // OPTION_COMPILED_EXPRESSIONS\n";
+
+    return assets_file::writeFile(argv[2], out.data(), out.size()) ? 0 : 1;
+}
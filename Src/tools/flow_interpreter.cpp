@@ -0,0 +1,312 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <set>
+#include <string>
+
+#include "flow_interpreter.h"
+
+using namespace eez;
+using namespace eez::flow::compiled_expressions;
+
+namespace flow_interpreter {
+
+static bool isNumber(const Value &value) {
+    return value.type == VALUE_TYPE_INT32 || value.type == VALUE_TYPE_FLOAT || value.type == VALUE_TYPE_DOUBLE;
+}
+
+// int32 < float < double
+static int getRank(const Value &value) {
+    return value.type == VALUE_TYPE_INT32 ? 0 : value.type == VALUE_TYPE_FLOAT ? 1 : 2;
+}
+
+static float toFloat(const Value &value) {
+    return value.type == VALUE_TYPE_INT32 ? (float)value.int32Value : value.floatValue;
+}
+
+static double toDouble(const Value &value) {
+    return value.type == VALUE_TYPE_INT32 ? (double)value.int32Value :
+        value.type == VALUE_TYPE_FLOAT ? (double)value.floatValue : value.doubleValue;
+}
+
+static bool isString(const Value &value) {
+    return value.type == VALUE_TYPE_STRING || value.type == VALUE_TYPE_STRING_ASSET;
+}
+
+static bool toString(const Value &value, std::string &text) {
+    char buffer[32];
+    if (isString(value)) {
+        text = value.strValue;
+    } else if (value.type == VALUE_TYPE_INT32) {
+        snprintf(buffer, sizeof(buffer), "%d", (int)value.int32Value);
+        text = buffer;
+    } else if (value.type == VALUE_TYPE_FLOAT || value.type == VALUE_TYPE_DOUBLE) {
+        snprintf(buffer, sizeof(buffer), "%g", toDouble(value));
+        text = buffer;
+    } else if (value.type == VALUE_TYPE_BOOLEAN) {
+        text = value.int32Value ? "true" : "false";
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// strings are interned instead of reference counted
+static Value makeString(const std::string &text) {
+    static std::set<std::string> g_strings;
+    Value value;
+    value.type = VALUE_TYPE_STRING;
+    value.strValue = g_strings.insert(text).first->c_str();
+    return value;
+}
+
+static Value makeBoolean(bool value) {
+    return Value(value ? 1 : 0, VALUE_TYPE_BOOLEAN);
+}
+
+template <typename T>
+static bool compare(int operation, T a, T b) {
+    switch (operation) {
+    case flow_assets::OPERATION_EQUAL: return a == b;
+    case flow_assets::OPERATION_NOT_EQUAL: return a != b;
+    case flow_assets::OPERATION_LESS: return a < b;
+    case flow_assets::OPERATION_GREATER: return a > b;
+    case flow_assets::OPERATION_LESS_OR_EQUAL: return a <= b;
+    default: return a >= b;
+    }
+}
+
+template <typename T>
+static bool arithmetic(int operation, T a, T b, T &result) {
+    switch (operation) {
+    case flow_assets::OPERATION_ADD: result = a + b; return true;
+    case flow_assets::OPERATION_SUB: result = a - b; return true;
+    case flow_assets::OPERATION_MUL: result = a * b; return true;
+    case flow_assets::OPERATION_DIV:
+        if (b == 0) {
+            return false;
+        }
+        result = a / b;
+        return true;
+    default: return false;
+    }
+}
+
+static bool operation(int op, Value *stack, int &sp) {
+    using namespace flow_assets;
+
+    bool isSupported = op <= OPERATION_MOD || (op >= OPERATION_EQUAL && op <= OPERATION_UNARY_MINUS) ||
+        op == OPERATION_NOT || op == OPERATION_CONDITIONAL || (op >= OPERATION_MATH_ABS && op <= OPERATION_MATH_ROUND);
+    if (!isSupported) {
+        return false;
+    }
+
+    if (op <= OPERATION_MOD) {
+        Value b = stack[--sp];
+        Value a = stack[--sp];
+        if (op == OPERATION_ADD && (isString(a) || isString(b))) {
+            std::string x;
+            std::string y;
+            if (!toString(a, x) || !toString(b, y)) {
+                return false;
+            }
+            stack[sp++] = makeString(x + y);
+            return true;
+        }
+        if (!isNumber(a) || !isNumber(b)) {
+            return false;
+        }
+        int rank = getRank(a) > getRank(b) ? getRank(a) : getRank(b);
+        if (rank == 0) {
+            uint32_t x = (uint32_t)a.int32Value;
+            uint32_t y = (uint32_t)b.int32Value;
+            int32_t result;
+            if (op == OPERATION_ADD) {
+                result = (int32_t)(x + y);
+            } else if (op == OPERATION_SUB) {
+                result = (int32_t)(x - y);
+            } else if (op == OPERATION_MUL) {
+                result = (int32_t)(x * y);
+            } else if (op == OPERATION_MOD && b.int32Value != 0 && b.int32Value != -1) {
+                result = a.int32Value % b.int32Value;
+            } else {
+                return false;
+            }
+            stack[sp++] = Value((int)result, VALUE_TYPE_INT32);
+        } else if (rank == 1) {
+            float result;
+            if (!arithmetic(op, toFloat(a), toFloat(b), result)) {
+                return false;
+            }
+            stack[sp++] = Value(result, UNIT_UNKNOWN);
+        } else {
+            double result;
+            if (!arithmetic(op, toDouble(a), toDouble(b), result)) {
+                return false;
+            }
+            stack[sp++] = Value(result, VALUE_TYPE_DOUBLE);
+        }
+        return true;
+    }
+
+    if (op >= OPERATION_EQUAL && op <= OPERATION_GREATER_OR_EQUAL) {
+        Value b = stack[--sp];
+        Value a = stack[--sp];
+        if (isNumber(a) && isNumber(b)) {
+            int rank = getRank(a) > getRank(b) ? getRank(a) : getRank(b);
+            bool result = rank == 0 ? compare(op, a.int32Value, b.int32Value) :
+                rank == 1 ? compare(op, toFloat(a), toFloat(b)) : compare(op, toDouble(a), toDouble(b));
+            stack[sp++] = makeBoolean(result);
+            return true;
+        }
+        if (a.type == VALUE_TYPE_BOOLEAN && b.type == VALUE_TYPE_BOOLEAN && op <= OPERATION_NOT_EQUAL) {
+            stack[sp++] = makeBoolean(compare(op, a.int32Value != 0, b.int32Value != 0));
+            return true;
+        }
+        return false;
+    }
+
+    if (op == OPERATION_LOGICAL_AND || op == OPERATION_LOGICAL_OR) {
+        Value b = stack[--sp];
+        Value a = stack[--sp];
+        if (a.type != VALUE_TYPE_BOOLEAN || b.type != VALUE_TYPE_BOOLEAN) {
+            return false;
+        }
+        stack[sp++] = makeBoolean(op == OPERATION_LOGICAL_AND ? a.int32Value && b.int32Value : a.int32Value || b.int32Value);
+        return true;
+    }
+
+    if (op == OPERATION_CONDITIONAL) {
+        Value b = stack[--sp];
+        Value a = stack[--sp];
+        Value condition = stack[--sp];
+        if (condition.type != VALUE_TYPE_BOOLEAN) {
+            return false;
+        }
+        stack[sp++] = condition.int32Value ? a : b;
+        return true;
+    }
+
+    if (op == OPERATION_NOT) {
+        Value &a = stack[sp - 1];
+        if (a.type != VALUE_TYPE_BOOLEAN) {
+            return false;
+        }
+        a = makeBoolean(!a.int32Value);
+        return true;
+    }
+
+    if (op == OPERATION_MATH_ROUND) {
+        Value numArgs = stack[--sp];
+        Value a = stack[--sp];
+        int digits = 0;
+        if (numArgs.int32Value == 2) {
+            digits = stack[--sp].int32Value;
+        }
+        double scale = pow(10, digits);
+        if (a.type == VALUE_TYPE_INT32) {
+            stack[sp++] = a;
+        } else if (a.type == VALUE_TYPE_FLOAT) {
+            stack[sp++] = Value(digits == 0 ? roundf(a.floatValue) : roundf(a.floatValue * (float)scale) / (float)scale, UNIT_UNKNOWN);
+        } else if (a.type == VALUE_TYPE_DOUBLE) {
+            stack[sp++] = Value(digits == 0 ? round(a.doubleValue) : round(a.doubleValue * scale) / scale, VALUE_TYPE_DOUBLE);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // unary
+    Value &a = stack[sp - 1];
+    if (!isNumber(a)) {
+        return false;
+    }
+    if (op == OPERATION_UNARY_PLUS) {
+        return true;
+    }
+    if (a.type == VALUE_TYPE_INT32) {
+        if (op == OPERATION_UNARY_MINUS || (op == OPERATION_MATH_ABS && a.int32Value < 0)) {
+            a.int32Value = (int32_t)(0u - (uint32_t)a.int32Value);
+        } else if (op != OPERATION_MATH_ABS) {
+            return false;
+        }
+    } else if (a.type == VALUE_TYPE_FLOAT) {
+        a.floatValue = op == OPERATION_UNARY_MINUS ? -a.floatValue :
+            op == OPERATION_MATH_ABS ? fabsf(a.floatValue) :
+            op == OPERATION_MATH_FLOOR ? floorf(a.floatValue) :
+            op == OPERATION_MATH_CEIL ? ceilf(a.floatValue) : NAN;
+    } else {
+        a.doubleValue = op == OPERATION_UNARY_MINUS ? -a.doubleValue :
+            op == OPERATION_MATH_ABS ? fabs(a.doubleValue) :
+            op == OPERATION_MATH_FLOOR ? floor(a.doubleValue) :
+            op == OPERATION_MATH_CEIL ? ceil(a.doubleValue) : NAN;
+    }
+    return true;
+}
+
+bool interpret(const std::vector<uint16_t> &instructions, const Context &context, uint32_t numGlobalVariables, Value &result) {
+    using namespace flow_assets;
+
+    Value stack[32];
+    int sp = 0;
+
+    for (uint16_t instruction : instructions) {
+        int arg = getInstructionArg(instruction);
+        switch (getInstructionType(instruction)) {
+        case INSTRUCTION_PUSH_CONSTANT:
+            stack[sp++] = getConstant(context, (uint16_t)arg);
+            break;
+        case INSTRUCTION_PUSH_LOCAL_VAR:
+            stack[sp++] = context.localVariables[arg];
+            break;
+        case INSTRUCTION_PUSH_GLOBAL_VAR:
+            if ((uint32_t)arg < numGlobalVariables) {
+                stack[sp++] = context.globalVariables[arg];
+            } else {
+                getNativeVariable((int16_t)(arg - numGlobalVariables + 1), stack[sp++]);
+            }
+            break;
+        case INSTRUCTION_OPERATION:
+            if (!operation(arg, stack, sp)) {
+                return false;
+            }
+            break;
+        case INSTRUCTION_END:
+            result = stack[0];
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    return false;
+}
+
+Value toValue(const flow_assets::AssetValue &assetValue) {
+    Value value;
+    value.type = assetValue.type;
+    value.doubleValue = assetValue.doubleValue;
+    if (assetValue.type == VALUE_TYPE_STRING_ASSET) {
+        value.strValue = assetValue.stringValue.c_str();
+    }
+    return value;
+}
+
+bool isSameValue(const Value &a, const Value &b) {
+    if (a.type != b.type) {
+        return false;
+    }
+    if (a.type == VALUE_TYPE_FLOAT) {
+        return a.floatValue == b.floatValue || (a.floatValue != a.floatValue && b.floatValue != b.floatValue);
+    }
+    if (a.type == VALUE_TYPE_DOUBLE) {
+        return a.doubleValue == b.doubleValue || (a.doubleValue != a.doubleValue && b.doubleValue != b.doubleValue);
+    }
+    if (isString(a)) {
+        return strcmp(a.strValue, b.strValue) == 0;
+    }
+    return a.int32Value == b.int32Value;
+}
+
+} // namespace flow_interpreter
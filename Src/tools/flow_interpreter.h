@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "flow_value_model.h"
+
+#include "flow/compiled_expressions.h"
+
+#include "flow_assets.h"
+
+// Expressions run on a value stack as eez-flow does, for the operations
+// which flow/compiled_expressions evaluates itself: arithmetic, comparison,
+// logical, ?: and Math.abs, floor, ceil and round on int, float, double and
+// boolean values, and + with a string. It has no operation table or reference counted values, so it is
+// faster than the real one. Constants and native variables come from
+// compiled_expressions::getConstant() and getNativeVariable(), defined by
+// the tool.
+
+namespace flow_interpreter {
+
+// False on any other operation and where eez-flow reports an error.
+bool interpret(const std::vector<uint16_t> &instructions, const eez::flow::compiled_expressions::Context &context,
+    uint32_t numGlobalVariables, eez::Value &result);
+
+eez::Value toValue(const flow_assets::AssetValue &assetValue);
+
+// same type and value, NaN is the same as NaN
+bool isSameValue(const eez::Value &a, const eez::Value &b);
+
+} // namespace flow_interpreter
@@ -0,0 +1,169 @@
+// Turns a flow profile dumped by flow/profiler.cpp (simulator file, or a
+// serial log with any other output around it) into folded stacks:
+//
+//   flow_profile_fold profile.txt [exclusive|wait|calls] > profile.folded
+//   flamegraph.pl profile.folded > profile.svg
+//
+// (wait: time the tasks of a component waited in the flow queue), or into
+// a table of component instances sorted by exclusive time:
+//
+//   flow_profile_fold profile.txt table
+//
+// A serial log holds a dump every FLOW_PROFILER_DUMP_INTERVAL_MS, the last
+// complete one is used. Frames are named flow:type#component, one frame
+// per nested component.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+struct Node {
+    int id;
+    int parent; // -1 for components started from the flow queue
+    int flowIndex;
+    int componentIndex;
+    std::string type;
+    uint32_t calls;
+    uint32_t inclusive;
+    uint32_t exclusive;
+    uint32_t maxInclusive;
+    uint32_t queuedCalls;
+    uint32_t queueWait;
+    uint32_t maxQueueWait;
+};
+
+static bool readProfile(const char *path, std::vector<Node> &nodes) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "can't open %s\n", path);
+        return false;
+    }
+
+    std::vector<Node> dump;
+    bool inDump = false;
+
+    char line[512];
+    while (fgets(line, sizeof(line), fp)) {
+        // serial log lines may have a prefix
+        const char *start = strstr(line, "# flow profile");
+        if (start) {
+            dump.clear();
+            inDump = true;
+            continue;
+        }
+
+        if (strstr(line, "# max depth")) {
+            if (inDump) {
+                nodes = dump;
+                inDump = false;
+            }
+            continue;
+        }
+
+        start = strstr(line, "node ");
+        if (!inDump || !start || strchr(line, '#')) {
+            continue;
+        }
+
+        Node node;
+        char parent[16];
+        char type[64];
+        if (sscanf(start, "node %d %15s %d %d %63s %u %u %u %u %u %u %u", &node.id, parent, &node.flowIndex,
+            &node.componentIndex, type, &node.calls, &node.inclusive, &node.exclusive,
+            &node.maxInclusive, &node.queuedCalls, &node.queueWait, &node.maxQueueWait) != 12 ||
+            node.id != (int)dump.size()) {
+            fprintf(stderr, "bad line: %s", line);
+            inDump = false;
+            continue;
+        }
+        node.parent = strcmp(parent, "-") == 0 ? -1 : atoi(parent);
+        node.type = type;
+        dump.push_back(node);
+    }
+
+    fclose(fp);
+
+    if (nodes.empty()) {
+        fprintf(stderr, "no complete profile in %s\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+static std::string getFrameName(const Node &node) {
+    char name[128];
+    snprintf(name, sizeof(name), "flow%d:%s#%d", node.flowIndex, node.type.c_str(), node.componentIndex);
+    return name;
+}
+
+static std::string getStack(const std::vector<Node> &nodes, const Node &node) {
+    std::string stack = getFrameName(node);
+    for (int parent = node.parent; parent >= 0 && parent < (int)nodes.size(); parent = nodes[parent].parent) {
+        stack = getFrameName(nodes[parent]) + ";" + stack;
+    }
+    return stack;
+}
+
+static void printTable(const std::vector<Node> &nodes) {
+    std::vector<const Node *> sorted;
+    uint64_t totalExclusive = 0;
+    for (auto &node : nodes) {
+        sorted.push_back(&node);
+        totalExclusive += node.exclusive;
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Node *a, const Node *b) {
+        return a->exclusive > b->exclusive;
+    });
+
+    printf("%-48s %8s %10s %10s %6s %8s %8s %10s %10s\n", "component", "calls", "incl us", "excl us", "excl %",
+        "avg us", "max us", "avg wait", "max wait");
+    for (auto node : sorted) {
+        printf("%-48s %8u %10u %10u %5.1f%% %8.1f %8u %10.1f %10u\n", getFrameName(*node).c_str(), node->calls,
+            node->inclusive, node->exclusive,
+            totalExclusive > 0 ? 100.0 * node->exclusive / totalExclusive : 0.0,
+            node->calls > 0 ? (double)node->inclusive / node->calls : 0.0,
+            node->maxInclusive,
+            node->queuedCalls > 0 ? (double)node->queueWait / node->queuedCalls : 0.0,
+            node->maxQueueWait);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <profile> [exclusive|wait|calls|table]\n", argv[0]);
+        return 1;
+    }
+
+    const char *mode = argc > 2 ? argv[2] : "exclusive";
+    if (strcmp(mode, "exclusive") != 0 && strcmp(mode, "wait") != 0 && strcmp(mode, "calls") != 0 &&
+        strcmp(mode, "table") != 0) {
+        fprintf(stderr, "unknown mode %s\n", mode);
+        return 1;
+    }
+
+    std::vector<Node> nodes;
+    if (!readProfile(argv[1], nodes)) {
+        return 1;
+    }
+
+    if (strcmp(mode, "table") == 0) {
+        printTable(nodes);
+        return 0;
+    }
+
+    for (auto &node : nodes) {
+        uint32_t value = strcmp(mode, "calls") == 0 ? node.calls :
+            strcmp(mode, "wait") == 0 ? node.queueWait : node.exclusive;
+        // flamegraph.pl sums the nested frames for the inclusive width
+        if (value > 0) {
+            printf("%s %u\n", getStack(nodes, node).c_str(), value);
+        }
+    }
+
+    return 0;
+}
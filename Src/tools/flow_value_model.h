@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+// eez::Value for the tools which run flow/ code on host without
+// eez-framework: the same 16-byte layout, and the constructors and fields
+// the code uses. Include it before the flow/ headers.
+
+#define FLOW_VALUE_MODEL
+
+namespace eez {
+
+enum ValueType {
+    VALUE_TYPE_UNDEFINED,
+    VALUE_TYPE_NULL,
+    VALUE_TYPE_BOOLEAN,
+    VALUE_TYPE_INT8,
+    VALUE_TYPE_UINT8,
+    VALUE_TYPE_INT16,
+    VALUE_TYPE_UINT16,
+    VALUE_TYPE_INT32,
+    VALUE_TYPE_UINT32,
+    VALUE_TYPE_INT64,
+    VALUE_TYPE_UINT64,
+    VALUE_TYPE_FLOAT,
+    VALUE_TYPE_DOUBLE,
+    VALUE_TYPE_STRING,
+    VALUE_TYPE_STRING_ASSET
+};
+
+enum Unit {
+    UNIT_UNKNOWN
+};
+
+struct Value {
+    Value() : type(VALUE_TYPE_UNDEFINED), unit(UNIT_UNKNOWN), options(0), reserved(0) {
+        doubleValue = 0;
+    }
+
+    Value(int value, ValueType type_) : type((uint8_t)type_), unit(UNIT_UNKNOWN), options(0), reserved(0) {
+        doubleValue = 0;
+        int32Value = value;
+    }
+
+    Value(float value, Unit unit_) : type(VALUE_TYPE_FLOAT), unit((uint8_t)unit_), options(0), reserved(0) {
+        doubleValue = 0;
+        floatValue = value;
+    }
+
+    Value(double value, ValueType type_) : type((uint8_t)type_), unit(UNIT_UNKNOWN), options(0), reserved(0) {
+        doubleValue = value;
+    }
+
+    uint8_t type;
+    uint8_t unit;
+    uint16_t options;
+    uint32_t reserved;
+    union {
+        int32_t int32Value;
+        float floatValue;
+        double doubleValue;
+        const char *strValue;
+    };
+};
+
+} // namespace eez
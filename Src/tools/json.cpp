@@ -0,0 +1,279 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json.h"
+
+namespace json {
+
+const Value *Value::get(const char *key) const {
+    for (auto &member : members) {
+        if (member.first == key) {
+            return &member.second;
+        }
+    }
+    return nullptr;
+}
+
+Value *Value::get(const char *key) {
+    for (auto &member : members) {
+        if (member.first == key) {
+            return &member.second;
+        }
+    }
+    return nullptr;
+}
+
+std::string Value::str() const {
+    return type == TYPE_STRING ? unescape(raw) : std::string();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct Parser {
+    const std::string &text;
+    size_t pos;
+
+    void skipWhitespace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+            pos++;
+        }
+    }
+
+    bool parseString(std::string &raw) {
+        // pos is at the opening quote
+        size_t start = ++pos;
+        while (pos < text.size() && text[pos] != '"') {
+            pos += text[pos] == '\\' ? 2 : 1;
+        }
+        if (pos >= text.size()) {
+            return false;
+        }
+        raw.assign(text, start, pos - start);
+        pos++;
+        return true;
+    }
+
+    bool parseLiteral(Value &value) {
+        size_t start = pos;
+        while (pos < text.size() && strchr(",]} \t\r\n", text[pos]) == nullptr) {
+            pos++;
+        }
+        value.raw.assign(text, start, pos - start);
+        if (value.raw == "null") {
+            value.type = TYPE_NULL;
+        } else if (value.raw == "true" || value.raw == "false") {
+            value.type = TYPE_BOOLEAN;
+        } else if (!value.raw.empty() && strchr("-0123456789", value.raw[0])) {
+            value.type = TYPE_NUMBER;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    bool parseValue(Value &value) {
+        skipWhitespace();
+        if (pos >= text.size()) {
+            return false;
+        }
+
+        char ch = text[pos];
+
+        if (ch == '"') {
+            value.type = TYPE_STRING;
+            return parseString(value.raw);
+        }
+
+        if (ch == '[') {
+            value.type = TYPE_ARRAY;
+            pos++;
+            skipWhitespace();
+            if (pos < text.size() && text[pos] == ']') {
+                pos++;
+                return true;
+            }
+            while (true) {
+                value.items.emplace_back();
+                if (!parseValue(value.items.back())) {
+                    return false;
+                }
+                skipWhitespace();
+                if (pos < text.size() && text[pos] == ',') {
+                    pos++;
+                } else if (pos < text.size() && text[pos] == ']') {
+                    pos++;
+                    return true;
+                } else {
+                    return false;
+                }
+            }
+        }
+
+        if (ch == '{') {
+            value.type = TYPE_OBJECT;
+            pos++;
+            skipWhitespace();
+            if (pos < text.size() && text[pos] == '}') {
+                pos++;
+                return true;
+            }
+            while (true) {
+                skipWhitespace();
+                value.members.emplace_back();
+                auto &member = value.members.back();
+                if (pos >= text.size() || text[pos] != '"' || !parseString(member.first)) {
+                    return false;
+                }
+                skipWhitespace();
+                if (pos >= text.size() || text[pos] != ':') {
+                    return false;
+                }
+                pos++;
+                if (!parseValue(member.second)) {
+                    return false;
+                }
+                skipWhitespace();
+                if (pos < text.size() && text[pos] == ',') {
+                    pos++;
+                } else if (pos < text.size() && text[pos] == '}') {
+                    pos++;
+                    return true;
+                } else {
+                    return false;
+                }
+            }
+        }
+
+        return parseLiteral(value);
+    }
+};
+
+bool parse(const std::string &text, Value &value) {
+    Parser parser{ text, 0 };
+    if (!parser.parseValue(value)) {
+        fprintf(stderr, "JSON syntax error at %u\n", (unsigned)parser.pos);
+        return false;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void write(std::string &out, const Value &value, int indent) {
+    switch (value.type) {
+    case TYPE_STRING:
+        out += '"';
+        out += value.raw;
+        out += '"';
+        break;
+
+    case TYPE_ARRAY:
+        if (value.items.empty()) {
+            out += "[]";
+            break;
+        }
+        out += "[\n";
+        for (size_t i = 0; i < value.items.size(); i++) {
+            out.append(indent + 2, ' ');
+            write(out, value.items[i], indent + 2);
+            out += i + 1 < value.items.size() ? ",\n" : "\n";
+        }
+        out.append(indent, ' ');
+        out += ']';
+        break;
+
+    case TYPE_OBJECT:
+        if (value.members.empty()) {
+            out += "{}";
+            break;
+        }
+        out += "{\n";
+        for (size_t i = 0; i < value.members.size(); i++) {
+            out.append(indent + 2, ' ');
+            out += '"';
+            out += value.members[i].first;
+            out += "\": ";
+            write(out, value.members[i].second, indent + 2);
+            out += i + 1 < value.members.size() ? ",\n" : "\n";
+        }
+        out.append(indent, ' ');
+        out += '}';
+        break;
+
+    default:
+        out += value.raw;
+        break;
+    }
+}
+
+std::string write(const Value &value) {
+    std::string out;
+    write(out, value, 0);
+    return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void appendUtf8(std::string &out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out += (char)codePoint;
+    } else if (codePoint < 0x800) {
+        out += (char)(0xC0 | (codePoint >> 6));
+        out += (char)(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        out += (char)(0xE0 | (codePoint >> 12));
+        out += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        out += (char)(0x80 | (codePoint & 0x3F));
+    } else {
+        out += (char)(0xF0 | (codePoint >> 18));
+        out += (char)(0x80 | ((codePoint >> 12) & 0x3F));
+        out += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+        out += (char)(0x80 | (codePoint & 0x3F));
+    }
+}
+
+std::string unescape(const std::string &raw) {
+    std::string out;
+    for (size_t i = 0; i < raw.size(); i++) {
+        if (raw[i] != '\\' || i + 1 >= raw.size()) {
+            out += raw[i];
+            continue;
+        }
+
+        char ch = raw[++i];
+        switch (ch) {
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'u': {
+            uint32_t codePoint = i + 4 < raw.size() ? (uint32_t)strtoul(raw.substr(i + 1, 4).c_str(), nullptr, 16) : 0;
+            i += 4;
+            if (codePoint >= 0xD800 && codePoint < 0xDC00 && i + 6 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u') {
+                uint32_t low = (uint32_t)strtoul(raw.substr(i + 3, 4).c_str(), nullptr, 16);
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                i += 6;
+            }
+            appendUtf8(out, codePoint);
+            break;
+        }
+        default: out += ch; break;
+        }
+    }
+    return out;
+}
+
+uint32_t decodeUtf8(const std::string &text, size_t &i) {
+    uint8_t ch = (uint8_t)text[i++];
+    int extra = ch >= 0xF0 ? 3 : ch >= 0xE0 ? 2 : ch >= 0xC0 ? 1 : 0;
+    uint32_t codePoint = extra == 0 ? ch : ch & (0x3F >> extra);
+    for (int j = 0; j < extra && i < text.size(); j++) {
+        codePoint = (codePoint << 6) | ((uint8_t)text[i++] & 0x3F);
+    }
+    return codePoint;
+}
+
+} // namespace json
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal JSON DOM for the tools that read and rewrite EEZ Studio project
+// files. Numbers and strings are kept as they are in the file (raw), so a
+// value written back is byte identical to what was read, and write() uses
+// the same layout as JSON.stringify(value, null, 2) which Studio uses for
+// .eez-project files.
+
+namespace json {
+
+enum Type {
+    TYPE_NULL,
+    TYPE_BOOLEAN,
+    TYPE_NUMBER,
+    TYPE_STRING,
+    TYPE_ARRAY,
+    TYPE_OBJECT
+};
+
+struct Value {
+    Type type = TYPE_NULL;
+
+    // literal for null, boolean and number, contents between the quotes
+    // (still escaped) for string
+    std::string raw;
+
+    std::vector<Value> items;
+    std::vector<std::pair<std::string, Value>> members; // key is raw
+
+    bool isString() const { return type == TYPE_STRING; }
+    bool isArray() const { return type == TYPE_ARRAY; }
+    bool isObject() const { return type == TYPE_OBJECT; }
+
+    // member with the given key or nullptr
+    const Value *get(const char *key) const;
+    Value *get(const char *key);
+
+    // unescaped UTF-8 string, empty if not a string
+    std::string str() const;
+    bool isTrue() const { return type == TYPE_BOOLEAN && raw == "true"; }
+};
+
+bool parse(const std::string &text, Value &value);
+
+std::string write(const Value &value);
+
+// JSON string escapes (\n, \", \uXXXX, ...) to UTF-8
+std::string unescape(const std::string &raw);
+
+// decode one UTF-8 code point, advances i
+uint32_t decodeUtf8(const std::string &text, size_t &i);
+
+} // namespace json
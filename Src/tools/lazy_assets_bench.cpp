@@ -0,0 +1,189 @@
+// Compares boot-to-first-frame cost of decompressing the whole assets blob
+// with block compressed, demand paged assets (gui/lazy_assets.h), using the
+// real demo assets from gui/document.cpp. First frame is approximated by
+// reading the main page widget tree, the styles it uses and all glyphs of
+// the fonts referenced by those styles. With demand paging the assets are
+// then loaded again and the previous ones read while they are retired.
+//
+//   lazy_assets_bench ../../gui/document.cpp [stm32|simulator] [blockSize] [codec]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "assets_file.h"
+#include "gui/assets_codec.h"
+#include "gui/lazy_assets.h"
+
+using namespace eez::gui;
+
+// Minimal reader of the decompressed assets layout, offsets from settings.
+struct AssetsReader {
+    const uint8_t *data;
+    uint32_t checksum;
+
+    uint32_t u32(uint32_t offset) {
+        uint32_t value;
+        memcpy(&value, data + offset, 4);
+        return value;
+    }
+
+    uint32_t ptr(uint32_t offset) {
+        uint32_t value = u32(offset);
+        return value ? offset + value : 0;
+    }
+
+    uint32_t listCount(uint32_t offset) {
+        return u32(offset);
+    }
+
+    uint32_t listItem(uint32_t offset, uint32_t index) {
+        return ptr(ptr(offset + 4) + 4 * index);
+    }
+
+    void touch(uint32_t offset, uint32_t size) {
+        for (uint32_t i = 0; i < size; i++) {
+            checksum += data[offset + i];
+        }
+    }
+
+    void walkWidget(uint32_t widget, std::vector<bool> &stylesUsed) {
+        touch(widget, 20);
+
+        uint16_t type = data[widget] | (data[widget + 1] << 8);
+        int16_t style = (int16_t)(data[widget + 16] | (data[widget + 17] << 8));
+        if (style > 0 && (uint32_t)style <= stylesUsed.size()) {
+            stylesUsed[style - 1] = true;
+        }
+
+        if (type == 1) {
+            // container
+            uint32_t n = listCount(widget + 28);
+            for (uint32_t i = 0; i < n; i++) {
+                walkWidget(listItem(widget + 28, i), stylesUsed);
+            }
+        }
+    }
+
+    void firstFrame() {
+        touch(ptr(0), 4); // settings
+
+        std::vector<bool> stylesUsed(listCount(12));
+        walkWidget(listItem(4, 0), stylesUsed);
+
+        std::vector<bool> fontsUsed(listCount(20));
+        for (uint32_t i = 0; i < stylesUsed.size(); i++) {
+            if (stylesUsed[i]) {
+                uint32_t style = listItem(12, i);
+                touch(style, 36);
+                uint8_t font = data[style + 28];
+                if (font > 0 && font <= fontsUsed.size()) {
+                    fontsUsed[font - 1] = true;
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < fontsUsed.size(); i++) {
+            if (fontsUsed[i]) {
+                uint32_t font = listItem(20, i);
+                touch(font, 28);
+                uint32_t n = listCount(font + 20);
+                for (uint32_t j = 0; j < n; j++) {
+                    uint32_t glyph = listItem(font + 20, j);
+                    if (glyph) {
+                        touch(glyph, 8 + data[glyph + 1] * data[glyph + 2]);
+                    }
+                }
+            }
+        }
+    }
+};
+
+static double ms(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <document.cpp> [stm32|simulator] [blockSize] [stored|lz4|lzr|auto]\n", argv[0]);
+        return 1;
+    }
+
+    auto platform = argc > 2 && strcmp(argv[2], "simulator") == 0 ? assets_file::PLATFORM_SIMULATOR : assets_file::PLATFORM_STM32;
+    uint32_t blockSize = argc > 3 ? (uint32_t)atoi(argv[3]) : 8192;
+    int codec = argc > 4 ? assets_file::parseCodec(argv[4]) : assets_codec::CODEC_LZ4;
+    if (codec < assets_file::CODEC_AUTO) {
+        fprintf(stderr, "unknown codec %s\n", argv[4]);
+        return 1;
+    }
+
+    std::vector<uint8_t> compressed;
+    assets_file::Header header;
+    std::vector<uint8_t> decompressed;
+    if (!assets_file::readDocument(argv[1], platform, compressed) || !assets_file::decompress(compressed, header, decompressed)) {
+        return 1;
+    }
+
+    // whole blob, as loadMainAssets() does today
+    std::vector<uint8_t> full(decompressed.size());
+    static const int NUM_ITERATIONS = 20;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < NUM_ITERATIONS; i++) {
+        assets_codec::lz4Decompress(compressed.data() + sizeof(header), (int)(compressed.size() - sizeof(header)), full.data(), (int)full.size());
+    }
+    double fullTime = ms(start) / NUM_ITERATIONS;
+
+    AssetsReader reader = { full.data(), 0 };
+    reader.firstFrame();
+    uint32_t expectedChecksum = reader.checksum;
+
+    std::vector<uint8_t> image;
+    assets_file::buildLazyImage(header, decompressed, blockSize, codec, image);
+
+    start = std::chrono::high_resolution_clock::now();
+    auto assets = (uint8_t *)lazy_assets::load(image.data(), (uint32_t)image.size(), nullptr, 0);
+    if (!assets) {
+        fprintf(stderr, "lazy assets load failed\n");
+        return 1;
+    }
+    double loadTime = ms(start);
+
+    reader = { assets + lazy_assets::ASSETS_PREFIX_SIZE, 0 };
+    start = std::chrono::high_resolution_clock::now();
+    reader.firstFrame();
+    double firstFrameTime = ms(start);
+    uint32_t firstFrameBlocks = lazy_assets::g_stats.residentBlocks;
+
+    bool identical = reader.checksum == expectedChecksum;
+
+    if (lazy_assets::isDemandPaging()) {
+        // assets switched, the blocks read from the previous ones stay
+        // readable until its region is released
+        auto newAssets = (uint8_t *)lazy_assets::load(image.data(), (uint32_t)image.size(), nullptr, 0);
+        reader = { assets + lazy_assets::ASSETS_PREFIX_SIZE, 0 };
+        reader.firstFrame();
+        identical = identical && newAssets && reader.checksum == expectedChecksum;
+        lazy_assets::releaseRetired();
+        lazy_assets::releaseRetired();
+        assets = newAssets;
+    }
+
+    identical = identical && assets &&
+        memcmp(assets + lazy_assets::ASSETS_PREFIX_SIZE, decompressed.data(), decompressed.size()) == 0;
+
+    printf("%s, block size %u, codec %s, demand paging: %s\n", assets_file::getPlatformName(platform), blockSize,
+        codec == assets_file::CODEC_AUTO ? "auto" : assets_codec::getCodecName(codec),
+        lazy_assets::isDemandPaging() ? "yes" : "no");
+    printf("  size:        compressed %u, block compressed %u, decompressed %u\n",
+        (unsigned)compressed.size(), (unsigned)image.size(), (unsigned)decompressed.size());
+    printf("  whole blob:  %8.3f ms, resident %8u KB\n", fullTime, (unsigned)(decompressed.size() / 1024));
+    printf("  lazy:        %8.3f ms (load %.3f ms + first frame %.3f ms), resident %8u KB, %u of %u blocks\n",
+        loadTime + firstFrameTime, loadTime, firstFrameTime,
+        (unsigned)(firstFrameBlocks * blockSize / 1024), firstFrameBlocks, lazy_assets::g_stats.numBlocks);
+    printf("  %s\n", identical ? "identical" : "MISMATCH");
+
+    return identical ? 0 : 1;
+}
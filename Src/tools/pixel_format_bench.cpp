@@ -0,0 +1,105 @@
+// Compares RGB565 and ARGB8888 instantiations of the drawing kernels from
+// gui/pixel_format.h on a full frame sized buffer.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <vector>
+
+#include "eez-framework-conf.h"
+#include "gui/pixel_format.h"
+
+using namespace eez::gui;
+
+static const int WIDTH = DISPLAY_WIDTH;
+static const int HEIGHT = DISPLAY_HEIGHT;
+
+static const int GLYPH_WIDTH = 24;
+static const int GLYPH_HEIGHT = 40;
+
+// glyphs() covers only whole glyphs, e.g. 984x680 of 1000x680
+static const int GLYPH_PIXELS = (WIDTH / GLYPH_WIDTH * GLYPH_WIDTH) * (HEIGHT / GLYPH_HEIGHT * GLYPH_HEIGHT);
+
+template <typename Format>
+struct Bench {
+    typedef typename Format::Pixel Pixel;
+
+    std::vector<Pixel> buffer;
+    std::vector<Pixel> source;
+    std::vector<uint8_t> argbSource;
+    std::vector<uint8_t> mask;
+
+    Bench() : buffer(WIDTH * HEIGHT), source(WIDTH * HEIGHT), argbSource(WIDTH * HEIGHT * 4), mask(GLYPH_WIDTH * GLYPH_HEIGHT) {
+        for (size_t i = 0; i < source.size(); i++) {
+            source[i] = (Pixel)(i * 2654435761u);
+        }
+        for (size_t i = 0; i < argbSource.size(); i++) {
+            argbSource[i] = (uint8_t)(i * 13);
+        }
+        for (size_t i = 0; i < mask.size(); i++) {
+            mask[i] = (uint8_t)(i * 37);
+        }
+    }
+
+    void fill() {
+        pixel_format::fillRect<Format>(buffer.data(), WIDTH, 0, 0, WIDTH - 1, HEIGHT - 1, 0x1234, 255);
+    }
+
+    void blend() {
+        pixel_format::fillRect<Format>(buffer.data(), WIDTH, 0, 0, WIDTH - 1, HEIGHT - 1, 0x4321, 128);
+    }
+
+    void blit() {
+        pixel_format::blit<Format, Format>(buffer.data(), WIDTH, source.data(), WIDTH, WIDTH, HEIGHT);
+    }
+
+    void blitBlend() {
+        pixel_format::blitBlend<Format>(buffer.data(), WIDTH, argbSource.data(), WIDTH, WIDTH, HEIGHT);
+    }
+
+    void glyphs() {
+        for (int y = 0; y + GLYPH_HEIGHT <= HEIGHT; y += GLYPH_HEIGHT) {
+            for (int x = 0; x + GLYPH_WIDTH <= WIDTH; x += GLYPH_WIDTH) {
+                pixel_format::drawMask<Format>(buffer.data() + y * WIDTH + x, WIDTH, mask.data(), GLYPH_WIDTH, GLYPH_WIDTH, GLYPH_HEIGHT, 0xFFFF, 255);
+            }
+        }
+    }
+};
+
+// pixels drawn per second, numPixels by one call of func
+template <typename Format, typename Func>
+static double measure(Bench<Format> &bench, Func func, int numIterations, int numPixels = WIDTH * HEIGHT) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numIterations; i++) {
+        (bench.*func)();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return (double)numPixels * numIterations / seconds / 1e6;
+}
+
+template <typename Format>
+static void run(const char *name, int numIterations) {
+    Bench<Format> bench;
+
+    printf("%-10s %10.1f %10.1f %10.1f %10.1f %10.1f\n", name,
+        measure(bench, &Bench<Format>::fill, numIterations),
+        measure(bench, &Bench<Format>::blend, numIterations),
+        measure(bench, &Bench<Format>::blit, numIterations),
+        measure(bench, &Bench<Format>::blitBlend, numIterations),
+        measure(bench, &Bench<Format>::glyphs, numIterations, GLYPH_PIXELS));
+}
+
+int main(int argc, char **argv) {
+    int numIterations = argc > 1 ? atoi(argv[1]) : 100;
+
+    printf("%dx%d, %d iterations, MPixels/s\n", WIDTH, HEIGHT, numIterations);
+    printf("%-10s %10s %10s %10s %10s %10s\n", "format", "fill", "blend", "blit", "blitBlend", "glyph");
+
+    run<pixel_format::Rgb565>("RGB565", numIterations);
+    run<pixel_format::Argb8888>("ARGB8888", numIterations);
+
+    return 0;
+}
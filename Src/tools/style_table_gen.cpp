@@ -0,0 +1,319 @@
+// Generates gui/document_styles.cpp with styles from gui/document.cpp
+// resolved for every theme (see gui/style_table.h). Run it after EEZ Studio
+// build when OPTION_STYLE_TABLE is enabled:
+//
+//   style_table_gen ../../gui/document.cpp ../../gui/document_styles.cpp
+//
+// Also times getting the background color of a style from the generated
+// table and through the style and theme lists in assets.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "eez-framework-conf.h"
+#include "gui/pixel_format.h"
+#include "gui/style_table.h"
+
+#include "assets_file.h"
+
+using namespace eez::gui;
+
+static const uint16_t COLOR_ID_TRANSPARENT = 65535;
+
+struct Assets {
+    std::vector<uint8_t> data;
+
+    uint32_t u32(uint32_t offset) const {
+        uint32_t value;
+        memcpy(&value, data.data() + offset, 4);
+        return value;
+    }
+
+    uint16_t u16(uint32_t offset) const {
+        return (uint16_t)(data[offset] | (data[offset + 1] << 8));
+    }
+
+    uint32_t ptr(uint32_t offset) const {
+        uint32_t value = u32(offset);
+        return value ? offset + value : 0;
+    }
+
+    uint32_t listCount(uint32_t offset) const {
+        return u32(offset);
+    }
+
+    uint32_t listItem(uint32_t offset, uint32_t index) const {
+        return ptr(ptr(offset + 4) + 4 * index);
+    }
+
+    // colors: themes list, colors list; Theme: name, colors list, colors
+    // are RGB565. Index below number of theme colors is theme color,
+    // otherwise project color.
+    bool getColor(uint32_t themeIndex, uint16_t index, uint16_t &color) const {
+        uint32_t colors = ptr(36);
+        uint32_t theme = listItem(colors, themeIndex);
+        uint32_t numThemeColors = listCount(theme + 4);
+        if (index < numThemeColors) {
+            color = u16(ptr(theme + 8) + 2 * index);
+            return true;
+        }
+        index -= numThemeColors;
+        if (index < listCount(colors + 8)) {
+            color = u16(ptr(colors + 12) + 2 * index);
+            return true;
+        }
+        return false;
+    }
+};
+
+// Style: flags, backgroundColor, color, activeBackgroundColor, activeColor,
+// focusBackgroundColor, focusColor (uint16_t), borderSizeTop, Right,
+// Bottom, Left, borderColor (uint16_t), borderRadius[8], font, opacity,
+// paddingTop, Right, Bottom, Left, backgroundImage (int16_t)
+struct ResolvedStyle {
+    uint16_t colors[7]; // RGB565, in FlatStyle order
+    uint8_t transparent;
+    uint16_t flags;
+    int16_t backgroundImage;
+    uint8_t borderSize[4];
+    uint8_t borderRadius[8];
+    uint8_t font;
+    uint8_t opacity;
+    uint8_t padding[4];
+};
+
+static void resolveStyle(const Assets &assets, uint32_t style, uint32_t themeIndex, ResolvedStyle &resolved) {
+    static const uint32_t COLOR_OFFSETS[7] = { 2, 4, 6, 8, 10, 12, 18 };
+
+    resolved.transparent = 0;
+    for (int i = 0; i < 7; i++) {
+        uint16_t index = assets.u16(style + COLOR_OFFSETS[i]);
+        resolved.colors[i] = 0;
+        if (index == COLOR_ID_TRANSPARENT || !assets.getColor(themeIndex, index, resolved.colors[i])) {
+            resolved.transparent |= 1 << i;
+        }
+    }
+
+    resolved.flags = assets.u16(style);
+    memcpy(resolved.borderSize, assets.data.data() + style + 14, 4);
+    memcpy(resolved.borderRadius, assets.data.data() + style + 20, 8);
+    resolved.font = assets.data[style + 28];
+    resolved.opacity = assets.data[style + 29];
+    memcpy(resolved.padding, assets.data.data() + style + 30, 4);
+    resolved.backgroundImage = (int16_t)assets.u16(style + 34);
+}
+
+static void toFlatStyle(const ResolvedStyle &resolved, style_table::FlatStyle &flat) {
+    style_table::NativeColor *colors[7] = {
+        &flat.backgroundColor, &flat.color, &flat.activeBackgroundColor, &flat.activeColor,
+        &flat.focusBackgroundColor, &flat.focusColor, &flat.borderColor
+    };
+    for (int i = 0; i < 7; i++) {
+        *colors[i] = style_table::NativeFormat::fromColor16(resolved.colors[i]);
+    }
+    flat.flags = resolved.flags;
+    flat.backgroundImage = resolved.backgroundImage;
+    flat.borderSizeTop = resolved.borderSize[0];
+    flat.borderSizeRight = resolved.borderSize[1];
+    flat.borderSizeBottom = resolved.borderSize[2];
+    flat.borderSizeLeft = resolved.borderSize[3];
+    memcpy(flat.borderRadius, resolved.borderRadius, 8);
+    flat.font = resolved.font;
+    flat.opacity = resolved.opacity;
+    flat.transparent = resolved.transparent;
+    flat.reserved = 0;
+    flat.paddingTop = resolved.padding[0];
+    flat.paddingRight = resolved.padding[1];
+    flat.paddingBottom = resolved.padding[2];
+    flat.paddingLeft = resolved.padding[3];
+}
+
+static std::string formatStyle(const ResolvedStyle &resolved, assets_file::Platform platform) {
+    char buffer[256];
+    std::string out = "    { ";
+    for (int i = 0; i < 7; i++) {
+        if (platform == assets_file::PLATFORM_STM32) {
+            snprintf(buffer, sizeof(buffer), "0x%04X, ", resolved.colors[i]);
+        } else {
+            snprintf(buffer, sizeof(buffer), "0x%08X, ", pixel_format::Argb8888::fromColor16(resolved.colors[i]));
+        }
+        out += buffer;
+    }
+    snprintf(buffer, sizeof(buffer),
+        "0x%04X, %d, %u, %u, %u, %u, { %u, %u, %u, %u, %u, %u, %u, %u }, %u, %u, 0x%02X, 0, %u, %u, %u, %u }",
+        resolved.flags, resolved.backgroundImage,
+        resolved.borderSize[0], resolved.borderSize[1], resolved.borderSize[2], resolved.borderSize[3],
+        resolved.borderRadius[0], resolved.borderRadius[1], resolved.borderRadius[2], resolved.borderRadius[3],
+        resolved.borderRadius[4], resolved.borderRadius[5], resolved.borderRadius[6], resolved.borderRadius[7],
+        resolved.font, resolved.opacity, resolved.transparent,
+        resolved.padding[0], resolved.padding[1], resolved.padding[2], resolved.padding[3]);
+    out += buffer;
+    return out;
+}
+
+// STYLE_ID_ names from document.h next to document.cpp
+static void readStyleNames(const char *documentPath, assets_file::Platform platform, std::map<uint32_t, std::string> &names) {
+    std::string path = documentPath;
+    size_t dot = path.rfind('.');
+    if (dot == std::string::npos) {
+        return;
+    }
+    path = path.substr(0, dot) + ".h";
+
+    // names are optional, don't let readFile() complain
+    FILE *fp = fopen(path.c_str(), "rb");
+    if (!fp) {
+        return;
+    }
+    fclose(fp);
+
+    std::vector<uint8_t> file;
+    if (!assets_file::readFile(path.c_str(), file)) {
+        return;
+    }
+    std::string text(file.begin(), file.end());
+
+    size_t begin = text.find(std::string("defined(EEZ_PLATFORM_") + assets_file::getPlatformName(platform) + ")");
+    size_t end = begin == std::string::npos ? std::string::npos : text.find("#endif", begin);
+    for (size_t pos = text.find("STYLE_ID_", begin); pos != std::string::npos && pos < end; pos = text.find("STYLE_ID_", pos + 1)) {
+        size_t nameEnd = text.find_first_of(" =", pos);
+        size_t equals = text.find('=', pos);
+        if (nameEnd == std::string::npos || equals == std::string::npos) {
+            break;
+        }
+        names[(uint32_t)atoi(text.c_str() + equals + 1)] = text.substr(pos, nameEnd - pos);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <document.cpp> <document_styles.cpp>\n", argv[0]);
+        return 1;
+    }
+
+    std::string out;
+    out += "// Generated by Src/tools/style_table_gen from document.cpp, do not edit.\n\n";
+    out += "#include <stdint.h>\n\n";
+    out += "#include \"eez-framework-conf.h\"\n\n";
+    out += "#if OPTION_STYLE_TABLE\n\n";
+    out += "#include \"style_table.h\"\n\n";
+    out += "namespace eez {\nnamespace gui {\nnamespace style_table {\n\n";
+
+    assets_file::Platform platforms[] = { assets_file::PLATFORM_STM32, assets_file::PLATFORM_SIMULATOR };
+    for (int i = 0; i < 2; i++) {
+        auto platform = platforms[i];
+
+        std::vector<uint8_t> compressed;
+        if (!assets_file::readDocument(argv[1], platform, compressed)) {
+            return 1;
+        }
+
+        Assets assets;
+        assets_file::Header header;
+        if (!assets_file::decompress(compressed, header, assets.data)) {
+            return 1;
+        }
+
+        std::map<uint32_t, std::string> names;
+        readStyleNames(argv[1], platform, names);
+
+        uint32_t numStyles = assets.listCount(12);
+        uint32_t numThemes = assets.listCount(assets.ptr(36));
+
+        char line[256];
+        out += i == 0 ? "#if defined(EEZ_PLATFORM_STM32)\n\n" : "#elif defined(EEZ_PLATFORM_SIMULATOR)\n\n";
+        snprintf(line, sizeof(line), "extern const uint32_t g_numThemes = %u;\n", numThemes);
+        out += line;
+        snprintf(line, sizeof(line), "extern const uint32_t g_numStyles = %u;\n\n", numStyles);
+        out += line;
+        out += "// colors, flags, backgroundImage, borderSize, borderRadius, font, opacity,\n";
+        out += "// transparent, reserved, padding\n";
+        snprintf(line, sizeof(line), "const FlatStyle g_flatStyles[%u] = {\n", numThemes * numStyles);
+        out += line;
+
+        for (uint32_t themeIndex = 0; themeIndex < numThemes; themeIndex++) {
+            uint32_t theme = assets.listItem(assets.ptr(36), themeIndex);
+            snprintf(line, sizeof(line), "    // theme %s\n", (const char *)assets.data.data() + assets.ptr(theme));
+            out += line;
+
+            for (uint32_t styleIndex = 0; styleIndex < numStyles; styleIndex++) {
+                ResolvedStyle resolved;
+                resolveStyle(assets, assets.listItem(12, styleIndex), themeIndex, resolved);
+
+                out += formatStyle(resolved, platform);
+                out += themeIndex + 1 < numThemes || styleIndex + 1 < numStyles ? ", // " : "  // ";
+                auto it = names.find(styleIndex + 1);
+                out += it != names.end() ? it->second : std::to_string(styleIndex + 1);
+                out += "\n";
+            }
+        }
+        out += "};\n\n";
+
+        // 7 colors, 24 bytes of the rest
+        uint32_t flatStyleSize = 7 * (platform == assets_file::PLATFORM_STM32 ? 2 : 4) + 24;
+        printf("%-10s %u themes x %u styles, table %u bytes\n",
+            assets_file::getPlatformName(platform), numThemes, numStyles, numThemes * numStyles * flatStyleSize);
+
+        if (platform != assets_file::PLATFORM_SIMULATOR) {
+            continue;
+        }
+
+        // lookup time, tools are built for the simulator so native color
+        // is ARGB8888
+
+        std::vector<style_table::FlatStyle> table(numThemes * numStyles);
+        for (uint32_t themeIndex = 0; themeIndex < numThemes; themeIndex++) {
+            for (uint32_t styleIndex = 0; styleIndex < numStyles; styleIndex++) {
+                ResolvedStyle resolved;
+                resolveStyle(assets, assets.listItem(12, styleIndex), themeIndex, resolved);
+                toFlatStyle(resolved, table[themeIndex * numStyles + styleIndex]);
+            }
+        }
+
+        static const int NUM_LOOKUPS = 10000000;
+        std::vector<uint16_t> styleIds(4096);
+        srand(1);
+        for (auto &styleId : styleIds) {
+            styleId = (uint16_t)(1 + rand() % numStyles);
+        }
+
+        uint32_t checksum1 = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int j = 0; j < NUM_LOOKUPS; j++) {
+            // style list, style, color index, colors, theme list, theme, theme colors
+            uint32_t style = assets.listItem(12, styleIds[j & 4095] - 1);
+            uint16_t index = assets.u16(style + 2);
+            uint16_t color16 = 0; // transparent and unknown, as resolveStyle() does
+            if (index != COLOR_ID_TRANSPARENT) {
+                assets.getColor(0, index, color16);
+            }
+            checksum1 += pixel_format::Argb8888::fromColor16(color16);
+        }
+        double assetsTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / NUM_LOOKUPS;
+
+        uint32_t checksum2 = 0;
+        start = std::chrono::steady_clock::now();
+        for (int j = 0; j < NUM_LOOKUPS; j++) {
+            checksum2 += table[styleIds[j & 4095] - 1].backgroundColor;
+        }
+        double tableTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / NUM_LOOKUPS;
+
+        printf("background color lookup: through assets %.2f ns, table %.2f ns, %s\n",
+            assetsTime, tableTime, checksum1 == checksum2 ? "same colors" : "DIFFERENT colors");
+        if (checksum1 != checksum2) {
+            return 1;
+        }
+    }
+
+    out += "#endif\n\n";
+    out += "} // namespace style_table\n} // namespace gui\n} // namespace eez\n\n";
+    out += "#endif // OPTION_STYLE_TABLE\n";
+
+    return assets_file::writeFile(argv[2], out.data(), out.size()) ? 0 : 1;
+}
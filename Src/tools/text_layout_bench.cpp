@@ -0,0 +1,372 @@
+// Draw time of multiline texts (toast messages from gui/action.cpp and a
+// longer paragraph) with gui/text_layout_cache.cpp against measuring and
+// word wrapping them on every draw, with real fonts from the assets[]
+// array in gui/document.cpp:
+//
+//   text_layout_bench ../../gui/document.cpp [stm32|simulator] [frames]
+//
+// Frames drawn from cached layouts are compared with frames drawn by the
+// reference wrapping, also while one text changes every frame and while
+// more texts are drawn than the cache holds.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "eez-framework-conf.h"
+#include "gui/text_layout_cache.h"
+
+#include "assets_file.h"
+
+using namespace eez::gui;
+
+static std::vector<uint8_t> g_data;
+
+static uint32_t u32(uint32_t offset) {
+    uint32_t value;
+    memcpy(&value, g_data.data() + offset, 4);
+    return value;
+}
+
+static uint32_t ptr(uint32_t offset) {
+    uint32_t value = u32(offset);
+    return value ? offset + value : 0;
+}
+
+static uint32_t listItem(uint32_t offset, uint32_t index) {
+    return ptr(ptr(offset + 4) + 4 * index);
+}
+
+// fonts list at +20 of the assets root
+static const uint8_t *getFont(uint32_t fontId) {
+    if (fontId == 0 || fontId > u32(20)) {
+        return nullptr;
+    }
+    return g_data.data() + listItem(20, fontId - 1);
+}
+
+// FontData: ascent, descent, reserved[2], encodingStart, encodingEnd,
+// groups, glyphs; GlyphsGroup: encoding, glyphIndex, length
+static bool loadGlyph(const void *fontData, int encoding, text_layout_cache::Glyph &glyph) {
+    uint32_t font = (uint32_t)((const uint8_t *)fontData - g_data.data());
+    for (uint32_t i = 0; i < u32(font + 12); i++) {
+        uint32_t group = listItem(font + 12, i);
+        int groupEncoding = (int)u32(group);
+        if (encoding >= groupEncoding && encoding < groupEncoding + (int)u32(group + 8)) {
+            uint32_t offset = listItem(font + 20, u32(group + 4) + encoding - groupEncoding);
+            if (!offset) {
+                return false;
+            }
+            // GlyphData: dx, width, height, x, y, reserved[3], A8 pixels
+            auto p = g_data.data() + offset;
+            glyph.dx = (int8_t)p[0];
+            glyph.width = p[1];
+            glyph.height = p[2];
+            glyph.x = (int8_t)p[3];
+            glyph.y = (int8_t)p[4];
+            glyph.pixels = p + 8;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct Text {
+    std::string text;
+    int x;
+    int y;
+    int width;
+    int align;
+};
+
+static const int CLIP_X1 = 0;
+static const int CLIP_Y1 = 0;
+static const int CLIP_X2 = DISPLAY_WIDTH - 1;
+static const int CLIP_Y2 = DISPLAY_HEIGHT - 1;
+
+// Reference glyphs come from the same loadGlyph, so the difference is only
+// measuring and wrapping.
+static void drawGlyph(std::vector<uint16_t> &buffer, const void *fontData, int ascent, int encoding, int x, int y) {
+    text_layout_cache::Glyph glyph;
+    if (!loadGlyph(fontData, encoding, glyph)) {
+        return;
+    }
+
+    int xGlyph = x + glyph.x;
+    int yGlyph = y + ascent - (glyph.y + glyph.height);
+
+    int x1 = xGlyph > CLIP_X1 ? xGlyph : CLIP_X1;
+    int y1 = yGlyph > CLIP_Y1 ? yGlyph : CLIP_Y1;
+    int x2 = xGlyph + glyph.width - 1 < CLIP_X2 ? xGlyph + glyph.width - 1 : CLIP_X2;
+    int y2 = yGlyph + glyph.height - 1 < CLIP_Y2 ? yGlyph + glyph.height - 1 : CLIP_Y2;
+
+    if (x1 <= x2 && y1 <= y2) {
+        pixel_format::drawMask<pixel_format::Rgb565>(buffer.data() + y1 * DISPLAY_WIDTH + x1, DISPLAY_WIDTH,
+            glyph.pixels + (y1 - yGlyph) * glyph.width + (x1 - xGlyph), glyph.width,
+            x2 - x1 + 1, y2 - y1 + 1, 0xFFFF, 255);
+    }
+}
+
+static int getAdvance(const void *fontData, int encoding) {
+    text_layout_cache::Glyph glyph;
+    return loadGlyph(fontData, encoding, glyph) ? glyph.dx : 0;
+}
+
+// Reference: word wrapping as MultilineTextWidget does it on every draw,
+// whole words are measured and moved to the next line when they don't fit,
+// a word wider than the line is broken between glyphs.
+struct Placed {
+    int encoding;
+    int x;
+};
+
+struct Wrapped {
+    std::vector<std::vector<Placed>> lines;
+    std::vector<int> widths;
+};
+
+static void wrapText(const void *fontData, const Text &text, Wrapped &wrapped) {
+    auto &lines = wrapped.lines;
+    auto &widths = wrapped.widths;
+    lines.assign(1, {});
+    widths.assign(1, 0);
+
+    int spaceAdvance = getAdvance(fontData, ' ');
+    size_t i = 0;
+    while (i <= text.text.size()) {
+        size_t end = text.text.find_first_of(" \n", i);
+        if (end == std::string::npos) {
+            end = text.text.size();
+        }
+
+        const char *str = text.text.c_str();
+
+        int wordWidth = 0;
+        for (int j = (int)i; j < (int)end;) {
+            wordWidth += getAdvance(fontData, text_layout_cache::decodeUtf8(str, (int)end, j));
+        }
+
+        int &x = widths.back();
+        if (!lines.back().empty() && x + spaceAdvance + wordWidth > text.width) {
+            lines.emplace_back();
+            widths.push_back(0);
+        } else if (!lines.back().empty() || x > 0) {
+            x += spaceAdvance;
+        }
+
+        for (int j = (int)i; j < (int)end;) {
+            int encoding = text_layout_cache::decodeUtf8(str, (int)end, j);
+            int advance = getAdvance(fontData, encoding);
+            if (widths.back() + advance > text.width && !lines.back().empty()) {
+                lines.emplace_back();
+                widths.push_back(0);
+            }
+            lines.back().push_back({ encoding, widths.back() });
+            widths.back() += advance;
+        }
+
+        if (end < text.text.size() && text.text[end] == '\n') {
+            lines.emplace_back();
+            widths.push_back(0);
+        }
+        i = end + 1;
+    }
+}
+
+static void drawWrapped(std::vector<uint16_t> &buffer, const void *fontData, int ascent, int lineHeight, const Text &text) {
+    Wrapped wrapped;
+    wrapText(fontData, text, wrapped);
+    auto &lines = wrapped.lines;
+    auto &widths = wrapped.widths;
+
+    for (size_t line = 0; line < lines.size(); line++) {
+        int x = text.x;
+        if (text.align == text_layout_cache::ALIGN_CENTER) {
+            x += (text.width - widths[line]) / 2;
+        } else if (text.align == text_layout_cache::ALIGN_RIGHT) {
+            x += text.width - widths[line];
+        }
+        for (auto &placed : lines[line]) {
+            drawGlyph(buffer, fontData, ascent, placed.encoding, x + placed.x, text.y + (int)line * lineHeight);
+        }
+    }
+}
+
+static void drawCached(std::vector<uint16_t> &buffer, const void *fontData, int ascent, int lineHeight, const Text &text) {
+    auto layout = text_layout_cache::getLayout(fontData, loadGlyph, text.text.c_str(), (int)text.text.size(), text.width, lineHeight);
+    if (layout) {
+        text_layout_cache::drawLayout<pixel_format::Rgb565>(buffer.data(), DISPLAY_WIDTH, CLIP_X1, CLIP_Y1, CLIP_X2, CLIP_Y2,
+            fontData, loadGlyph, ascent, *layout, text.align, text.width, text.x, text.y, 0xFFFF, 255);
+    }
+}
+
+static void getFrameTexts(uint32_t frame, bool changing, std::vector<Text> &texts) {
+    texts.clear();
+    texts.push_back({ "This is info message\nWith line 2!", 20, 20, 360, text_layout_cache::ALIGN_CENTER });
+    texts.push_back({ "This is error message\nWith line 2 ...\nand line 3!", 20, 120, 360, text_layout_cache::ALIGN_CENTER });
+    texts.push_back({ "Some error occured!\nYou should fix it.", 20, 260, 360, text_layout_cache::ALIGN_LEFT });
+    texts.push_back({ "It\u2019s 24.5 \u00B0C\u2026 measured in 20 \u00B5s at 10 k\u03A9", 20, 360, 360, text_layout_cache::ALIGN_LEFT });
+    texts.push_back({ "Multiline text is measured and word wrapped to the width of the widget, "
+        "with a line break where a word doesn't fit anymore and in the middle of "
+        "averyveryveryveryveryverylongword that is wider than the widget.", 420, 20, 300, text_layout_cache::ALIGN_LEFT });
+    if (changing) {
+        char text[64];
+        snprintf(text, sizeof(text), "Elapsed time\n%u.%02u s", frame / 60, frame % 60 * 100 / 60);
+        texts.push_back({ text, 420, 360, 200, text_layout_cache::ALIGN_RIGHT });
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <document.cpp> [stm32|simulator] [frames]\n", argv[0]);
+        return 1;
+    }
+
+    auto platform = argc > 2 && strcmp(argv[2], "simulator") == 0 ? assets_file::PLATFORM_SIMULATOR : assets_file::PLATFORM_STM32;
+    uint32_t numFrames = argc > 3 ? (uint32_t)atoi(argv[3]) : 3600;
+
+    std::vector<uint8_t> compressed;
+    if (!assets_file::readDocument(argv[1], platform, compressed)) {
+        return 1;
+    }
+    assets_file::Header header;
+    if (!assets_file::decompress(compressed, header, g_data)) {
+        return 1;
+    }
+
+    // FONT_ID_TEXT_M = 1 in document.h
+    const uint8_t *font = getFont(1);
+    if (!font) {
+        fprintf(stderr, "font not found\n");
+        return 1;
+    }
+    int ascent = font[0];
+    int lineHeight = font[0] + font[1];
+
+    bool ok = true;
+
+    for (int changing = 0; changing < 2; changing++) {
+        text_layout_cache::clear();
+        text_layout_cache::resetStats();
+
+        std::vector<uint16_t> cached(DISPLAY_WIDTH * DISPLAY_HEIGHT);
+        std::vector<uint16_t> wrapped(DISPLAY_WIDTH * DISPLAY_HEIGHT);
+        std::vector<Text> texts;
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < numFrames; frame++) {
+            getFrameTexts(frame, changing, texts);
+            for (auto &text : texts) {
+                drawCached(cached, font, ascent, lineHeight, text);
+            }
+        }
+        double cachedTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < numFrames; frame++) {
+            getFrameTexts(frame, changing, texts);
+            for (auto &text : texts) {
+                drawWrapped(wrapped, font, ascent, lineHeight, text);
+            }
+        }
+        double wrappedTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        // measuring and wrapping alone, without drawing
+        start = std::chrono::steady_clock::now();
+        uint32_t numLines = 0;
+        for (uint32_t frame = 0; frame < numFrames; frame++) {
+            getFrameTexts(frame, changing, texts);
+            for (auto &text : texts) {
+                auto layout = text_layout_cache::getLayout(font, loadGlyph, text.text.c_str(), (int)text.text.size(), text.width, lineHeight);
+                numLines += layout ? layout->numLines : 0;
+            }
+        }
+        double cachedLayoutTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        uint32_t numWrappedLines = 0;
+        for (uint32_t frame = 0; frame < numFrames; frame++) {
+            getFrameTexts(frame, changing, texts);
+            for (auto &text : texts) {
+                Wrapped wrapped;
+                wrapText(font, text, wrapped);
+                numWrappedLines += (uint32_t)wrapped.lines.size();
+            }
+        }
+        double wrapTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        // same texts were drawn over each other in the same order, then a
+        // few frames again from scratch
+        bool identical = cached == wrapped;
+        for (uint32_t frame = 0; frame < numFrames; frame += 599) {
+            getFrameTexts(frame, changing, texts);
+            std::fill(cached.begin(), cached.end(), 0);
+            std::fill(wrapped.begin(), wrapped.end(), 0);
+            for (auto &text : texts) {
+                drawCached(cached, font, ascent, lineHeight, text);
+                drawWrapped(wrapped, font, ascent, lineHeight, text);
+            }
+            identical = identical && cached == wrapped;
+        }
+
+        auto stats = text_layout_cache::g_stats;
+        printf("%s, %u frames, %s: hit rate %.2f%%, %u not kept, %u evictions, %u layouts in %u of %u bytes\n",
+            assets_file::getPlatformName(platform), numFrames, changing ? "one text changes every frame" : "unchanged texts",
+            text_layout_cache::getHitRate(), stats.transient, stats.evictions, stats.numLayouts, stats.usedBytes, TEXT_LAYOUT_CACHE_SIZE);
+        printf("    host time per frame: cached layout %.2f us, wrapped on draw %.2f us, frames %s\n",
+            cachedTime / numFrames, wrappedTime / numFrames, identical ? "identical" : "DIFFERENT");
+        printf("    layout only: cache lookup %.2f us, measure and wrap %.2f us\n",
+            cachedLayoutTime / numFrames, wrapTime / numFrames);
+        identical = identical && numLines == numWrappedLines;
+
+        ok = ok && identical && stats.usedBytes <= TEXT_LAYOUT_CACHE_SIZE;
+        // changing text is laid out on every draw and doesn't evict the
+        // layouts of the others
+        if (changing && (stats.transient < numFrames || stats.evictions > 0)) {
+            ok = false;
+        }
+    }
+
+    // more texts than entries, each drawn twice so it is kept
+    text_layout_cache::clear();
+    text_layout_cache::resetStats();
+    bool identical = true;
+    for (uint32_t i = 0; i < 4 * TEXT_LAYOUT_CACHE_MAX_ENTRIES; i++) {
+        char text[64];
+        snprintf(text, sizeof(text), "Message number %u\nwith the second line", i);
+        Text item = { text, 20, 20, 160 + (int)(i % 5) * 20, (int)(i % 3) };
+        for (int pass = 0; pass < 2; pass++) {
+            std::vector<uint16_t> cached(DISPLAY_WIDTH * DISPLAY_HEIGHT);
+            std::vector<uint16_t> wrapped(DISPLAY_WIDTH * DISPLAY_HEIGHT);
+            drawCached(cached, font, ascent, lineHeight, item);
+            drawWrapped(wrapped, font, ascent, lineHeight, item);
+            identical = identical && cached == wrapped;
+        }
+    }
+    auto stats = text_layout_cache::g_stats;
+    printf("%u texts twice: %u kept, %u evictions, frames %s\n", 4 * TEXT_LAYOUT_CACHE_MAX_ENTRIES,
+        stats.misses - stats.transient, stats.evictions, identical ? "identical" : "DIFFERENT");
+    ok = ok && identical && stats.evictions > 0 && stats.usedBytes <= TEXT_LAYOUT_CACHE_SIZE;
+
+    // multi-byte characters are one encoding each, not one per byte
+    const char *utf8 = "\u00B0\u00B5\u03A9\u2019\u2026";
+    static const int expected[] = { 0xB0, 0xB5, 0x3A9, 0x2019, 0x2026 };
+    int utf8Length = (int)strlen(utf8);
+    int numDecoded = 0;
+    bool decoded = true;
+    for (int i = 0; i < utf8Length;) {
+        int encoding = text_layout_cache::decodeUtf8(utf8, utf8Length, i);
+        decoded = decoded && numDecoded < 5 && encoding == expected[numDecoded];
+        numDecoded++;
+    }
+    decoded = decoded && numDecoded == 5;
+    printf("UTF-8 decoding %s\n", decoded ? "OK" : "FAILED");
+    ok = ok && decoded;
+
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,370 @@
+// flow/tick_budget on a modeled flow queue loop, in the GUI thread which
+// draws a frame every 16 ms:
+//
+//   tick_budget_bench [seconds]
+//
+// Like flow::tick() of eez-framework, the queue runs empty on every tick
+// and the components are timed and deferred as the registerComponent()
+// wrappers of flow/hooks.cpp do it, with an execution state slot per
+// component. The modeled flow has a LoopActionComponent of 50000
+// iterations started every second, each iteration a loop and a body task
+// of a few us, an EvalExprActionComponent which takes 6 ms every 500 ms, a
+// burst of 100 SetVariableActionComponent of 50 us every 700 ms and a
+// cheap WatchVariableActionComponent executed on every tick outside of the
+// queue.
+//
+// Every loop iteration and every component of a burst must execute
+// exactly once and in order, every execution of the slow component must
+// be reported as an overrun, and a frame without the slow component may
+// go over budget only by the component which spent it and the loop, which
+// runs anyway between iterations. A frame over that because the host
+// preempted the bench is printed but isn't an error.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <deque>
+
+#include "eez-framework-conf.h"
+
+#undef OPTION_FLOW_TICK_BUDGET
+#define OPTION_FLOW_TICK_BUDGET 1
+
+#include "flow/tick_budget.cpp"
+
+using namespace eez::flow;
+using namespace eez::flow::tick_budget;
+
+typedef std::chrono::steady_clock Clock;
+
+enum ComponentType {
+    COMPONENT_TYPE_WATCH_VARIABLE_ACTION = 1,
+    COMPONENT_TYPE_EVAL_EXPR_ACTION,
+    COMPONENT_TYPE_LOOP_ACTION,
+    COMPONENT_TYPE_SET_VARIABLE_ACTION
+};
+
+namespace eez {
+namespace flow {
+
+const char *getComponentTypeName(uint16_t componentType) {
+    switch (componentType) {
+    case COMPONENT_TYPE_WATCH_VARIABLE_ACTION: return "WatchVariableActionComponent";
+    case COMPONENT_TYPE_EVAL_EXPR_ACTION: return "EvalExprActionComponent";
+    case COMPONENT_TYPE_LOOP_ACTION: return "LoopActionComponent";
+    case COMPONENT_TYPE_SET_VARIABLE_ACTION: return "SetVariableActionComponent";
+    default: return nullptr;
+    }
+}
+
+} // namespace flow
+} // namespace eez
+
+static const uint32_t FRAME_PERIOD_MS = 16;
+static const uint32_t RENDER_MS = 2;
+static const uint32_t LOOP_ITERATIONS = 50000;
+static const uint32_t LOOP_PERIOD_MS = 1000;
+static const uint32_t SLOW_MS = 6;
+static const uint32_t SLOW_PERIOD_MS = 500;
+static const uint32_t BURST_SIZE = 100;
+static const uint32_t BURST_US = 50;
+static const uint32_t BURST_PERIOD_MS = 700;
+
+// component indexes in flow 0
+enum {
+    WATCH,
+    EVAL_EXPR,
+    LOOP,
+    LOOP_BODY,
+    BURST,
+    NUM_COMPONENTS = BURST + BURST_SIZE
+};
+
+// execution state slot of a component
+struct Slot {
+    bool isLoopRunning;
+    uint32_t iteration; // of the loop
+    uint32_t numDeferred; // executions, 0 if not deferred
+};
+
+static Slot g_slots[NUM_COMPONENTS];
+static std::deque<uint16_t> g_queue;
+static std::deque<uint16_t> g_deferred;
+
+static uint32_t g_numLoops;
+static uint32_t g_numBodies; // of the running loop
+static uint32_t g_numSlow;
+static uint32_t g_numBursts;
+static uint32_t g_nextBurst; // component of the burst expected next
+static uint32_t g_numErrors;
+static volatile uint32_t g_sink;
+
+static double g_measuredTime;   // us, of the frame as measured here
+static double g_spentTime;      // us, of components started when spent
+static double g_longestTime;    // us, of a component in the frame
+
+static void busyWait(double us) {
+    auto end = Clock::now() + std::chrono::duration<double, std::micro>(us);
+    while (Clock::now() < end) {
+        g_sink++;
+    }
+}
+
+static void error(const char *message, uint32_t a, uint32_t b) {
+    if (g_numErrors++ < 10) {
+        printf(message, a, b);
+    }
+}
+
+static void addToQueue(uint16_t componentIndex) {
+    g_queue.push_back(componentIndex);
+}
+
+static uint16_t getComponentType(uint16_t componentIndex) {
+    switch (componentIndex) {
+    case WATCH: return COMPONENT_TYPE_WATCH_VARIABLE_ACTION;
+    case EVAL_EXPR: return COMPONENT_TYPE_EVAL_EXPR_ACTION;
+    case LOOP: return COMPONENT_TYPE_LOOP_ACTION;
+    default: return COMPONENT_TYPE_SET_VARIABLE_ACTION;
+    }
+}
+
+static void executeComponent(uint16_t componentIndex) {
+    switch (componentIndex) {
+    case WATCH:
+        busyWait(5);
+        break;
+    case EVAL_EXPR:
+        busyWait(SLOW_MS * 1000);
+        g_numSlow++;
+        break;
+    case LOOP: {
+        // started, or next from the body
+        Slot &slot = g_slots[LOOP];
+        busyWait(1);
+        if (!slot.isLoopRunning) {
+            slot.isLoopRunning = true;
+            slot.iteration = 0;
+            g_numBodies = 0;
+        } else {
+            slot.iteration++;
+        }
+        if (slot.iteration < LOOP_ITERATIONS) {
+            addToQueue(LOOP_BODY);
+        } else {
+            slot.isLoopRunning = false;
+            g_numLoops++;
+        }
+        break;
+    }
+    case LOOP_BODY:
+        busyWait(1);
+        if (g_numBodies++ != g_slots[LOOP].iteration) {
+            error("loop body executed %u times in iteration %u\n", g_numBodies, g_slots[LOOP].iteration);
+        }
+        addToQueue(LOOP);
+        break;
+    default:
+        busyWait(BURST_US);
+        if ((uint32_t)(componentIndex - BURST) != g_nextBurst) {
+            error("burst component %u executed, %u expected\n", componentIndex - BURST, g_nextBurst);
+        }
+        g_nextBurst = (componentIndex - BURST + 1) % BURST_SIZE;
+        if (g_nextBurst == 0) {
+            g_numBursts++;
+        }
+        break;
+    }
+}
+
+// deferComponent() of flow/hooks.cpp
+static bool deferComponent(uint16_t componentIndex) {
+    Slot &slot = g_slots[componentIndex];
+    if (slot.numDeferred) {
+        slot.numDeferred++;
+        componentDeferred();
+        return true;
+    }
+    if (slot.isLoopRunning || componentIndex == WATCH || !isSpent()) {
+        return false;
+    }
+    if (g_deferred.size() == FLOW_TICK_BUDGET_MAX_DEFERRED) {
+        componentNotDeferred();
+        return false;
+    }
+    slot.numDeferred = 1;
+    g_deferred.push_back(componentIndex);
+    componentDeferred();
+    return true;
+}
+
+// executeTimedComponent() of flow/hooks.cpp
+static void executeTimedComponent(uint16_t componentIndex) {
+    if (deferComponent(componentIndex)) {
+        return;
+    }
+
+    bool isSpentBefore = isSpent();
+    auto start = Clock::now();
+    tick_budget::componentStarted(0, componentIndex, getComponentType(componentIndex));
+    executeComponent(componentIndex);
+    tick_budget::componentFinished();
+    double time = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    g_measuredTime += time;
+    if (isSpentBefore) {
+        g_spentTime += time;
+    } else if (time > g_longestTime) {
+        g_longestTime = time;
+    }
+}
+
+// of flow/hooks.cpp
+void eez::flow::resumeDeferredComponents() {
+    while (!g_deferred.empty()) {
+        uint16_t componentIndex = g_deferred.front();
+        g_deferred.pop_front();
+        for (uint32_t i = 0; i < g_slots[componentIndex].numDeferred; i++) {
+            addToQueue(componentIndex);
+        }
+        g_slots[componentIndex].numDeferred = 0;
+    }
+}
+
+// flow::tick() of eez-framework
+static void flowTick() {
+    executeTimedComponent(WATCH);
+    while (!g_queue.empty()) {
+        uint16_t componentIndex = g_queue.front();
+        g_queue.pop_front();
+        executeTimedComponent(componentIndex);
+    }
+}
+
+int main(int argc, char **argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 3;
+    if (seconds <= 0) {
+        seconds = 3;
+    }
+
+    printf("%u ms frames, loop of %u iterations every %u ms, %u ms component every %u ms, %u x %u us every %u ms, %.1f s:\n",
+        FRAME_PERIOD_MS, LOOP_ITERATIONS, LOOP_PERIOD_MS, SLOW_MS, SLOW_PERIOD_MS, BURST_SIZE, BURST_US, BURST_PERIOD_MS, seconds);
+
+    g_budgetTicks = microsecondsToTicks(FLOW_TICK_BUDGET_US);
+
+    uint32_t numLoopsStarted = 0;
+    uint32_t numSlowStarted = 0;
+    uint32_t numBurstsStarted = 0;
+    uint32_t numPreempted = 0;
+    double maxFrameTime = 0; // without the slow component
+    uint32_t maxFrames = 0;  // of a loop
+    uint32_t loopFrames = 0;
+
+    auto start = Clock::now();
+    double nextLoop = 100;
+    double nextSlow = 250;
+    double nextBurst = 400;
+    bool isStopping = false;
+    for (uint32_t frame = 1;; frame++) {
+        double now = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (now >= seconds * 1000) {
+            // no new work, until everything left is done
+            isStopping = true;
+            if (g_queue.empty() && g_deferred.empty() && !g_slots[LOOP].isLoopRunning) {
+                break;
+            }
+        }
+
+        // the loop is started or running
+        bool isLoop = g_numLoops != numLoopsStarted;
+        if (!isStopping) {
+            if (now >= nextLoop && !isLoop) {
+                addToQueue(LOOP);
+                nextLoop += LOOP_PERIOD_MS;
+                numLoopsStarted++;
+                loopFrames = 0;
+                isLoop = true;
+            }
+            if (now >= nextSlow) {
+                addToQueue(EVAL_EXPR);
+                nextSlow += SLOW_PERIOD_MS;
+                numSlowStarted++;
+            }
+            if (now >= nextBurst) {
+                for (uint16_t i = 0; i < BURST_SIZE; i++) {
+                    addToQueue(BURST + i);
+                }
+                nextBurst += BURST_PERIOD_MS;
+                numBurstsStarted++;
+            }
+        }
+
+        g_measuredTime = 0;
+        g_spentTime = 0;
+        g_longestTime = 0;
+        uint32_t numSlow = g_numSlow;
+
+        flowTick();
+
+        if (isLoop && ++loopFrames > maxFrames) {
+            maxFrames = loopFrames;
+        }
+        if (g_numSlow == numSlow) {
+            if (g_measuredTime > maxFrameTime) {
+                maxFrameTime = g_measuredTime;
+            }
+            // the component which spent the budget, and the loop between
+            // iterations, 1 us and the timing each, with some margin for
+            // the timing here
+            if (g_measuredTime - g_longestTime - g_spentTime > FLOW_TICK_BUDGET_US + 500 || g_spentTime > 100) {
+                numPreempted++;
+            }
+        }
+
+        tick_budget::tick();
+        resumeDeferredComponents();
+        busyWait(RENDER_MS * 1000);
+
+        auto next = start + std::chrono::milliseconds(frame * FRAME_PERIOD_MS);
+        while (Clock::now() < next) {
+        }
+    }
+
+    printf("  %u frames, %u over budget, longest %.1f ms, %.1f ms without the slow component\n",
+        g_stats.numFrames, g_stats.numOverBudget, g_stats.maxFrameTime / 1000.0, maxFrameTime / 1000.0);
+    printf("  %u loops done in up to %u frames, %u slow components, %u bursts, %u deferred, %u not deferred\n",
+        g_numLoops, maxFrames, g_numSlow, g_numBursts, g_stats.numDeferred, g_stats.numNotDeferred);
+
+    if (g_numLoops != numLoopsStarted || g_numSlow != numSlowStarted || g_numBursts != numBurstsStarted) {
+        g_numErrors++;
+        printf("%u loops, %u slow components and %u bursts done, %u, %u and %u started\n",
+            g_numLoops, g_numSlow, g_numBursts, numLoopsStarted, numSlowStarted, numBurstsStarted);
+    }
+
+    uint32_t numSlowOverruns = 0;
+    for (uint32_t i = 0; i < g_numOverruns; i++) {
+        if (g_overruns[i].componentIndex == EVAL_EXPR && g_overruns[i].maxTime >= SLOW_MS * 1000) {
+            numSlowOverruns = g_overruns[i].numOverruns;
+        }
+    }
+    if (numSlowOverruns != g_numSlow) {
+        g_numErrors++;
+        printf("slow component reported %u times, executed %u times\n", numSlowOverruns, g_numSlow);
+    }
+
+    if (g_stats.numDeferred == 0) {
+        g_numErrors++;
+        printf("nothing deferred\n");
+    }
+
+    if (numPreempted) {
+        printf("  %u frames over budget by more than a component, the host preempted the bench\n", numPreempted);
+    }
+
+    printf("\n");
+    dump(stdoutWrite); // of flow/tick_budget.cpp
+
+    printf("\n%s\n", g_numErrors == 0 ? "OK" : "FAILED");
+    return g_numErrors == 0 ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+// Delays of the flow on flow/timer_wheel against checking every waiting
+// component on every tick, as eez-flow does without the wheel:
+//
+//   timer_wheel_bench [delays] [seconds]
+//
+// Every delay starts again with a random duration when it expires, as a
+// Delay component in a loop, so the number of concurrent delays stays the
+// same. Durations are mostly up to 2 s, some up to an hour and a few over
+// the 2^24 ms range of the wheel. Time advances in random steps like
+// frames, with an occasional long pause, and delays are randomly stopped
+// and started again. Every delay must expire in the first advance() at or
+// after its deadline. A frame timer started again for the next millisecond
+// when it expires, as Animate does, must expire in every advance().
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "eez-framework-conf.h"
+
+#undef OPTION_FLOW_TIMER_WHEEL
+#define OPTION_FLOW_TIMER_WHEEL 1
+
+#include "flow/timer_wheel.cpp"
+
+using namespace eez::flow;
+
+struct Delay {
+    timer_wheel::Timer timer;
+    uint32_t deadline;
+    bool isStarted;
+};
+
+static std::mt19937 g_random(1);
+
+static std::vector<Delay> g_delays;
+static uint32_t g_now;      // of the advance() being called
+static uint32_t g_lastNow;  // of the previous one
+static uint32_t g_numErrors;
+
+static timer_wheel::Timer g_frameTimer;
+static uint32_t g_numFrames;
+
+static uint32_t randomDuration() {
+    uint32_t kind = g_random() % 1000;
+    if (kind < 950) {
+        return 1 + g_random() % 2000;
+    }
+    if (kind < 998) {
+        return 1 + g_random() % 3600000;
+    }
+    return (1u << 24) + g_random() % (1u << 26);
+}
+
+static void startDelay(Delay &delay);
+
+static void onExpired(void *param) {
+    Delay &delay = *(Delay *)param;
+    if (!delay.isStarted || (int32_t)(g_now - delay.deadline) < 0 || (int32_t)(g_lastNow - delay.deadline) >= 0) {
+        if (g_numErrors++ < 10) {
+            printf("delay %u expired at %u, deadline %u, previous advance %u\n",
+                (unsigned)(&delay - g_delays.data()), g_now, delay.deadline, g_lastNow);
+        }
+    }
+    delay.isStarted = false;
+    startDelay(delay);
+}
+
+static void startDelay(Delay &delay) {
+    delay.deadline = g_now + randomDuration();
+    delay.isStarted = true;
+    timer_wheel::start(delay.timer, delay.deadline, onExpired, &delay);
+}
+
+static void onFrame(void *) {
+    g_numFrames++;
+    timer_wheel::start(g_frameTimer, g_now + 1, onFrame, nullptr);
+}
+
+static void checkWheel(uint32_t numDelays) {
+    g_delays.assign(numDelays, Delay());
+    g_now = 1000;
+    g_lastNow = g_now;
+    timer_wheel::init(g_now);
+    for (auto &delay : g_delays) {
+        startDelay(delay);
+    }
+    timer_wheel::start(g_frameTimer, g_now + 1, onFrame, nullptr);
+
+    // 2^32 ms and more, so millis() wraps
+    uint32_t numAdvances = 0;
+    for (uint64_t elapsed = 0; elapsed < (1ull << 32) + 3600000; numAdvances++) {
+        uint32_t step = g_random() % 100 == 0 ? 60000 + g_random() % 600000 : 1 + g_random() % 40;
+        g_lastNow = g_now;
+        g_now += step;
+        elapsed += step;
+        timer_wheel::advance(g_now);
+
+        if (g_numFrames != numAdvances + 1) {
+            if (g_numErrors++ < 10) {
+                printf("%u frames in %u advances\n", g_numFrames, numAdvances + 1);
+            }
+            g_numFrames = numAdvances + 1;
+        }
+
+        for (int i = 0; i < 4; i++) {
+            Delay &delay = g_delays[g_random() % numDelays];
+            if (g_random() & 1) {
+                timer_wheel::stop(delay.timer);
+                delay.isStarted = false;
+            } else {
+                startDelay(delay);
+            }
+        }
+    }
+
+    // and the stopped ones again, nothing else may expire
+    for (auto &delay : g_delays) {
+        if (delay.isStarted) {
+            timer_wheel::stop(delay.timer);
+            delay.isStarted = false;
+        }
+    }
+    timer_wheel::stop(g_frameTimer);
+    if (timer_wheel::g_stats.numStarted != 0) {
+        g_numErrors++;
+        printf("%u timers started after all were stopped\n", timer_wheel::g_stats.numStarted);
+    }
+    printf("%u advances over %u days, %u expired, %u moved to a finer level\n", numAdvances,
+        (unsigned)(((1ull << 32) + 3600000) / 86400000), timer_wheel::g_stats.numExpired, timer_wheel::g_stats.numCascaded);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t g_sink;
+
+static void onBenchExpired(void *param) {
+    Delay &delay = *(Delay *)param;
+    delay.deadline = g_now + 100 + g_random() % 1900;
+    timer_wheel::start(delay.timer, delay.deadline, onBenchExpired, &delay);
+    g_sink++;
+}
+
+// frames of 1 ms, 10k delays of 0.1 to 2 s in a loop
+static double benchWheel(uint32_t numDelays, uint32_t numTicks) {
+    g_delays.assign(numDelays, Delay());
+    g_now = 0;
+    timer_wheel::init(g_now);
+    for (auto &delay : g_delays) {
+        delay.deadline = 100 + g_random() % 1900;
+        timer_wheel::start(delay.timer, delay.deadline, onBenchExpired, &delay);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t tick = 0; tick < numTicks; tick++) {
+        g_now++;
+        timer_wheel::advance(g_now);
+    }
+    double time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    for (auto &delay : g_delays) {
+        timer_wheel::stop(delay.timer);
+    }
+    return time;
+}
+
+static double benchPolling(uint32_t numDelays, uint32_t numTicks) {
+    g_delays.assign(numDelays, Delay());
+    for (auto &delay : g_delays) {
+        delay.deadline = 100 + g_random() % 1900;
+    }
+
+    g_now = 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t tick = 0; tick < numTicks; tick++) {
+        g_now++;
+        for (auto &delay : g_delays) {
+            if ((int32_t)(g_now - delay.deadline) >= 0) {
+                delay.deadline = g_now + 100 + g_random() % 1900;
+                g_sink++;
+            }
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static double benchStartStop(uint32_t numDelays) {
+    g_delays.assign(numDelays, Delay());
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < 10; i++) {
+        for (auto &delay : g_delays) {
+            timer_wheel::start(delay.timer, g_now + 1 + (g_sink++ * 2654435761u) % 3600000, onBenchExpired, &delay);
+        }
+        for (auto &delay : g_delays) {
+            timer_wheel::stop(delay.timer);
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() / (20.0 * numDelays);
+}
+
+int main(int argc, char **argv) {
+    uint32_t numDelays = argc > 1 ? (uint32_t)atoi(argv[1]) : 10000;
+    uint32_t seconds = argc > 2 ? (uint32_t)atoi(argv[2]) : 60;
+    if (numDelays == 0) {
+        numDelays = 1;
+    }
+
+    checkWheel(numDelays);
+
+    uint32_t numTicks = seconds * 1000;
+    double polling = benchPolling(numDelays, numTicks);
+    double wheel = benchWheel(numDelays, numTicks);
+    printf("%u delays, %u s of 1 ms ticks:\n", numDelays, seconds);
+    printf("  checked every tick: %8.2f us per tick\n", polling * 1e6 / numTicks);
+    printf("  timer wheel:        %8.2f us per tick, %.0fx\n", wheel * 1e6 / numTicks, polling / wheel);
+    printf("  start and stop:     %8.1f ns per call\n", benchStartStop(numDelays) * 1e9);
+
+    printf("\n%s\n", g_numErrors == 0 ? "OK" : "FAILED");
+    return g_numErrors == 0 ? 0 : 1;
+}